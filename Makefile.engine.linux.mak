@@ -0,0 +1,49 @@
+BUILD_DIR := bin
+OBJ_DIR := obj
+
+ASSEMBLY := engine
+EXTENSION := .so
+# Frame pointers keep perf and valgrind call stacks usable.
+COMPILER_FLAGS := -g -MD -Werror=vla -fdeclspec -fPIC -fno-omit-frame-pointer
+INCLUDE_FLAGS := -Iengine/src
+LINKER_FLAGS := -g -shared -lvulkan -lxcb -lm -lpthread
+DEFINES := -D_DEBUG -DKEXPORT
+
+# The system vulkan headers and loader are used unless an SDK is set.
+ifdef VULKAN_SDK
+INCLUDE_FLAGS += -I$(VULKAN_SDK)/include
+LINKER_FLAGS += -L$(VULKAN_SDK)/lib
+endif
+
+SRC_FILES := $(shell find $(ASSEMBLY) -name "*.c") # Get all .c files
+DIRECTORIES := $(shell find $(ASSEMBLY) -type d) # Get all directories under the assembly.
+OBJ_FILES := $(SRC_FILES:%=$(OBJ_DIR)/%.o) # Get all compiled .c.o objects for engine
+
+all: scaffold compile link
+
+.PHONY: scaffold
+scaffold: # create build directory
+	@echo Scaffolding folder structure...
+	@mkdir -p $(BUILD_DIR)
+	@mkdir -p $(addprefix $(OBJ_DIR)/,$(DIRECTORIES))
+	@echo Done.
+
+.PHONY: link
+link: scaffold $(OBJ_FILES) # link
+	@echo Linking $(ASSEMBLY)...
+	@clang $(OBJ_FILES) -o $(BUILD_DIR)/lib$(ASSEMBLY)$(EXTENSION) $(LINKER_FLAGS)
+
+.PHONY: compile
+compile: #compile .c files
+	@echo Compiling...
+
+.PHONY: clean
+clean: # clean build directory
+	rm -f $(BUILD_DIR)/lib$(ASSEMBLY)$(EXTENSION)
+	rm -rf $(OBJ_DIR)/$(ASSEMBLY)
+
+$(OBJ_DIR)/%.c.o: %.c # compile .c to .c.o object
+	@echo   $<...
+	@clang $< $(COMPILER_FLAGS) -c -o $@ $(DEFINES) $(INCLUDE_FLAGS)
+
+-include $(OBJ_FILES:.o=.d)
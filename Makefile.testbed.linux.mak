@@ -0,0 +1,42 @@
+BUILD_DIR := bin
+OBJ_DIR := obj
+
+ASSEMBLY := testbed
+EXTENSION :=
+COMPILER_FLAGS := -g -MD -Werror=vla -Wno-missing-braces -fdeclspec -fPIC -fno-omit-frame-pointer
+INCLUDE_FLAGS := -Iengine/src -Itestbed/src
+# rpath lets the executable find libengine.so next to it in bin.
+LINKER_FLAGS := -g -L./$(BUILD_DIR)/ -lengine -Wl,-rpath,'$$ORIGIN'
+DEFINES := -D_DEBUG -DKIMPORT
+
+SRC_FILES := $(shell find $(ASSEMBLY) -name "*.c") # Get all .c files
+DIRECTORIES := $(shell find $(ASSEMBLY) -type d) # Get all directories under the assembly.
+OBJ_FILES := $(SRC_FILES:%=$(OBJ_DIR)/%.o) # Get all compiled .c.o objects for testbed
+
+all: scaffold compile link
+
+.PHONY: scaffold
+scaffold: # create build directory
+	@echo Scaffolding folder structure...
+	@mkdir -p $(addprefix $(OBJ_DIR)/,$(DIRECTORIES))
+	@echo Done.
+
+.PHONY: link
+link: scaffold $(OBJ_FILES) # link
+	@echo Linking $(ASSEMBLY)...
+	@clang $(OBJ_FILES) -o $(BUILD_DIR)/$(ASSEMBLY)$(EXTENSION) $(LINKER_FLAGS)
+
+.PHONY: compile
+compile: #compile .c files
+	@echo Compiling...
+
+.PHONY: clean
+clean: # clean build directory
+	rm -f $(BUILD_DIR)/$(ASSEMBLY)$(EXTENSION)
+	rm -rf $(OBJ_DIR)/$(ASSEMBLY)
+
+$(OBJ_DIR)/%.c.o: %.c # compile .c to .c.o object
+	@echo   $<...
+	@clang $< $(COMPILER_FLAGS) -c -o $@ $(DEFINES) $(INCLUDE_FLAGS)
+
+-include $(OBJ_FILES:.o=.d)
@@ -3,11 +3,12 @@
 
 layout(location = 0) out vec4 out_colour;
 
+// Dynamic uniform buffer, offset per object at bind time.
 layout(set = 1, binding = 0) uniform local_uniform_object {
     vec4 diffuse_color;
 } object_ubo;
 
-layout(set = 1, binding = 1) uniform sampler2D diffuse_sampler;
+layout(set = 2, binding = 0) uniform sampler2D diffuse_sampler;
 
 layout(location = 1) in struct dto {
 	vec2 tex_coord;
@@ -0,0 +1,26 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec2 in_texcoord;
+
+// Per instance. A mat4 attribute takes up locations 2-5.
+layout(location = 2) in mat4 in_model;
+layout(location = 6) in uint in_material_index;
+
+layout (set = 0, binding = 0) uniform global_uniform_object {
+    mat4 projection;
+    mat4 view;
+} global_ubo;
+
+layout(location = 0) out int out_mode;
+
+layout(location = 1) out struct dto {
+    vec2 tex_coord;
+} out_dto;
+
+void main() {
+    // TODO: pass in_material_index on once there are materials to look up.
+    out_dto.tex_coord = in_texcoord;
+    gl_Position = global_ubo.projection * global_ubo.view * in_model * vec4(in_position, 1.0);
+}
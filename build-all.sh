@@ -0,0 +1,32 @@
+#!/bin/bash
+# Build Everything
+
+set echo on
+
+echo "Building everything..."
+
+# Engine
+make -f Makefile.engine.linux.mak all
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit $ERRORLEVEL
+fi
+
+# Testbed
+make -f Makefile.testbed.linux.mak all
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit $ERRORLEVEL
+fi
+
+# Tests
+make -f Makefile.tests.linux.mak all
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit $ERRORLEVEL
+fi
+
+echo "All assemblies built successfully."
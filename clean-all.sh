@@ -0,0 +1,32 @@
+#!/bin/bash
+# Clean Everything
+
+set echo on
+
+echo "Cleaning everything..."
+
+# Engine
+make -f Makefile.engine.linux.mak clean
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit $ERRORLEVEL
+fi
+
+# Testbed
+make -f Makefile.testbed.linux.mak clean
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit $ERRORLEVEL
+fi
+
+# Tests
+make -f Makefile.tests.linux.mak clean
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit $ERRORLEVEL
+fi
+
+echo "All assemblies cleaned successfully."
@@ -7,9 +7,12 @@
 #include "core/logger.h"
 
 #include "game_types.h"
-#include "memory/linear_allocator.h"
+#include "memory/arena_allocator.h"
+#include "memory/frame_allocator.h"
 #include "platform/platform.h"
 #include "renderer/renderer_frontend.h"
+#include "systems/job_system.h"
+#include "systems/task_graph.h"
 
 typedef struct application_state {
     game* game_inst;
@@ -19,7 +22,12 @@ typedef struct application_state {
     i16 height;
     clock clock;
     f64 last_time;
-    linear_allocator systems_allocator;
+    arena_allocator systems_allocator;
+
+    // Everything which runs once per frame, and what each part reads and writes.
+    task_graph frame_graph;
+    // For the frame's tasks.
+    f64 delta_time;
 
     u64 event_system_memory_requirement;
     void* event_system_state;
@@ -27,12 +35,18 @@ typedef struct application_state {
     u64 memory_system_memory_requirement;
     void* memory_system_state;
 
+    u64 frame_allocator_memory_requirement;
+    void* frame_allocator_state;
+
     u64 logging_system_memory_requirement;
     void* logging_system_state;
 
     u64 input_system_memory_requirement;
     void* input_system_state;
 
+    u64 job_system_memory_requirement;
+    void* job_system_state;
+
     u64 renderer_system_memory_requirement;
     void* renderer_system_state;
 
@@ -49,6 +63,8 @@ b8 application_on_event(u16 code, void* sender, void* listener_inst, event_conte
 b8 application_on_key(u16 code, void* sender, void* listener_inst, event_context);
 b8 application_on_resized(u16 code, void* sender, void* listener_inst, event_context context);
 
+static b8 create_frame_graph();
+
 b8 application_create(game* game_inst) {
     if (game_inst->application_state) {
         KERROR("application_create called more than once");
@@ -61,30 +77,44 @@ b8 application_create(game* game_inst) {
     app_state->is_running = false;
     app_state->is_suspended = false;
 
+    // Only address space is reserved here. Pages are committed (and zeroed) as systems claim them.
     u64 systems_allocator_total_size = 64 * 1024 * 1024;  // 64 mb
-    linear_allocator_create(systems_allocator_total_size, NULL, &app_state->systems_allocator);
+    if (!arena_allocator_create(systems_allocator_total_size, false, &app_state->systems_allocator)) {
+        KFATAL("Failed to create systems allocator. Shutting down");
+        return false;
+    }
 
     event_initialize(&app_state->event_system_memory_requirement, 0);
-    app_state->event_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->event_system_memory_requirement);
+    app_state->event_system_state = arena_allocator_allocate_aligned(&app_state->systems_allocator, app_state->event_system_memory_requirement, 16);
     event_initialize(&app_state->event_system_memory_requirement, app_state->event_system_state);
 
-    initialize_memory(&app_state->memory_system_memory_requirement, NULL);
-    app_state->memory_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->memory_system_memory_requirement);
-    initialize_memory(&app_state->memory_system_memory_requirement, app_state->memory_system_state);
+    memory_system_configuration memory_config = {};
+    memory_config.total_alloc_size = game_inst->app_config.memory_budget;
+    initialize_memory(&app_state->memory_system_memory_requirement, NULL, memory_config);
+    app_state->memory_system_state = arena_allocator_allocate_aligned(&app_state->systems_allocator, app_state->memory_system_memory_requirement, 16);
+    if (!initialize_memory(&app_state->memory_system_memory_requirement, app_state->memory_system_state, memory_config)) {
+        KFATAL("Failed to initialize memory system. Shutting down");
+        return false;
+    }
+
+    u64 frame_allocator_frame_size = 4 * 1024 * 1024;  // 4 mb per frame
+    frame_allocator_initialize(&app_state->frame_allocator_memory_requirement, 0, frame_allocator_frame_size);
+    app_state->frame_allocator_state = arena_allocator_allocate_aligned(&app_state->systems_allocator, app_state->frame_allocator_memory_requirement, 16);
+    frame_allocator_initialize(&app_state->frame_allocator_memory_requirement, app_state->frame_allocator_state, frame_allocator_frame_size);
 
     initialize_logging(&app_state->logging_system_memory_requirement, NULL);
-    app_state->logging_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->logging_system_memory_requirement);
+    app_state->logging_system_state = arena_allocator_allocate_aligned(&app_state->systems_allocator, app_state->logging_system_memory_requirement, 16);
     if (!initialize_logging(&app_state->logging_system_memory_requirement, app_state->logging_system_state)) {
         KERROR("Failed to initialize logging system. Shutting down");
         return false;
     }
 
     initialize_input(&app_state->input_system_memory_requirement, 0);
-    app_state->input_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->input_system_memory_requirement);
+    app_state->input_system_state = arena_allocator_allocate_aligned(&app_state->systems_allocator, app_state->input_system_memory_requirement, 16);
     initialize_input(&app_state->input_system_memory_requirement, app_state->input_system_state);
 
-    platform_startup(&app_state->platform_system_memory_requirement, 0, 0, 0, 0, 0, 0);
-    app_state->platform_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->platform_system_memory_requirement);
+    platform_startup(&app_state->platform_system_memory_requirement, 0, 0, 0, 0, 0, 0, false);
+    app_state->platform_system_state = arena_allocator_allocate_aligned(&app_state->systems_allocator, app_state->platform_system_memory_requirement, 16);
     if (!platform_startup(
             &app_state->platform_system_memory_requirement,
             app_state->platform_system_state,
@@ -92,17 +122,35 @@ b8 application_create(game* game_inst) {
             game_inst->app_config.start_pos_x,
             game_inst->app_config.start_pos_y,
             game_inst->app_config.start_width,
-            game_inst->app_config.start_height)) {
+            game_inst->app_config.start_height,
+            game_inst->app_config.headless)) {
         return false;
     }
 
-    renderer_initialize(&app_state->renderer_system_memory_requirement, NULL, NULL);
-    app_state->renderer_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->renderer_system_memory_requirement);
-    if (!renderer_initialize(&app_state->renderer_system_memory_requirement, app_state->renderer_system_state, game_inst->app_config.name)) {
+    job_system_initialize(&app_state->job_system_memory_requirement, 0, game_inst->app_config.jobs);
+    app_state->job_system_state = arena_allocator_allocate_aligned(&app_state->systems_allocator, app_state->job_system_memory_requirement, 64);
+    if (!job_system_initialize(&app_state->job_system_memory_requirement, app_state->job_system_state, game_inst->app_config.jobs)) {
+        KFATAL("Failed to initialize job system. Shutting down");
+        return false;
+    }
+
+    // There's no surface to present to without a window.
+    renderer_config render_config = game_inst->app_config.renderer;
+    if (game_inst->app_config.headless) {
+        render_config.offscreen = true;
+    }
+    renderer_initialize(&app_state->renderer_system_memory_requirement, NULL, NULL, render_config);
+    app_state->renderer_system_state = arena_allocator_allocate_aligned(&app_state->systems_allocator, app_state->renderer_system_memory_requirement, 16);
+    if (!renderer_initialize(&app_state->renderer_system_memory_requirement, app_state->renderer_system_state, game_inst->app_config.name, render_config)) {
         KFATAL("Failed to initialize renderer. Shutting down...");
         return false;
     }
 
+    if (!create_frame_graph()) {
+        KFATAL("Failed to create the frame task graph. Shutting down");
+        return false;
+    }
+
     if (!app_state->game_inst->initialize(game_inst)) {
         KFATAL("Failed to initialize game");
         return false;
@@ -137,23 +185,12 @@ b8 applicaton_run() {
             f64 delta_time = current_time - app_state->last_time;
             f64 frame_start_time = platform_get_absolute_time();
 
-            if (!app_state->game_inst->update(app_state->game_inst, delta_time)) {
-                KFATAL("Game update failed. shutting down");
+            app_state->delta_time = delta_time;
+            if (!task_graph_execute(&app_state->frame_graph)) {
                 app_state->is_running = false;
                 break;
             }
 
-            if (!app_state->game_inst->render(app_state->game_inst, delta_time)) {
-                KFATAL("Game render failed. shutting down");
-                app_state->is_running = false;
-                break;
-            }
-
-            // TODO: Handle this in the renderer
-            render_packet packet;
-            packet.delta_time = delta_time;
-            renderer_draw_frame(&packet);
-
             f64 frame_end_time = platform_get_absolute_time();
             f64 frame_elapsed_time = frame_end_time - frame_start_time;
             running_time += frame_elapsed_time;
@@ -167,33 +204,44 @@ b8 applicaton_run() {
 
             frame_count++;
 
-            // TODO: Handle input at the top of frame?
-            // Input update/state copying should always be handled
-            // after any input should be recorded; I.E. before this line.
-            // As a safety, input is the last thing to be updated before
-            // this frame ends.
-            input_update(delta_time);
+            // Roll the frame scratch memory and allocation stats over now that everything for this frame has run.
+            frame_allocator_end_frame();
+            end_memory_frame();
 
             // TODO: See if current time should be gotten here
             app_state->last_time = current_time;
         }
     }
 
+    if (app_state->game_inst->shutdown) {
+        app_state->game_inst->shutdown(app_state->game_inst);
+    }
+
     event_unregister(EVENT_CODE_APPLICATION_QUIT, NULL, application_on_event);
     event_unregister(EVENT_CODE_KEY_PRESSED, NULL, application_on_key);
     event_unregister(EVENT_CODE_KEY_RELEASED, NULL, application_on_key);
 
+    task_graph_destroy(&app_state->frame_graph);
+
     input_shutdown(app_state->input_system_state);
 
     renderer_shutdown();
 
+    // After everything which may still be waiting on jobs.
+    job_system_shutdown(app_state->job_system_state);
+
     // TODO: maybe explicitly set is_running to FALSE here?
     // app_state->is_running = FALSE;
     platform_shutdown(&app_state->platform_system_state);
 
+    event_shutdown(app_state->event_system_state);
+
+    frame_allocator_shutdown(app_state->frame_allocator_state);
+
+    // Shut down last, as every other system may still be freeing memory from it.
     shutdown_memory(app_state->memory_system_state);
 
-    event_shutdown(app_state->event_system_state);
+    arena_allocator_destroy(&app_state->systems_allocator);
 
     return true;
 }
@@ -209,6 +257,10 @@ b8 application_on_event(u16 code, void* sender, void* listener_inst, event_conte
     return false;
 }
 
+task_graph* application_get_frame_graph() {
+    return &app_state->frame_graph;
+}
+
 void application_get_framebuffer_size(u32* width, u32* height) {
     *width = app_state->width;
     *height = app_state->height;
@@ -266,4 +318,82 @@ b8 application_on_resized(u16 code, void* sender, void* listener_inst, event_con
     }
 
     return false;
-}
\ No newline at end of file
+}
+static b8 frame_game_update(void* user_data) {
+    if (!app_state->game_inst->update(app_state->game_inst, app_state->delta_time)) {
+        KFATAL("Game update failed. shutting down");
+        return false;
+    }
+    return true;
+}
+
+static b8 frame_game_render(void* user_data) {
+    if (!app_state->game_inst->render(app_state->game_inst, app_state->delta_time)) {
+        KFATAL("Game render failed. shutting down");
+        return false;
+    }
+    return true;
+}
+
+static b8 frame_draw(void* user_data) {
+    // TODO: Handle this in the renderer
+    render_packet packet;
+    packet.delta_time = app_state->delta_time;
+    renderer_draw_frame(&packet);
+    return true;
+}
+
+static b8 frame_input_update(void* user_data) {
+    input_update(app_state->delta_time);
+    return true;
+}
+
+static b8 create_frame_graph() {
+    task_graph* graph = &app_state->frame_graph;
+    if (!task_graph_create(graph)) {
+        return false;
+    }
+
+    u32 input = task_graph_resource(graph, "input");
+    u32 game_state = task_graph_resource(graph, "game_state");
+    u32 render_data = task_graph_resource(graph, "render_data");
+    u32 gpu = task_graph_resource(graph, "gpu");
+
+    task_desc tasks[4] = {};
+    // Games may submit quads and the view from update as well as render.
+    u32 update_writes[2] = {game_state, render_data};
+    tasks[0].name = "game_update";
+    tasks[0].run = frame_game_update;
+    tasks[0].read_count = 1;
+    tasks[0].reads = &input;
+    tasks[0].write_count = 2;
+    tasks[0].writes = update_writes;
+
+    tasks[1].name = "game_render";
+    tasks[1].run = frame_game_render;
+    tasks[1].read_count = 1;
+    tasks[1].reads = &game_state;
+    tasks[1].write_count = 1;
+    tasks[1].writes = &render_data;
+
+    tasks[2].name = "renderer_draw_frame";
+    tasks[2].run = frame_draw;
+    tasks[2].read_count = 1;
+    tasks[2].reads = &render_data;
+    tasks[2].write_count = 1;
+    tasks[2].writes = &gpu;
+
+    // Copies this frame's input state to the previous one, so only after update has read it.
+    // Doesn't wait on rendering.
+    tasks[3].name = "input_update";
+    tasks[3].run = frame_input_update;
+    tasks[3].write_count = 1;
+    tasks[3].writes = &input;
+
+    for (u32 i = 0; i < 4; ++i) {
+        if (!task_graph_add_task(graph, &tasks[i], 0)) {
+            return false;
+        }
+    }
+    return true;
+}
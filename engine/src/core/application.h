@@ -2,6 +2,10 @@
 
 #include "defines.h"
 
+#include "renderer/renderer_types.inl"
+#include "systems/job_system.h"
+#include "systems/task_graph.h"
+
 // Forward delcare game to avoid circular depdendency with game_types.h
 struct game;
 
@@ -13,10 +17,27 @@ typedef struct application_config {
     i16 start_height;
 
     char* name;
+
+    // Runs without a window or input, e.g. for automated tests and profiling.
+    b8 headless;
+
+    renderer_config renderer;
+
+    job_system_config jobs;
+
+    // Total bytes reserved up front for all tagged allocations. 0 uses the platform allocator directly.
+    u64 memory_budget;
 } application_config;
 
 KAPI b8 application_create(struct game* game_inst);
 
 KAPI b8 applicaton_run();
 
+/**
+ * @brief The tasks run each frame: game_update, game_render, renderer_draw_frame and input_update,
+ * over the resources input, game_state, render_data and gpu. Tasks added here run every frame
+ * after the ones added before them which touch the same resources.
+ */
+KAPI task_graph* application_get_frame_graph();
+
 void application_get_framebuffer_size(u32* width, u32* height);
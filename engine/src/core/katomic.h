@@ -0,0 +1,53 @@
+#pragma once
+
+#include "defines.h"
+
+#include <stdatomic.h>
+
+// Thin wrappers over C11 atomics so the engine isn't tied to the compiler's spelling of them.
+// Only katomic_* types may be passed to katomic_* operations.
+
+typedef _Atomic(i32) katomic_i32;
+typedef _Atomic(u32) katomic_u32;
+typedef _Atomic(i64) katomic_i64;
+typedef _Atomic(u64) katomic_u64;
+typedef _Atomic(void*) katomic_ptr;
+
+typedef enum katomic_order {
+    KATOMIC_RELAXED = memory_order_relaxed,
+    KATOMIC_ACQUIRE = memory_order_acquire,
+    KATOMIC_RELEASE = memory_order_release,
+    KATOMIC_ACQ_REL = memory_order_acq_rel,
+    KATOMIC_SEQ_CST = memory_order_seq_cst
+} katomic_order;
+
+// Not atomic. Only for setting up a value no other thread can see yet.
+#define katomic_init(object, value) atomic_init(object, value)
+
+#define katomic_load(object, order) atomic_load_explicit(object, (memory_order)(order))
+#define katomic_store(object, value, order) atomic_store_explicit(object, value, (memory_order)(order))
+#define katomic_exchange(object, value, order) atomic_exchange_explicit(object, value, (memory_order)(order))
+
+// Returns the previous value.
+#define katomic_fetch_add(object, value, order) atomic_fetch_add_explicit(object, value, (memory_order)(order))
+#define katomic_fetch_sub(object, value, order) atomic_fetch_sub_explicit(object, value, (memory_order)(order))
+#define katomic_fetch_and(object, value, order) atomic_fetch_and_explicit(object, value, (memory_order)(order))
+#define katomic_fetch_or(object, value, order) atomic_fetch_or_explicit(object, value, (memory_order)(order))
+
+// On failure the current value is written to *expected. The weak form may fail spuriously and
+// belongs in a loop.
+#define katomic_compare_exchange_strong(object, expected, desired, success_order, failure_order) \
+    atomic_compare_exchange_strong_explicit(object, expected, desired, (memory_order)(success_order), (memory_order)(failure_order))
+#define katomic_compare_exchange_weak(object, expected, desired, success_order, failure_order) \
+    atomic_compare_exchange_weak_explicit(object, expected, desired, (memory_order)(success_order), (memory_order)(failure_order))
+
+#define katomic_thread_fence(order) atomic_thread_fence((memory_order)(order))
+
+// Tells the cpu it's in a spin-wait loop.
+KINLINE void katomic_pause() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "defines.h"
+
+#include "core/kmutex.h"
+
+// Waits may wake spuriously, so always wait in a loop which checks the condition.
+typedef struct kcondvar {
+    void* internal_data;
+} kcondvar;
+
+KAPI b8 kcondvar_create(kcondvar* out_condvar);
+KAPI void kcondvar_destroy(kcondvar* condvar);
+
+// Unlocks mutex while waiting and locks it again before returning. mutex must be held.
+KAPI void kcondvar_wait(kcondvar* condvar, kmutex* mutex);
+// Returns false if timeout_ms passed without a wake up.
+KAPI b8 kcondvar_wait_timeout(kcondvar* condvar, kmutex* mutex, u64 timeout_ms);
+
+// Wakes one waiter.
+KAPI void kcondvar_signal(kcondvar* condvar);
+// Wakes every waiter.
+KAPI void kcondvar_broadcast(kcondvar* condvar);
@@ -1,15 +1,33 @@
 #include "kmemory.h"
 
+#include "core/katomic.h"
+#include "core/kmutex.h"
+#include "core/kthread.h"
+#include "core/kstring.h"
 #include "core/logger.h"
 
+#include "memory/dynamic_allocator.h"
 #include "platform/platform.h"
 #include <stdio.h>
 // TODO: Use string utilities
 #include <string.h>
 
+// NOTE: Every counter is updated with relaxed atomics so allocations can happen from any thread
+// without a lock. Readers may observe a slightly stale mix of counters, which is fine for reporting.
 struct memory_stats {
-    u64 total_allocated;
-    u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
+    katomic_u64 total_allocated;
+    katomic_u64 peak_allocated;
+    katomic_u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
+    katomic_u64 tagged_peak_allocations[MEMORY_TAG_MAX_TAGS];
+    katomic_u64 tagged_allocation_counts[MEMORY_TAG_MAX_TAGS];
+};
+
+// Atomic counterpart of memory_frame_stats.
+struct memory_frame_counters {
+    katomic_u64 alloc_count;
+    katomic_u64 allocated;
+    katomic_u64 free_count;
+    katomic_u64 freed;
 };
 
 static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
@@ -30,60 +48,523 @@ static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "TRANSFORM       ",
     "ENTITY          ",
     "ENTITY_NODE     ",
+    "SCENE           ",
 };
 
+#define MAX_MEMORY_USAGE_REPORTERS 4
+#define MAX_MEMORY_USAGE_ENTRIES 8
+
+typedef struct memory_usage_reporter {
+    const char* name;
+    PFN_memory_usage_reporter callback;
+    void* user_data;
+} memory_usage_reporter;
+
 typedef struct memory_system_state {
+    memory_system_configuration config;
+    // Only valid when config.total_alloc_size is non-zero.
+    dynamic_allocator allocator;
+    u64 allocator_memory_requirement;
+    void* allocator_block;
+    // The dynamic allocator isn't thread safe, and every kallocate/kfree goes through it.
+    kmutex allocator_lock;
+
     struct memory_stats stats;
-    u64 alloc_count;
+    katomic_u64 alloc_count;
+    // Accumulated since the last call to end_memory_frame.
+    struct memory_frame_counters current_frame;
+    // Snapshot of the last completed frame.
+    memory_frame_stats last_frame;
+
+    memory_usage_reporter reporters[MAX_MEMORY_USAGE_REPORTERS];
 } memory_system_state;
 
 static memory_system_state* state_ptr;
 
-void initialize_memory(u64* memory_requirement, void* state) {
+static inline u64 stat_add(katomic_u64* value, u64 amount) {
+    return katomic_fetch_add(value, amount, KATOMIC_RELAXED) + amount;
+}
+
+static inline u64 stat_sub(katomic_u64* value, u64 amount) {
+    return katomic_fetch_sub(value, amount, KATOMIC_RELAXED) - amount;
+}
+
+static inline u64 stat_load(katomic_u64* value) {
+    return katomic_load(value, KATOMIC_RELAXED);
+}
+
+static inline u64 stat_exchange(katomic_u64* value, u64 new_value) {
+    return katomic_exchange(value, new_value, KATOMIC_RELAXED);
+}
+
+static inline void stat_max(katomic_u64* value, u64 candidate) {
+    u64 current = stat_load(value);
+    while (candidate > current) {
+        if (katomic_compare_exchange_weak(value, &current, candidate, KATOMIC_RELAXED, KATOMIC_RELAXED)) {
+            break;
+        }
+    }
+}
+
+#if KMEMORY_TRACKING
+// Marks a slot whose record was removed, so probing continues past it.
+#define TRACKING_TOMBSTONE ((void*)1)
+#define TRACKING_MIN_CAPACITY 1024
+// Leaks beyond this are summarized rather than listed.
+#define TRACKING_MAX_LEAKS_LISTED 64
+// Spins before yielding while another thread holds the tracker lock.
+#define TRACKING_LOCK_SPIN_COUNT 64
+
+typedef struct allocation_record {
+    void* block;
+    u64 size;
+    const char* file;
+    u32 line;
+    u32 session;
+    u64 frame;
+    memory_tag tag;
+    b8 aligned;
+} allocation_record;
+
+// NOTE: Lives outside of the memory system state so allocations made before the system
+// starts (or after it stops) are still tracked. Uses the platform directly to avoid recursion.
+// Every access goes through tracker_lock, which has no setup to do before the first allocation.
+static struct {
+    katomic_u32 locked;
+    allocation_record* records;
+    u64 capacity;
+    u64 count;
+    u64 tombstones;
+    u64 errors;
+    u64 frame;
+    // Incremented every time the memory system starts. 0 means not started.
+    u32 session;
+} tracker;
+
+static void tracker_lock() {
+    u32 spins = 0;
+    while (katomic_exchange(&tracker.locked, 1, KATOMIC_ACQUIRE)) {
+        // Wait for it to look free before trying again, rather than hammering the exchange.
+        while (katomic_load(&tracker.locked, KATOMIC_RELAXED)) {
+            if (++spins >= TRACKING_LOCK_SPIN_COUNT) {
+                kthread_yield();
+            } else {
+                katomic_pause();
+            }
+        }
+    }
+}
+
+static void tracker_unlock() {
+    katomic_store(&tracker.locked, 0, KATOMIC_RELEASE);
+}
+
+static u64 tracker_hash(void* block) {
+    // Fibonacci hashing; the low bits of an allocation are nearly always zero.
+    return ((u64)block * 11400714819323198485ull) >> 20;
+}
+
+static allocation_record* tracker_find(void* block) {
+    if (!tracker.records) {
+        return 0;
+    }
+    u64 mask = tracker.capacity - 1;
+    for (u64 i = tracker_hash(block) & mask;; i = (i + 1) & mask) {
+        allocation_record* record = &tracker.records[i];
+        if (record->block == block) {
+            return record;
+        }
+        if (record->block == 0) {
+            return 0;
+        }
+    }
+}
+
+static void tracker_insert_record(allocation_record* records, u64 capacity, const allocation_record* record) {
+    u64 mask = capacity - 1;
+    u64 i = tracker_hash(record->block) & mask;
+    while (records[i].block != 0 && records[i].block != TRACKING_TOMBSTONE) {
+        i = (i + 1) & mask;
+    }
+    records[i] = *record;
+}
+
+static void tracker_grow() {
+    u64 new_capacity = TRACKING_MIN_CAPACITY;
+    while (new_capacity < tracker.count * 4) {
+        new_capacity *= 2;
+    }
+    allocation_record* new_records = platform_allocate(sizeof(allocation_record) * new_capacity, false);
+    platform_zero_memory(new_records, sizeof(allocation_record) * new_capacity);
+    for (u64 i = 0; i < tracker.capacity; ++i) {
+        void* block = tracker.records[i].block;
+        if (block && block != TRACKING_TOMBSTONE) {
+            tracker_insert_record(new_records, new_capacity, &tracker.records[i]);
+        }
+    }
+    if (tracker.records) {
+        platform_free(tracker.records, false);
+    }
+    tracker.records = new_records;
+    tracker.capacity = new_capacity;
+    tracker.tombstones = 0;
+}
+
+static void tracker_add(void* block, u64 size, b8 aligned, memory_tag tag, const char* file, u32 line) {
+    if (!block) {
+        return;
+    }
+
+    tracker_lock();
+    // Keep the load (including tombstones) under half so probes stay short.
+    if ((tracker.count + tracker.tombstones + 1) * 2 > tracker.capacity) {
+        tracker_grow();
+    }
+
+    allocation_record record;
+    record.block = block;
+    record.size = size;
+    record.file = file ? file : "unknown";
+    record.line = line;
+    record.session = state_ptr ? tracker.session : 0;
+    record.frame = tracker.frame;
+    record.tag = tag;
+    record.aligned = aligned;
+    tracker_insert_record(tracker.records, tracker.capacity, &record);
+    tracker.count++;
+    tracker_unlock();
+}
+
+// Validates a free against its record. Returns false if the block must not be freed.
+static b8 tracker_remove(void* block, u64* size, b8* aligned, memory_tag tag, const char* file, u32 line) {
+    file = file ? file : "unknown";
+    tracker_lock();
+    allocation_record* record = tracker_find(block);
+    if (!record) {
+        KERROR("kfree at %s:%u on %p, which is not a live allocation. Double free or not from kallocate?", file, line, block);
+        tracker.errors++;
+        tracker_unlock();
+        return false;
+    }
+
+    if (record->size != *size) {
+        KERROR("kfree at %s:%u passed a size of %llu for a block of %llu allocated at %s:%u.", file, line, *size, record->size, record->file, record->line);
+        tracker.errors++;
+        *size = record->size;
+    }
+    if (record->aligned != *aligned) {
+        KERROR("kfree at %s:%u used the %s free for a block allocated %s at %s:%u.", file, line, *aligned ? "aligned" : "unaligned", record->aligned ? "aligned" : "unaligned", record->file, record->line);
+        tracker.errors++;
+        *aligned = record->aligned;
+    }
+    if (record->tag != tag) {
+        KWARN("kfree at %s:%u used tag %s for a block allocated with %s at %s:%u.", file, line, memory_tag_strings[tag], memory_tag_strings[record->tag], record->file, record->line);
+    }
+
+    record->block = TRACKING_TOMBSTONE;
+    tracker.count--;
+    tracker.tombstones++;
+    tracker_unlock();
+    return true;
+}
+
+u64 memory_tracking_live_count() {
+    tracker_lock();
+    u64 count = tracker.count;
+    tracker_unlock();
+    return count;
+}
+
+u64 memory_tracking_error_count() {
+    tracker_lock();
+    u64 errors = tracker.errors;
+    tracker_unlock();
+    return errors;
+}
+
+u64 memory_tracking_report_leaks() {
+    tracker_lock();
+    u64 leak_count = 0;
+    u64 leaked_bytes = 0;
+    for (u64 i = 0; i < tracker.capacity; ++i) {
+        allocation_record* record = &tracker.records[i];
+        if (!record->block || record->block == TRACKING_TOMBSTONE || !record->session || record->session != tracker.session) {
+            continue;
+        }
+        if (leak_count < TRACKING_MAX_LEAKS_LISTED) {
+            KWARN("Leaked %llu bytes (%s) allocated at %s:%u in frame %llu.", record->size, memory_tag_strings[record->tag], record->file, record->line, record->frame);
+        }
+        leak_count++;
+        leaked_bytes += record->size;
+    }
+    if (leak_count) {
+        KWARN("%llu allocations (%llu bytes) were leaked.", leak_count, leaked_bytes);
+    }
+    tracker_unlock();
+    return leak_count;
+}
+
+typedef struct allocation_site {
+    const char* file;
+    u32 line;
+    u64 count;
+    u64 size;
+} allocation_site;
+
+void memory_tracking_dump_top_sites(u32 count) {
+    tracker_lock();
+    if (!tracker.count) {
+        tracker_unlock();
+        return;
+    }
+
+    // Gather a record per unique call site. Sites are few, so a linear scan is fine for a debug dump.
+    allocation_site* sites = platform_allocate(sizeof(allocation_site) * tracker.count, false);
+    u64 site_count = 0;
+    for (u64 i = 0; i < tracker.capacity; ++i) {
+        allocation_record* record = &tracker.records[i];
+        if (!record->block || record->block == TRACKING_TOMBSTONE) {
+            continue;
+        }
+        u64 s = 0;
+        for (; s < site_count; ++s) {
+            if (sites[s].line == record->line && sites[s].file == record->file) {
+                break;
+            }
+        }
+        if (s == site_count) {
+            sites[site_count].file = record->file;
+            sites[site_count].line = record->line;
+            sites[site_count].count = 0;
+            sites[site_count].size = 0;
+            site_count++;
+        }
+        sites[s].count++;
+        sites[s].size += record->size;
+    }
+    tracker_unlock();
+
+    KINFO("Top allocation sites by live bytes:");
+    for (u32 n = 0; n < count && n < site_count; ++n) {
+        // Selection sort just far enough to get the top entries.
+        u64 largest = n;
+        for (u64 s = n + 1; s < site_count; ++s) {
+            if (sites[s].size > sites[largest].size) {
+                largest = s;
+            }
+        }
+        allocation_site temp = sites[n];
+        sites[n] = sites[largest];
+        sites[largest] = temp;
+        KINFO("%2u: %llu bytes in %llu allocations at %s:%u", n + 1, sites[n].size, sites[n].count, sites[n].file, sites[n].line);
+    }
+
+    platform_free(sites, false);
+}
+#endif
+
+b8 initialize_memory(u64* memory_requirement, void* state, memory_system_configuration config) {
     *memory_requirement = sizeof(memory_system_state);
     if (state == NULL) {
-        return;
+        return true;
+    }
+    platform_zero_memory(state, sizeof(memory_system_state));
+    memory_system_state* new_state = state;
+    new_state->config = config;
+
+    if (config.total_alloc_size) {
+        dynamic_allocator_create(config.total_alloc_size, &new_state->allocator_memory_requirement, 0, 0);
+        new_state->allocator_block = platform_allocate_aligned(new_state->allocator_memory_requirement, 64);
+        if (!new_state->allocator_block) {
+            KFATAL("Failed to reserve %llu bytes for the memory system.", new_state->allocator_memory_requirement);
+            return false;
+        }
+        if (!dynamic_allocator_create(config.total_alloc_size, &new_state->allocator_memory_requirement, new_state->allocator_block, &new_state->allocator)) {
+            KFATAL("Failed to create the memory system's dynamic allocator.");
+            platform_free_aligned(new_state->allocator_block);
+            return false;
+        }
+        if (!kmutex_create(&new_state->allocator_lock)) {
+            KFATAL("Failed to create the memory system's allocator lock.");
+            dynamic_allocator_destroy(&new_state->allocator);
+            platform_free_aligned(new_state->allocator_block);
+            return false;
+        }
+        KDEBUG("Memory system serving allocations from a %llu byte block.", config.total_alloc_size);
     }
-    state_ptr = state;
-    state_ptr->alloc_count = 0;
-    platform_zero_memory(&state_ptr->stats, sizeof(state_ptr->stats));
+
+    state_ptr = new_state;
+#if KMEMORY_TRACKING
+    tracker_lock();
+    tracker.session++;
+    tracker_unlock();
+#endif
+    return true;
 }
 
 void shutdown_memory(void* state) {
+#if KMEMORY_TRACKING
+    if (state_ptr) {
+        memory_tracking_report_leaks();
+    }
+#endif
+    if (state_ptr && state_ptr->allocator_block) {
+        dynamic_allocator_destroy(&state_ptr->allocator);
+        platform_free_aligned(state_ptr->allocator_block);
+        state_ptr->allocator_block = 0;
+        kmutex_destroy(&state_ptr->allocator_lock);
+    }
     state_ptr = NULL;
 }
 
-KAPI void* kallocate(u64 size, memory_tag tag) {
+static b8 using_allocator() {
+    return state_ptr && state_ptr->allocator_block;
+}
+
+// An alignment of 0 takes the platform's default alignment.
+static void* allocate_block(u64 size, u16 alignment) {
+    if (using_allocator()) {
+        kmutex_lock(&state_ptr->allocator_lock);
+        void* block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, size, alignment);
+        kmutex_unlock(&state_ptr->allocator_lock);
+        if (block) {
+            return block;
+        }
+        // Keep running, but the budget should be raised to fit.
+        KWARN("Memory budget of %llu bytes exceeded, falling back to the platform allocator.", state_ptr->config.total_alloc_size);
+    }
+    return alignment ? platform_allocate_aligned(size, alignment) : platform_allocate(size, false);
+}
+
+static void free_block(void* block, b8 aligned) {
+    // Blocks may predate the allocator or have overflowed it, so check where they came from.
+    if (using_allocator() && dynamic_allocator_owns(&state_ptr->allocator, block)) {
+        kmutex_lock(&state_ptr->allocator_lock);
+        dynamic_allocator_free(&state_ptr->allocator, block);
+        kmutex_unlock(&state_ptr->allocator_lock);
+    } else if (aligned) {
+        platform_free_aligned(block);
+    } else {
+        platform_free(block, false);
+    }
+}
+
+static void track_allocation(u64 size, memory_tag tag) {
     if (tag == MEMORY_TAG_UNKNOWN) {
         KWARN("kallocate called using MEMORY_TAG_UNKNOWN. Reclassify this allocation");
     }
 
     // TODO: Do we need to initalize memory earlier so this isn't necessary?
     if (state_ptr) {
-        state_ptr->stats.total_allocated += size;
-        state_ptr->stats.tagged_allocations[tag] += size;
-        state_ptr->alloc_count++;
-    }
+        u64 total = stat_add(&state_ptr->stats.total_allocated, size);
+        stat_max(&state_ptr->stats.peak_allocated, total);
+        u64 tagged = stat_add(&state_ptr->stats.tagged_allocations[tag], size);
+        stat_max(&state_ptr->stats.tagged_peak_allocations[tag], tagged);
+        stat_add(&state_ptr->stats.tagged_allocation_counts[tag], 1);
+        stat_add(&state_ptr->alloc_count, 1);
 
-    // TODO: Memory alignment
-    void* block = platform_allocate(size, false);
-    platform_zero_memory(block, size);
-    return block;
+        stat_add(&state_ptr->current_frame.alloc_count, 1);
+        stat_add(&state_ptr->current_frame.allocated, size);
+    }
 }
 
-KAPI void kfree(void* block, u64 size, memory_tag tag) {
+static void track_free(u64 size, memory_tag tag) {
     if (tag == MEMORY_TAG_UNKNOWN) {
-        KWARN("kallocate called using MEMORY_TAG_UNKNOWN. Reclassify this allocation");
+        KWARN("kfree called using MEMORY_TAG_UNKNOWN. Reclassify this allocation");
     }
 
     if (state_ptr) {
-        state_ptr->stats.total_allocated -= size;
-        state_ptr->stats.tagged_allocations[tag] -= size;
+        stat_sub(&state_ptr->stats.total_allocated, size);
+        stat_sub(&state_ptr->stats.tagged_allocations[tag], size);
+
+        stat_add(&state_ptr->current_frame.free_count, 1);
+        stat_add(&state_ptr->current_frame.freed, size);
+    }
+}
+
+static void* allocate(u64 size, u16 alignment, memory_tag tag, b8 zero, const char* file, u32 line) {
+    void* block = allocate_block(size, alignment);
+    if (!block) {
+        KERROR("Failed to allocate %llu bytes (%s).", size, memory_tag_strings[tag]);
+        return NULL;
+    }
+    track_allocation(size, tag);
+    if (zero) {
+        platform_zero_memory(block, size);
+    }
+#if KMEMORY_TRACKING
+    tracker_add(block, size, alignment != 0, tag, file, line);
+#endif
+    return block;
+}
+
+static void release(void* block, u64 size, b8 aligned, memory_tag tag, const char* file, u32 line) {
+#if KMEMORY_TRACKING
+    if (!tracker_remove(block, &size, &aligned, tag, file, line)) {
+        return;
+    }
+#endif
+    track_free(size, tag);
+    free_block(block, aligned);
+}
+
+static b8 validate_alignment(u16 alignment) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        KERROR("kallocate_aligned called with an alignment of %u, which is not a power of 2", alignment);
+        return false;
+    }
+    return true;
+}
+
+// NOTE: The names are wrapped in parentheses so the tracking macros in kmemory.h don't expand them.
+KAPI void*(kallocate)(u64 size, memory_tag tag) {
+    return allocate(size, 0, tag, true, 0, 0);
+}
+
+KAPI void*(kallocate_uninit)(u64 size, memory_tag tag) {
+    return allocate(size, 0, tag, false, 0, 0);
+}
+
+KAPI void*(kallocate_aligned)(u64 size, u16 alignment, memory_tag tag) {
+    if (!validate_alignment(alignment)) {
+        return NULL;
+    }
+    return allocate(size, alignment, tag, true, 0, 0);
+}
+
+KAPI void(kfree)(void* block, u64 size, memory_tag tag) {
+    release(block, size, false, tag, 0, 0);
+}
+
+KAPI void(kfree_aligned)(void* block, u64 size, u16 alignment, memory_tag tag) {
+    release(block, size, true, tag, 0, 0);
+}
+
+#if KMEMORY_TRACKING
+KAPI void* kallocate_tracked(u64 size, memory_tag tag, const char* file, u32 line) {
+    return allocate(size, 0, tag, true, file, line);
+}
+
+KAPI void* kallocate_uninit_tracked(u64 size, memory_tag tag, const char* file, u32 line) {
+    return allocate(size, 0, tag, false, file, line);
+}
+
+KAPI void* kallocate_aligned_tracked(u64 size, u16 alignment, memory_tag tag, const char* file, u32 line) {
+    if (!validate_alignment(alignment)) {
+        return NULL;
     }
-    // TODO: Memory alignment
-    platform_free(block, false);
+    return allocate(size, alignment, tag, true, file, line);
+}
+
+KAPI void kfree_tracked(void* block, u64 size, memory_tag tag, const char* file, u32 line) {
+    release(block, size, false, tag, file, line);
 }
 
+KAPI void kfree_aligned_tracked(void* block, u64 size, u16 alignment, memory_tag tag, const char* file, u32 line) {
+    release(block, size, true, tag, file, line);
+}
+#endif
+
 KAPI void* kzero_memory(void* block, u64 size) {
     return platform_zero_memory(block, size);
 }
@@ -96,45 +577,137 @@ KAPI void* kset_memory(void* dest, i32 value, u64 size) {
     return platform_set_memory(dest, value, size);
 }
 
-// Useful for debugging
-KAPI char* get_memory_usage_str() {
+static void get_size_unit(u64 size, f32* out_amount, const char** out_unit) {
     const u64 kib = 1024;
     const u64 mib = 1024 * 1024;
     const u64 gib = 1024 * 1024 * 1024;
 
+    if (size >= gib) {
+        *out_amount = (f32)size / (f32)gib;
+        *out_unit = "GiB";
+    } else if (size >= mib) {
+        *out_amount = (f32)size / (f32)mib;
+        *out_unit = "MiB";
+    } else if (size >= kib) {
+        *out_amount = (f32)size / (f32)kib;
+        *out_unit = "KiB";
+    } else {
+        *out_amount = (f32)size;
+        *out_unit = "B";
+    }
+}
+
+b8 memory_register_usage_reporter(const char* name, PFN_memory_usage_reporter reporter, void* user_data) {
+    if (!state_ptr) {
+        return false;
+    }
+    for (u32 i = 0; i < MAX_MEMORY_USAGE_REPORTERS; ++i) {
+        if (!state_ptr->reporters[i].callback) {
+            state_ptr->reporters[i].name = name;
+            state_ptr->reporters[i].callback = reporter;
+            state_ptr->reporters[i].user_data = user_data;
+            return true;
+        }
+    }
+    KWARN("memory_register_usage_reporter - no free reporter slots for '%s'.", name);
+    return false;
+}
+
+void memory_unregister_usage_reporter(PFN_memory_usage_reporter reporter, void* user_data) {
+    if (!state_ptr) {
+        return;
+    }
+    for (u32 i = 0; i < MAX_MEMORY_USAGE_REPORTERS; ++i) {
+        if (state_ptr->reporters[i].callback == reporter && state_ptr->reporters[i].user_data == user_data) {
+            kzero_memory(&state_ptr->reporters[i], sizeof(memory_usage_reporter));
+        }
+    }
+}
+
+// Useful for debugging
+KAPI char* get_memory_usage_str() {
 #define buffer_size 8000
     // static const u64 buffer_size = 8000;
     char buffer[buffer_size] = "System memory use (tagged): \n";
     u64 offset = strlen(buffer);
+    f32 amount;
+    const char* unit;
+    f32 peak_amount;
+    const char* peak_unit;
     for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; i++) {
-        char unit[4] = "XiB";
-        float amount = 1.0f;
-        if (state_ptr->stats.tagged_allocations[i] >= gib) {
-            amount = (float)state_ptr->stats.tagged_allocations[i] / (float)gib;
-            unit[0] = 'G';
-        } else if (state_ptr->stats.tagged_allocations[i] >= mib) {
-            amount = (float)state_ptr->stats.tagged_allocations[i] / (float)mib;
-            unit[0] = 'M';
-        } else if (state_ptr->stats.tagged_allocations[i] >= kib) {
-            amount = (float)state_ptr->stats.tagged_allocations[i] / (float)kib;
-            unit[0] = 'K';
-        } else {
-            amount = (float)state_ptr->stats.tagged_allocations[i];
-            unit[0] = 'B';
-            unit[1] = 0;
-        }
-        i32 length = snprintf(buffer + offset, buffer_size - offset, "%s: %.2f%s\n", memory_tag_strings[i], amount, unit);
+        get_size_unit(stat_load(&state_ptr->stats.tagged_allocations[i]), &amount, &unit);
+        get_size_unit(stat_load(&state_ptr->stats.tagged_peak_allocations[i]), &peak_amount, &peak_unit);
+        u64 count = stat_load(&state_ptr->stats.tagged_allocation_counts[i]);
+        i32 length = snprintf(buffer + offset, buffer_size - offset, "%s: %.2f%s (peak %.2f%s, %llu allocations)\n", memory_tag_strings[i], amount, unit, peak_amount, peak_unit, count);
+        offset += length;
+    }
+
+    get_size_unit(stat_load(&state_ptr->stats.total_allocated), &amount, &unit);
+    get_size_unit(stat_load(&state_ptr->stats.peak_allocated), &peak_amount, &peak_unit);
+    i32 length = snprintf(buffer + offset, buffer_size - offset, "Total: %.2f%s (peak %.2f%s)\n", amount, unit, peak_amount, peak_unit);
+    offset += length;
+
+    if (using_allocator()) {
+        kmutex_lock(&state_ptr->allocator_lock);
+        u64 total_space = dynamic_allocator_total_space(&state_ptr->allocator);
+        u64 free_space = dynamic_allocator_free_space(&state_ptr->allocator);
+        kmutex_unlock(&state_ptr->allocator_lock);
+        get_size_unit(total_space - free_space, &amount, &unit);
+        get_size_unit(total_space, &peak_amount, &peak_unit);
+        length = snprintf(buffer + offset, buffer_size - offset, "Budget: %.2f%s of %.2f%s in use\n", amount, unit, peak_amount, peak_unit);
+        offset += length;
+    }
+
+    for (u32 r = 0; r < MAX_MEMORY_USAGE_REPORTERS; ++r) {
+        memory_usage_reporter* reporter = &state_ptr->reporters[r];
+        if (!reporter->callback) {
+            continue;
+        }
+        memory_usage_entry entries[MAX_MEMORY_USAGE_ENTRIES];
+        u32 entry_count = reporter->callback(reporter->user_data, entries, MAX_MEMORY_USAGE_ENTRIES);
+        length = snprintf(buffer + offset, buffer_size - offset, "%s:\n", reporter->name);
         offset += length;
+        for (u32 i = 0; i < entry_count; ++i) {
+            get_size_unit(entries[i].size, &amount, &unit);
+            length = snprintf(buffer + offset, buffer_size - offset, "  %s: %.2f%s (%llu allocations)\n", entries[i].name, amount, unit, entries[i].count);
+            offset += length;
+        }
     }
 
-    // TODO: Use custom allocator, use used a fixed size StringBuffer class
-    char* out_string = _strdup(buffer);
+    memory_frame_stats frame = get_memory_frame_stats();
+    get_size_unit(frame.allocated, &amount, &unit);
+    get_size_unit(frame.freed, &peak_amount, &peak_unit);
+    snprintf(buffer + offset, buffer_size - offset, "Last frame: %llu allocations (%.2f%s), %llu frees (%.2f%s)\n", frame.alloc_count, amount, unit, frame.free_count, peak_amount, peak_unit);
+
+    char* out_string = string_duplicate(buffer);
     return out_string;
 }
 
 u64 get_memory_alloc_count() {
     if (state_ptr) {
-        return state_ptr->alloc_count;
+        return stat_load(&state_ptr->alloc_count);
     }
     return 0;
 }
+
+void end_memory_frame() {
+#if KMEMORY_TRACKING
+    tracker_lock();
+    tracker.frame++;
+    tracker_unlock();
+#endif
+    if (state_ptr) {
+        state_ptr->last_frame.alloc_count = stat_exchange(&state_ptr->current_frame.alloc_count, 0);
+        state_ptr->last_frame.allocated = stat_exchange(&state_ptr->current_frame.allocated, 0);
+        state_ptr->last_frame.free_count = stat_exchange(&state_ptr->current_frame.free_count, 0);
+        state_ptr->last_frame.freed = stat_exchange(&state_ptr->current_frame.freed, 0);
+    }
+}
+
+memory_frame_stats get_memory_frame_stats() {
+    memory_frame_stats stats = {};
+    if (state_ptr) {
+        stats = state_ptr->last_frame;
+    }
+    return stats;
+}
@@ -26,16 +26,91 @@ typedef enum memory_tag {
     MEMORY_TAG_MAX_TAGS
 } memory_tag;
 
-KAPI void initialize_memory(u64* memory_requirement, void* state);
+// Allocation churn over a single frame.
+typedef struct memory_frame_stats {
+    u64 alloc_count;
+    u64 allocated;
+    u64 free_count;
+    u64 freed;
+} memory_frame_stats;
+
+typedef struct memory_system_configuration {
+    // Total bytes served to tagged allocations out of a single pre-reserved block.
+    // If 0, every allocation goes straight to the platform layer.
+    u64 total_alloc_size;
+} memory_system_configuration;
+
+KAPI b8 initialize_memory(u64* memory_requirement, void* state, memory_system_configuration config);
 KAPI void shutdown_memory(void* state);
 
+// The allocation and free functions below may be called from any number of threads at once, with or
+// without a budget. Only initialize_memory and shutdown_memory must not overlap with them.
+
+// Allocates a zeroed block of memory.
 KAPI void* kallocate(u64 size, memory_tag tag);
+// Allocates a block of memory without clearing it. Contents are undefined.
+KAPI void* kallocate_uninit(u64 size, memory_tag tag);
+// Allocates a zeroed block whose address is a multiple of alignment (a power of 2).
+// Must be released with kfree_aligned.
+KAPI void* kallocate_aligned(u64 size, u16 alignment, memory_tag tag);
 KAPI void kfree(void* block, u64 size, memory_tag tag);
+KAPI void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag);
 KAPI void* kzero_memory(void* block, u64 size);
 KAPI void* kcopy_memory(void* dest, const void* source, u64 size);
 KAPI void* kset_memory(void* dest, i32 value, u64 size);
 
+// A line of usage reported by a system that manages memory kmemory can't see directly (i.e. a driver).
+typedef struct memory_usage_entry {
+    const char* name;
+    u64 size;
+    u64 count;
+} memory_usage_entry;
+
+// Fills out_entries with up to max_entries lines of usage, returning the number written.
+typedef u32 (*PFN_memory_usage_reporter)(void* user_data, memory_usage_entry* out_entries, u32 max_entries);
+
+// Adds a reporter whose entries are included in get_memory_usage_str. Must be unregistered before the memory system shuts down.
+KAPI b8 memory_register_usage_reporter(const char* name, PFN_memory_usage_reporter reporter, void* user_data);
+KAPI void memory_unregister_usage_reporter(PFN_memory_usage_reporter reporter, void* user_data);
+
 // Useful for debugging
 KAPI char* get_memory_usage_str();
 
-KAPI u64 get_memory_alloc_count();
\ No newline at end of file
+KAPI u64 get_memory_alloc_count();
+
+// Snapshots the allocations made since the previous call as the last frame's stats.
+// Should be called once at the end of every frame.
+KAPI void end_memory_frame();
+
+KAPI memory_frame_stats get_memory_frame_stats();
+
+// Allocation tracking records every live allocation along with the file and line it came from, catching
+// double frees and size mismatches in kfree and reporting leaks at shutdown. It is on by default in debug
+// builds and compiled out entirely otherwise. Define KMEMORY_TRACKING as 0 to turn it off in debug.
+#if defined(_DEBUG) && !defined(KMEMORY_TRACKING)
+#define KMEMORY_TRACKING 1
+#endif
+
+#if KMEMORY_TRACKING
+KAPI void* kallocate_tracked(u64 size, memory_tag tag, const char* file, u32 line);
+KAPI void* kallocate_uninit_tracked(u64 size, memory_tag tag, const char* file, u32 line);
+KAPI void* kallocate_aligned_tracked(u64 size, u16 alignment, memory_tag tag, const char* file, u32 line);
+KAPI void kfree_tracked(void* block, u64 size, memory_tag tag, const char* file, u32 line);
+KAPI void kfree_aligned_tracked(void* block, u64 size, u16 alignment, memory_tag tag, const char* file, u32 line);
+
+#define kallocate(size, tag) kallocate_tracked(size, tag, __FILE__, __LINE__)
+#define kallocate_uninit(size, tag) kallocate_uninit_tracked(size, tag, __FILE__, __LINE__)
+#define kallocate_aligned(size, alignment, tag) kallocate_aligned_tracked(size, alignment, tag, __FILE__, __LINE__)
+#define kfree(block, size, tag) kfree_tracked(block, size, tag, __FILE__, __LINE__)
+#define kfree_aligned(block, size, alignment, tag) kfree_aligned_tracked(block, size, alignment, tag, __FILE__, __LINE__)
+
+// The number of allocations currently alive.
+KAPI u64 memory_tracking_live_count();
+// The number of double frees, mismatched sizes and similar errors caught so far.
+KAPI u64 memory_tracking_error_count();
+// Logs every allocation made since the memory system started which has not been freed.
+// Called automatically by shutdown_memory. Returns the number of leaks found.
+KAPI u64 memory_tracking_report_leaks();
+// Logs the call sites currently holding the most memory.
+KAPI void memory_tracking_dump_top_sites(u32 count);
+#endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "defines.h"
+
+// Not recursive: locking a mutex already held by the calling thread deadlocks.
+typedef struct kmutex {
+    void* internal_data;
+} kmutex;
+
+KAPI b8 kmutex_create(kmutex* out_mutex);
+KAPI void kmutex_destroy(kmutex* mutex);
+
+KAPI b8 kmutex_lock(kmutex* mutex);
+// Takes the lock only if it is free, without blocking.
+KAPI b8 kmutex_try_lock(kmutex* mutex);
+KAPI b8 kmutex_unlock(kmutex* mutex);
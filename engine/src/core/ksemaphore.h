@@ -0,0 +1,18 @@
+#pragma once
+
+#include "defines.h"
+
+// A counting semaphore. Waiting takes one from the count, blocking while it is zero.
+typedef struct ksemaphore {
+    void* internal_data;
+} ksemaphore;
+
+KAPI b8 ksemaphore_create(u32 initial_count, ksemaphore* out_semaphore);
+KAPI void ksemaphore_destroy(ksemaphore* semaphore);
+
+// Adds count, waking up to that many waiters.
+KAPI void ksemaphore_signal(ksemaphore* semaphore, u32 count);
+
+KAPI void ksemaphore_wait(ksemaphore* semaphore);
+// Returns false if the count stayed at zero for timeout_ms.
+KAPI b8 ksemaphore_wait_timeout(ksemaphore* semaphore, u64 timeout_ms);
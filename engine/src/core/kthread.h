@@ -0,0 +1,32 @@
+#pragma once
+
+#include "defines.h"
+
+// The value returned is handed back by kthread_join.
+typedef u32 (*pfn_thread_start)(void* params);
+
+typedef struct kthread {
+    // The platform's thread handle.
+    void* internal_data;
+} kthread;
+
+// Starts a thread running start_function_ptr(params).
+KAPI b8 kthread_create(pfn_thread_start start_function_ptr, void* params, kthread* out_thread);
+
+// Blocks until the thread returns and releases it. out_result may be 0.
+KAPI b8 kthread_join(kthread* thread, u32* out_result);
+
+// Lets the thread run on without being joined. Its resources are released when it returns.
+KAPI void kthread_detach(kthread* thread);
+
+// Pins the thread to a single logical processor, 0 to platform_get_processor_count() - 1.
+KAPI b8 kthread_set_affinity(kthread* thread, u32 processor_index);
+
+// Names the thread for debuggers and profilers. Linux keeps the first 15 characters.
+KAPI b8 kthread_set_name(kthread* thread, const char* name);
+
+// The OS id of the calling thread, as shown by debuggers and profilers.
+KAPI u64 kthread_current_id();
+
+// Gives up the rest of the calling thread's time slice.
+KAPI void kthread_yield();
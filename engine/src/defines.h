@@ -20,7 +20,7 @@ typedef _Bool b8;
 #define NULL ((void *)0)
 #endif
 
-#if defined(__clang__) || defined(__gcc__)
+#if defined(__clang__) || defined(__GNUC__)
 #define STATIC_ASSERT _Static_assert
 #else
 #define STATIC_ASSERT static_assert
@@ -17,6 +17,10 @@ typedef struct game {
     // Function pointer to handle resizes, if applicaable
     void (*on_resize)(struct game* game_inst, u32 width, u32 height);
 
+    // Optional. Called once the game loop exits, while the engine's systems are still running,
+    // so anything the game allocated can be released before leaks are reported.
+    void (*shutdown)(struct game* game_inst);
+
     // Game-specific state. Created and managed by the game
     void* state;
 
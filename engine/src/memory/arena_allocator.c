@@ -0,0 +1,118 @@
+#include "arena_allocator.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+// Smallest amount committed at a time when not using large pages.
+#define ARENA_MIN_COMMIT_SIZE (64 * 1024)
+
+static u64 round_up(u64 value, u64 granularity) {
+    return ((value + granularity - 1) / granularity) * granularity;
+}
+
+// Makes sure everything up to end is committed.
+static b8 ensure_committed(arena_allocator* allocator, u64 end) {
+    if (end <= allocator->committed_size) {
+        return true;
+    }
+
+    u64 new_committed = round_up(end, allocator->commit_granularity);
+    if (new_committed > allocator->reserved_size) {
+        new_committed = allocator->reserved_size;
+    }
+    u8* commit_start = (u8*)allocator->memory + allocator->committed_size;
+    if (!platform_commit_memory(commit_start, new_committed - allocator->committed_size)) {
+        KERROR("arena_allocator failed to commit %llu bytes.", new_committed - allocator->committed_size);
+        return false;
+    }
+    allocator->committed_size = new_committed;
+    return true;
+}
+
+b8 arena_allocator_create(u64 reserve_size, b8 large_pages, arena_allocator* out_allocator) {
+    if (!out_allocator || reserve_size == 0) {
+        KERROR("arena_allocator_create requires a valid pointer and a non-zero size.");
+        return false;
+    }
+
+    u64 page_size = platform_page_size();
+    u64 large_page_size = platform_large_page_size();
+    if (large_pages && large_page_size) {
+        page_size = large_page_size;
+    } else {
+        large_pages = false;
+    }
+
+    kzero_memory(out_allocator, sizeof(arena_allocator));
+    out_allocator->reserved_size = round_up(reserve_size, page_size);
+    out_allocator->commit_granularity = page_size > ARENA_MIN_COMMIT_SIZE ? page_size : round_up(ARENA_MIN_COMMIT_SIZE, page_size);
+    out_allocator->large_pages = large_pages;
+    out_allocator->memory = platform_reserve_memory(out_allocator->reserved_size, large_pages);
+    if (!out_allocator->memory) {
+        KERROR("arena_allocator_create failed to reserve %llu bytes.", out_allocator->reserved_size);
+        return false;
+    }
+    return true;
+}
+
+void arena_allocator_destroy(arena_allocator* allocator) {
+    if (allocator && allocator->memory) {
+        platform_release_memory(allocator->memory, allocator->reserved_size);
+        kzero_memory(allocator, sizeof(arena_allocator));
+    }
+}
+
+void* arena_allocator_allocate(arena_allocator* allocator, u64 size) {
+    return arena_allocator_allocate_aligned(allocator, size, 1);
+}
+
+void* arena_allocator_allocate_aligned(arena_allocator* allocator, u64 size, u16 alignment) {
+    if (!allocator || !allocator->memory) {
+        KERROR("arena_allocator_allocate - provided allocator not initialized");
+        return 0;
+    }
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        KERROR("arena_allocator_allocate called with an alignment of %u, which is not a power of 2", alignment);
+        return 0;
+    }
+
+    // The base is page aligned, so aligning the offset aligns the address.
+    u64 offset = (allocator->allocated + alignment - 1) & ~((u64)alignment - 1);
+    if (offset + size > allocator->reserved_size) {
+        KERROR("arena_allocator_allocate tried to allocate %lluB when only %lluB of the reservation remained", size, allocator->reserved_size - allocator->allocated);
+        return 0;
+    }
+    if (!ensure_committed(allocator, offset + size)) {
+        return 0;
+    }
+
+    allocator->allocated = offset + size;
+    return (u8*)allocator->memory + offset;
+}
+
+u64 arena_allocator_get_marker(arena_allocator* allocator) {
+    return allocator ? allocator->allocated : 0;
+}
+
+void arena_allocator_rewind_to_marker(arena_allocator* allocator, u64 marker) {
+    if (!allocator || !allocator->memory) {
+        return;
+    }
+    if (marker > allocator->allocated) {
+        KERROR("arena_allocator_rewind_to_marker - marker %llu is ahead of the current offset %llu", marker, allocator->allocated);
+        return;
+    }
+    allocator->allocated = marker;
+}
+
+void arena_allocator_free_all(arena_allocator* allocator) {
+    if (!allocator || !allocator->memory) {
+        return;
+    }
+    if (allocator->committed_size) {
+        platform_decommit_memory(allocator->memory, allocator->committed_size);
+    }
+    allocator->committed_size = 0;
+    allocator->allocated = 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A linear allocator over a reserved range of virtual address space.
+ * Pages are committed as the arena grows, so a large reservation costs no physical
+ * memory until it is used, and growing never moves existing allocations.
+ */
+typedef struct arena_allocator {
+    u64 reserved_size;
+    u64 committed_size;
+    u64 allocated;
+    // Committing happens in multiples of this to keep the number of system calls down.
+    u64 commit_granularity;
+    b8 large_pages;
+    void* memory;
+} arena_allocator;
+
+/**
+ * @brief Creates an arena by reserving address space.
+ * @param reserve_size The maximum size the arena can grow to. Rounded up to the page size.
+ * @param large_pages Requests large pages from the platform. Treated as a hint.
+ * @param out_allocator A pointer to hold the created arena.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 arena_allocator_create(u64 reserve_size, b8 large_pages, arena_allocator* out_allocator);
+KAPI void arena_allocator_destroy(arena_allocator* allocator);
+
+// Returns zeroed memory, unless it was previously handed out and rewound over.
+KAPI void* arena_allocator_allocate(arena_allocator* allocator, u64 size);
+KAPI void* arena_allocator_allocate_aligned(arena_allocator* allocator, u64 size, u16 alignment);
+
+KAPI u64 arena_allocator_get_marker(arena_allocator* allocator);
+KAPI void arena_allocator_rewind_to_marker(arena_allocator* allocator, u64 marker);
+
+// Frees everything and returns all committed pages to the platform.
+KAPI void arena_allocator_free_all(arena_allocator* allocator);
@@ -0,0 +1,385 @@
+#include "dynamic_allocator.h"
+
+#include "core/logger.h"
+#include "platform/platform.h"
+
+// Every block size and payload address is a multiple of this.
+#define ALIGNMENT_LOG2 4
+#define ALIGNMENT (1 << ALIGNMENT_LOG2)
+
+// Number of second level lists per first level, as a power of 2.
+#define SL_INDEX_COUNT_LOG2 4
+#define SL_INDEX_COUNT (1 << SL_INDEX_COUNT_LOG2)
+
+// Blocks below this size all live in the first level and are split linearly.
+#define FL_INDEX_SHIFT (SL_INDEX_COUNT_LOG2 + ALIGNMENT_LOG2)
+#define SMALL_BLOCK_SIZE (1 << FL_INDEX_SHIFT)
+
+// Largest supported block is 2^FL_INDEX_MAX bytes.
+#define FL_INDEX_MAX 40
+#define FL_INDEX_COUNT (FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+
+#define BLOCK_FREE_BIT 1ull
+#define BLOCK_SIZE_MASK (~(u64)(ALIGNMENT - 1))
+
+// Sits directly in front of every payload.
+typedef struct block_header {
+    struct block_header* prev_physical;
+    // Payload size, with the free flag packed into the low bit.
+    u64 size;
+} block_header;
+
+// Free blocks keep their list links in the (unused) payload.
+typedef struct free_links {
+    block_header* next_free;
+    block_header* prev_free;
+} free_links;
+
+#define BLOCK_HEADER_SIZE sizeof(block_header)
+#define MIN_BLOCK_SIZE sizeof(free_links)
+
+typedef struct dynamic_allocator_state {
+    u64 total_size;
+    u64 free_space;
+    void* memory;
+    // The terminating, always used, block. Stops coalescing from walking off the end.
+    block_header* sentinel;
+
+    u64 fl_bitmap;
+    u32 sl_bitmap[FL_INDEX_COUNT];
+    block_header* free_blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+} dynamic_allocator_state;
+
+STATIC_ASSERT(sizeof(block_header) == ALIGNMENT, "block_header must be exactly one alignment unit.");
+
+static inline u64 block_size(const block_header* block) {
+    return block->size & BLOCK_SIZE_MASK;
+}
+
+static inline b8 block_is_free(const block_header* block) {
+    return (block->size & BLOCK_FREE_BIT) != 0;
+}
+
+static inline void block_set_size(block_header* block, u64 size) {
+    block->size = size | (block->size & BLOCK_FREE_BIT);
+}
+
+static inline void block_set_free(block_header* block, b8 free) {
+    block->size = free ? (block->size | BLOCK_FREE_BIT) : (block->size & ~BLOCK_FREE_BIT);
+}
+
+static inline void* block_to_payload(block_header* block) {
+    return (u8*)block + BLOCK_HEADER_SIZE;
+}
+
+static inline block_header* payload_to_block(void* payload) {
+    return (block_header*)((u8*)payload - BLOCK_HEADER_SIZE);
+}
+
+static inline block_header* block_next(block_header* block) {
+    return (block_header*)((u8*)block_to_payload(block) + block_size(block));
+}
+
+static inline free_links* block_links(block_header* block) {
+    return (free_links*)block_to_payload(block);
+}
+
+static inline u32 find_last_set(u64 value) {
+    return 63 - __builtin_clzll(value);
+}
+
+static inline u32 find_first_set(u64 value) {
+    return __builtin_ctzll(value);
+}
+
+static inline u64 align_up(u64 value, u64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Gets the list a block of the given size belongs in.
+static void mapping_insert(u64 size, u32* out_fl, u32* out_sl) {
+    if (size < SMALL_BLOCK_SIZE) {
+        *out_fl = 0;
+        *out_sl = (u32)(size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+    } else {
+        u32 fl = find_last_set(size);
+        *out_sl = (u32)(size >> (fl - SL_INDEX_COUNT_LOG2)) ^ (1 << SL_INDEX_COUNT_LOG2);
+        *out_fl = fl - (FL_INDEX_SHIFT - 1);
+    }
+}
+
+// Gets the first list whose blocks are all guaranteed to fit the given size.
+static void mapping_search(u64 size, u32* out_fl, u32* out_sl) {
+    if (size >= SMALL_BLOCK_SIZE) {
+        size += (1ull << (find_last_set(size) - SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    mapping_insert(size, out_fl, out_sl);
+}
+
+static void remove_free_block(dynamic_allocator_state* state, block_header* block, u32 fl, u32 sl) {
+    state->free_space -= block_size(block);
+    free_links* links = block_links(block);
+    if (links->next_free) {
+        block_links(links->next_free)->prev_free = links->prev_free;
+    }
+    if (links->prev_free) {
+        block_links(links->prev_free)->next_free = links->next_free;
+    }
+
+    if (state->free_blocks[fl][sl] == block) {
+        state->free_blocks[fl][sl] = links->next_free;
+        if (!links->next_free) {
+            state->sl_bitmap[fl] &= ~(1u << sl);
+            if (!state->sl_bitmap[fl]) {
+                state->fl_bitmap &= ~(1ull << fl);
+            }
+        }
+    }
+}
+
+static void remove_block(dynamic_allocator_state* state, block_header* block) {
+    u32 fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    remove_free_block(state, block, fl, sl);
+}
+
+static void insert_block(dynamic_allocator_state* state, block_header* block) {
+    u32 fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+
+    block_header* head = state->free_blocks[fl][sl];
+    free_links* links = block_links(block);
+    links->next_free = head;
+    links->prev_free = 0;
+    if (head) {
+        block_links(head)->prev_free = block;
+    }
+    state->free_blocks[fl][sl] = block;
+    state->free_space += block_size(block);
+    state->sl_bitmap[fl] |= (1u << sl);
+    state->fl_bitmap |= (1ull << fl);
+}
+
+static block_header* find_suitable_block(dynamic_allocator_state* state, u64 size) {
+    u32 fl, sl;
+    mapping_search(size, &fl, &sl);
+    if (fl >= FL_INDEX_COUNT) {
+        return 0;
+    }
+
+    u32 sl_map = state->sl_bitmap[fl] & (~0u << sl);
+    if (!sl_map) {
+        // Nothing left in this first level, so move up to the next non-empty one.
+        u64 fl_map = (fl + 1 < 64) ? state->fl_bitmap & (~0ull << (fl + 1)) : 0;
+        if (!fl_map) {
+            return 0;
+        }
+        fl = find_first_set(fl_map);
+        sl_map = state->sl_bitmap[fl];
+    }
+    sl = find_first_set(sl_map);
+
+    block_header* block = state->free_blocks[fl][sl];
+    remove_free_block(state, block, fl, sl);
+    return block;
+}
+
+// Splits the tail off of a block if it is large enough to hold another block, returning it to the free lists.
+static void trim_back(dynamic_allocator_state* state, block_header* block, u64 size) {
+    if (block_size(block) < size + BLOCK_HEADER_SIZE + MIN_BLOCK_SIZE) {
+        return;
+    }
+
+    block_header* remaining = (block_header*)((u8*)block_to_payload(block) + size);
+    remaining->prev_physical = block;
+    remaining->size = block_size(block) - size - BLOCK_HEADER_SIZE;
+    block_set_free(remaining, true);
+    block_next(remaining)->prev_physical = remaining;
+    block_set_size(block, size);
+
+    insert_block(state, remaining);
+}
+
+// Absorbs next into block. Both must already be out of the free lists.
+static void merge_blocks(block_header* block, block_header* next) {
+    block_set_size(block, block_size(block) + BLOCK_HEADER_SIZE + block_size(next));
+    block_next(block)->prev_physical = block;
+}
+
+static u64 adjust_size(u64 size) {
+    size = align_up(size, ALIGNMENT);
+    return size < MIN_BLOCK_SIZE ? MIN_BLOCK_SIZE : size;
+}
+
+b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator) {
+    if (total_size < SMALL_BLOCK_SIZE) {
+        KERROR("dynamic_allocator_create cannot have a total_size smaller than %u.", SMALL_BLOCK_SIZE);
+        return false;
+    }
+    if (total_size >= (1ull << FL_INDEX_MAX)) {
+        KERROR("dynamic_allocator_create cannot have a total_size of 2^%u or larger.", FL_INDEX_MAX);
+        return false;
+    }
+    if (!memory_requirement) {
+        KERROR("dynamic_allocator_create requires memory_requirement to be non-null.");
+        return false;
+    }
+
+    total_size = align_up(total_size, ALIGNMENT);
+    u64 state_size = align_up(sizeof(dynamic_allocator_state), ALIGNMENT);
+    // The extra alignment unit covers a provided block that is only 8 byte aligned.
+    // The extra headers are the first block's and the sentinel.
+    *memory_requirement = state_size + ALIGNMENT + total_size + BLOCK_HEADER_SIZE * 2;
+    if (!memory) {
+        return true;
+    }
+
+    out_allocator->memory = memory;
+    dynamic_allocator_state* state = out_allocator->memory;
+    platform_zero_memory(state, sizeof(dynamic_allocator_state));
+    state->total_size = total_size;
+    state->memory = (void*)align_up((u64)memory + state_size, ALIGNMENT);
+
+    block_header* block = state->memory;
+    block->prev_physical = 0;
+    block->size = total_size;
+    block_set_free(block, true);
+
+    state->sentinel = block_next(block);
+    state->sentinel->prev_physical = block;
+    state->sentinel->size = 0;
+
+    insert_block(state, block);
+    return true;
+}
+
+void dynamic_allocator_destroy(dynamic_allocator* allocator) {
+    if (allocator && allocator->memory) {
+        platform_zero_memory(allocator->memory, sizeof(dynamic_allocator_state));
+        allocator->memory = 0;
+    }
+}
+
+void* dynamic_allocator_allocate(dynamic_allocator* allocator, u64 size) {
+    if (!allocator || !allocator->memory || size == 0) {
+        KERROR("dynamic_allocator_allocate requires a valid allocator and a non-zero size.");
+        return 0;
+    }
+
+    dynamic_allocator_state* state = allocator->memory;
+    u64 adjusted_size = adjust_size(size);
+    block_header* block = find_suitable_block(state, adjusted_size);
+    if (!block) {
+        KERROR("dynamic_allocator_allocate has no block large enough for %lluB (%lluB free).", size, state->free_space);
+        return 0;
+    }
+
+    trim_back(state, block, adjusted_size);
+    block_set_free(block, false);
+    return block_to_payload(block);
+}
+
+void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size, u16 alignment) {
+    if (alignment <= ALIGNMENT) {
+        return dynamic_allocator_allocate(allocator, size);
+    }
+    if (!allocator || !allocator->memory || size == 0 || (alignment & (alignment - 1)) != 0) {
+        KERROR("dynamic_allocator_allocate_aligned requires a valid allocator, a non-zero size and a power of 2 alignment.");
+        return 0;
+    }
+
+    dynamic_allocator_state* state = allocator->memory;
+    u64 adjusted_size = adjust_size(size);
+    // Enough room for the worst case gap, plus a free block to hold the gap itself.
+    u64 gap_minimum = BLOCK_HEADER_SIZE + MIN_BLOCK_SIZE;
+    block_header* block = find_suitable_block(state, adjusted_size + alignment + gap_minimum);
+    if (!block) {
+        KERROR("dynamic_allocator_allocate_aligned has no block large enough for %lluB aligned to %u (%lluB free).", size, alignment, state->free_space);
+        return 0;
+    }
+
+    u64 payload = (u64)block_to_payload(block);
+    u64 aligned = align_up(payload, alignment);
+    u64 gap = aligned - payload;
+    if (gap && gap < gap_minimum) {
+        // Too small to hold a block of its own, so move to the next aligned address.
+        aligned = align_up(payload + gap_minimum, alignment);
+        gap = aligned - payload;
+    }
+
+    if (gap) {
+        // Split the gap off the front as its own free block.
+        block_header* aligned_block = payload_to_block((void*)aligned);
+        aligned_block->prev_physical = block;
+        aligned_block->size = block_size(block) - gap;
+        block_next(aligned_block)->prev_physical = aligned_block;
+
+        block_set_size(block, gap - BLOCK_HEADER_SIZE);
+        block_set_free(block, true);
+        insert_block(state, block);
+
+        block = aligned_block;
+    }
+
+    trim_back(state, block, adjusted_size);
+    block_set_free(block, false);
+    return block_to_payload(block);
+}
+
+b8 dynamic_allocator_free(dynamic_allocator* allocator, void* block) {
+    if (!allocator || !block) {
+        KERROR("dynamic_allocator_free requires a valid allocator and block.");
+        return false;
+    }
+    if (!dynamic_allocator_owns(allocator, block)) {
+        KERROR("dynamic_allocator_free called with a block (%p) outside of the allocator's range.", block);
+        return false;
+    }
+
+    dynamic_allocator_state* state = allocator->memory;
+    block_header* header = payload_to_block(block);
+    if (block_is_free(header)) {
+        KERROR("dynamic_allocator_free called on a block (%p) which is already free.", block);
+        return false;
+    }
+
+    block_set_free(header, true);
+
+    block_header* prev = header->prev_physical;
+    if (prev && block_is_free(prev)) {
+        remove_block(state, prev);
+        merge_blocks(prev, header);
+        header = prev;
+    }
+
+    block_header* next = block_next(header);
+    if (block_is_free(next)) {
+        remove_block(state, next);
+        merge_blocks(header, next);
+    }
+
+    insert_block(state, header);
+    return true;
+}
+
+b8 dynamic_allocator_owns(dynamic_allocator* allocator, void* block) {
+    if (!allocator || !allocator->memory) {
+        return false;
+    }
+    dynamic_allocator_state* state = allocator->memory;
+    return (u8*)block >= (u8*)state->memory && (u8*)block < (u8*)state->sentinel;
+}
+
+u64 dynamic_allocator_free_space(dynamic_allocator* allocator) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+    return ((dynamic_allocator_state*)allocator->memory)->free_space;
+}
+
+u64 dynamic_allocator_total_space(dynamic_allocator* allocator) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+    return ((dynamic_allocator_state*)allocator->memory)->total_size;
+}
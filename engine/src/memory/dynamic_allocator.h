@@ -0,0 +1,37 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A general purpose allocator which manages a single pre-reserved block of memory.
+ * Free blocks are kept in segregated lists (two-level, TLSF style) indexed through bitmaps,
+ * so both allocation and free run in constant time. Adjacent free blocks are always coalesced.
+ */
+typedef struct dynamic_allocator {
+    // Internal state, stored at the front of the managed memory.
+    void* memory;
+} dynamic_allocator;
+
+/**
+ * @brief Creates a dynamic allocator. Call once with memory set to 0 to obtain the memory requirement,
+ * then again with a block of at least that size.
+ * @param total_size The number of bytes that should be available for allocations.
+ * @param memory_requirement A pointer to hold the memory requirement for the allocator and its state.
+ * @param memory The block to be managed, or 0 when only querying the requirement.
+ * @param out_allocator A pointer to hold the created allocator.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator);
+KAPI void dynamic_allocator_destroy(dynamic_allocator* allocator);
+
+// Returns a 16 byte aligned block, or 0 if there is no free block large enough.
+KAPI void* dynamic_allocator_allocate(dynamic_allocator* allocator, u64 size);
+// Returns a block aligned to alignment (a power of 2), or 0 if there is no free block large enough.
+KAPI void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size, u16 alignment);
+// Returns false if the block was not allocated from this allocator.
+KAPI b8 dynamic_allocator_free(dynamic_allocator* allocator, void* block);
+
+// Indicates if the given block lies within the memory managed by the allocator.
+KAPI b8 dynamic_allocator_owns(dynamic_allocator* allocator, void* block);
+KAPI u64 dynamic_allocator_free_space(dynamic_allocator* allocator);
+KAPI u64 dynamic_allocator_total_space(dynamic_allocator* allocator);
@@ -0,0 +1,62 @@
+#include "frame_allocator.h"
+
+#include "core/logger.h"
+#include "memory/linear_allocator.h"
+
+#define FRAME_ALIGNMENT 16
+#define ALIGN_UP(value) (((value) + FRAME_ALIGNMENT - 1) & ~((u64)FRAME_ALIGNMENT - 1))
+
+typedef struct frame_allocator_state {
+    linear_allocator frames[2];
+    u8 current_frame;
+} frame_allocator_state;
+
+static frame_allocator_state* state_ptr;
+
+void frame_allocator_initialize(u64* memory_requirement, void* state, u64 frame_size) {
+    // Each frame starts on an aligned boundary, wherever the state block happens to land.
+    u64 aligned_frame_size = ALIGN_UP(frame_size);
+    *memory_requirement = sizeof(frame_allocator_state) + FRAME_ALIGNMENT - 1 + aligned_frame_size * 2;
+    if (state == 0) {
+        return;
+    }
+
+    state_ptr = state;
+    state_ptr->current_frame = 0;
+    u8* frame_memory = (u8*)ALIGN_UP((u64)state + sizeof(frame_allocator_state));
+    for (u32 i = 0; i < 2; ++i) {
+        linear_allocator_create(aligned_frame_size, frame_memory + aligned_frame_size * i, &state_ptr->frames[i]);
+    }
+}
+
+void frame_allocator_shutdown(void* state) {
+    if (state_ptr) {
+        for (u32 i = 0; i < 2; ++i) {
+            linear_allocator_destroy(&state_ptr->frames[i]);
+        }
+    }
+    state_ptr = 0;
+}
+
+void* frame_alloc(u64 size) {
+    if (!state_ptr) {
+        KERROR("frame_alloc called before the frame allocator was initialized.");
+        return 0;
+    }
+    return linear_allocator_allocate_aligned(&state_ptr->frames[state_ptr->current_frame], size, FRAME_ALIGNMENT);
+}
+
+void frame_allocator_end_frame() {
+    if (state_ptr) {
+        state_ptr->current_frame ^= 1;
+        // Everything in here is from two frames ago, so nothing can still be reading it.
+        linear_allocator_reset(&state_ptr->frames[state_ptr->current_frame]);
+    }
+}
+
+u64 frame_allocator_allocated() {
+    if (state_ptr) {
+        return state_ptr->frames[state_ptr->current_frame].allocated;
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Scratch memory for data which only needs to live for a frame or two.
+ * Two linear allocators are used in turn; the one which was used two frames ago is
+ * reset at the end of each frame, so anything allocated in frame N stays valid until
+ * frame N+1 ends. Memory is never zeroed, on allocation or on reset.
+ */
+
+/**
+ * @brief Initializes the frame allocator. Call once with state set to 0 to obtain the memory
+ * requirement, then again with a block of at least that size.
+ * @param memory_requirement A pointer to hold the memory requirement.
+ * @param state The block to use for the state and both frames' memory, or 0 when querying.
+ * @param frame_size The number of bytes available to each frame. Alignment padding comes out of this.
+ */
+KAPI void frame_allocator_initialize(u64* memory_requirement, void* state, u64 frame_size);
+KAPI void frame_allocator_shutdown(void* state);
+
+// Returns uninitialized, 16 byte aligned memory which remains valid until the end of the next frame.
+KAPI void* frame_alloc(u64 size);
+
+// Swaps to the other frame's memory and resets it. Called by the application at the end of every frame.
+KAPI void frame_allocator_end_frame();
+
+// The number of bytes allocated so far in the current frame.
+KAPI u64 frame_allocator_allocated();
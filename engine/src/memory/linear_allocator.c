@@ -9,11 +9,12 @@ void linear_allocator_create(u64 total_size, void* memory, linear_allocator* out
     }
     out_allocator->total_size = total_size;
     out_allocator->allocated = 0;
+    out_allocator->high_water = 0;
     if (memory) {
         out_allocator->memory = memory;
-        out_allocator->owns_memory = true;
-    } else {
         out_allocator->owns_memory = false;
+    } else {
+        out_allocator->owns_memory = true;
         out_allocator->memory = kallocate(total_size, MEMORY_TAG_LINEAR_ALLOCATOR);
     }
 }
@@ -27,6 +28,7 @@ void linear_allocator_destroy(linear_allocator* allocator) {
     }
     allocator->memory = NULL;
     allocator->allocated = 0;
+    allocator->high_water = 0;
     allocator->total_size = 0;
     allocator->owns_memory = false;
 }
@@ -45,13 +47,60 @@ void* linear_allocator_allocate(linear_allocator* allocator, u64 size) {
 
     void* block = allocator->memory + allocator->allocated;
     allocator->allocated += size;
+    if (allocator->allocated > allocator->high_water) {
+        allocator->high_water = allocator->allocated;
+    }
     return block;
 }
 
+void* linear_allocator_allocate_aligned(linear_allocator* allocator, u64 size, u16 alignment) {
+    if (!allocator || !allocator->memory) {
+        KERROR("linear_allocator_allocate_aligned - provided allocator not initialized");
+        return NULL;
+    }
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        KERROR("linear_allocator_allocate_aligned called with an alignment of %u, which is not a power of 2", alignment);
+        return NULL;
+    }
+
+    u64 address = (u64)allocator->memory + allocator->allocated;
+    u64 padding = ((address + alignment - 1) & ~((u64)alignment - 1)) - address;
+    if (allocator->allocated + padding + size > allocator->total_size) {
+        u64 remaining = allocator->total_size - allocator->allocated;
+        KERROR("linear_allocator_allocate_aligned tried to allocate %lluB (plus %lluB padding) when only %lluB remained", size, padding, remaining);
+        return NULL;
+    }
+
+    allocator->allocated += padding;
+    return linear_allocator_allocate(allocator, size);
+}
+
+u64 linear_allocator_get_marker(linear_allocator* allocator) {
+    return allocator ? allocator->allocated : 0;
+}
+
+void linear_allocator_rewind_to_marker(linear_allocator* allocator, u64 marker) {
+    if (!allocator || !allocator->memory) {
+        return;
+    }
+    if (marker > allocator->allocated) {
+        KERROR("linear_allocator_rewind_to_marker - marker %llu is ahead of the current offset %llu", marker, allocator->allocated);
+        return;
+    }
+    allocator->allocated = marker;
+}
+
 void linear_allocator_free_all(linear_allocator* allocator) {
     if (allocator && allocator->memory) {
         allocator->allocated = 0;
-        // TODO: Should we do an owns_memory check here?
-        kzero_memory(allocator->memory, allocator->total_size);
+        // Nothing past the high water mark has been handed out since the last clear.
+        kzero_memory(allocator->memory, allocator->high_water);
+        allocator->high_water = 0;
+    }
+}
+
+void linear_allocator_reset(linear_allocator* allocator) {
+    if (allocator && allocator->memory) {
+        allocator->allocated = 0;
     }
-}
\ No newline at end of file
+}
@@ -5,6 +5,8 @@
 typedef struct linear_allocator {
     u64 total_size;
     u64 allocated;
+    // Highest allocated offset since memory was last zeroed. Bounds the clear in free_all.
+    u64 high_water;
     void* memory;
     b8 owns_memory;
 } linear_allocator;
@@ -13,4 +15,16 @@ KAPI void linear_allocator_create(u64 total_size, void* memory, linear_allocator
 KAPI void linear_allocator_destroy(linear_allocator* allocator);
 
 KAPI void* linear_allocator_allocate(linear_allocator* allocator, u64 size);
+// Pads the current offset so the returned address is a multiple of alignment (a power of 2).
+KAPI void* linear_allocator_allocate_aligned(linear_allocator* allocator, u64 size, u16 alignment);
+
+// Gets the current offset, which can later be rewound to in order to free everything allocated after it.
+KAPI u64 linear_allocator_get_marker(linear_allocator* allocator);
+// Frees everything allocated since the marker was taken. Memory is not zeroed.
+KAPI void linear_allocator_rewind_to_marker(linear_allocator* allocator, u64 marker);
+
+// Frees everything and zeroes all memory handed out since the last free_all.
 KAPI void linear_allocator_free_all(linear_allocator* allocator);
+// Like linear_allocator_free_all, but leaves the old contents in place instead of zeroing them.
+// The high water mark is kept, so a later free_all still clears them.
+KAPI void linear_allocator_reset(linear_allocator* allocator);
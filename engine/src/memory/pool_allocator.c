@@ -0,0 +1,136 @@
+#include "pool_allocator.h"
+
+#include "core/logger.h"
+
+static u64 get_element_size(u64 element_size) {
+    if (element_size < sizeof(void*)) {
+        element_size = sizeof(void*);
+    }
+    // Keep every slot 8 byte aligned.
+    return (element_size + 7) & ~7ull;
+}
+
+// Pushes every slot in the given range onto the front of the free list.
+static void push_range(pool_allocator* allocator, void* memory) {
+    u8* elements = memory;
+    for (u64 i = allocator->elements_per_block; i > 0; --i) {
+        void** slot = (void**)(elements + (i - 1) * allocator->element_size);
+        *slot = allocator->free_list;
+        allocator->free_list = slot;
+    }
+}
+
+static b8 grow(pool_allocator* allocator) {
+    u64 block_size = sizeof(pool_allocator_block) + allocator->element_size * allocator->elements_per_block;
+    pool_allocator_block* block = kallocate_uninit(block_size, allocator->tag);
+    if (!block) {
+        return false;
+    }
+    block->next = allocator->extra_blocks;
+    allocator->extra_blocks = block;
+    allocator->capacity += allocator->elements_per_block;
+    push_range(allocator, block + 1);
+    return true;
+}
+
+u64 pool_allocator_memory_requirement(u64 element_size, u64 element_count) {
+    return get_element_size(element_size) * element_count;
+}
+
+b8 pool_allocator_create(u64 element_size, u64 elements_per_block, void* memory, b8 can_grow, memory_tag tag, pool_allocator* out_allocator) {
+    if (!out_allocator || element_size == 0 || elements_per_block == 0) {
+        KERROR("pool_allocator_create requires a valid pointer, element size and element count.");
+        return false;
+    }
+
+    out_allocator->element_size = get_element_size(element_size);
+    out_allocator->elements_per_block = elements_per_block;
+    out_allocator->capacity = elements_per_block;
+    out_allocator->allocated_count = 0;
+    out_allocator->tag = tag;
+    out_allocator->can_grow = can_grow;
+    out_allocator->extra_blocks = 0;
+    out_allocator->free_list = 0;
+
+    if (memory) {
+        out_allocator->memory = memory;
+        out_allocator->owns_memory = false;
+    } else {
+        out_allocator->memory = kallocate_uninit(out_allocator->element_size * elements_per_block, tag);
+        out_allocator->owns_memory = true;
+        if (!out_allocator->memory) {
+            KERROR("pool_allocator_create - failed to allocate %llu elements.", elements_per_block);
+            return false;
+        }
+    }
+
+    push_range(out_allocator, out_allocator->memory);
+    return true;
+}
+
+void pool_allocator_destroy(pool_allocator* allocator) {
+    if (!allocator) {
+        return;
+    }
+
+    u64 block_size = sizeof(pool_allocator_block) + allocator->element_size * allocator->elements_per_block;
+    pool_allocator_block* block = allocator->extra_blocks;
+    while (block) {
+        pool_allocator_block* next = block->next;
+        kfree(block, block_size, allocator->tag);
+        block = next;
+    }
+
+    if (allocator->owns_memory && allocator->memory) {
+        kfree(allocator->memory, allocator->element_size * allocator->elements_per_block, allocator->tag);
+    }
+
+    kzero_memory(allocator, sizeof(pool_allocator));
+}
+
+void* pool_allocator_allocate(pool_allocator* allocator) {
+    if (!allocator || !allocator->memory) {
+        KERROR("pool_allocator_allocate - provided allocator not initialized");
+        return 0;
+    }
+
+    if (!allocator->free_list) {
+        if (!allocator->can_grow) {
+            KERROR("pool_allocator_allocate - pool is full (%llu elements) and cannot grow.", allocator->capacity);
+            return 0;
+        }
+        if (!grow(allocator)) {
+            KERROR("pool_allocator_allocate - failed to grow pool.");
+            return 0;
+        }
+    }
+
+    void** slot = allocator->free_list;
+    allocator->free_list = *slot;
+    allocator->allocated_count++;
+    return slot;
+}
+
+void pool_allocator_free(pool_allocator* allocator, void* element) {
+    if (!allocator || !element) {
+        return;
+    }
+
+    void** slot = element;
+    *slot = allocator->free_list;
+    allocator->free_list = slot;
+    allocator->allocated_count--;
+}
+
+void pool_allocator_free_all(pool_allocator* allocator) {
+    if (!allocator || !allocator->memory) {
+        return;
+    }
+
+    allocator->free_list = 0;
+    allocator->allocated_count = 0;
+    push_range(allocator, allocator->memory);
+    for (pool_allocator_block* block = allocator->extra_blocks; block; block = block->next) {
+        push_range(allocator, block + 1);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "core/kmemory.h"
+#include "defines.h"
+
+// Header placed at the start of every block the pool allocates for itself.
+typedef struct pool_allocator_block {
+    struct pool_allocator_block* next;
+    u64 padding;
+} pool_allocator_block;
+
+typedef struct pool_allocator {
+    // Size of a single slot. Always at least pointer sized and a multiple of 8.
+    u64 element_size;
+    u64 elements_per_block;
+    u64 capacity;
+    u64 allocated_count;
+    memory_tag tag;
+    b8 can_grow;
+
+    // First block of elements. May be provided by the caller.
+    void* memory;
+    b8 owns_memory;
+
+    // Additional blocks chained on when the pool grows.
+    pool_allocator_block* extra_blocks;
+
+    // Intrusive singly linked list threaded through the free slots.
+    void* free_list;
+} pool_allocator;
+
+/**
+ * @brief Gets the number of bytes required to back element_count elements of element_size.
+ * Used to provide memory to pool_allocator_create.
+ */
+KAPI u64 pool_allocator_memory_requirement(u64 element_size, u64 element_count);
+
+/**
+ * @brief Creates a pool of fixed size elements.
+ * @param element_size The size of a single element.
+ * @param elements_per_block The number of elements in the first block, and each block added when growing.
+ * @param memory Optional block of at least pool_allocator_memory_requirement bytes. If 0, the pool allocates its own.
+ * @param can_grow Indicates if the pool should chain on a new block when full.
+ * @param tag The memory tag used for any memory the pool allocates.
+ * @param out_allocator A pointer to hold the created pool.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 pool_allocator_create(u64 element_size, u64 elements_per_block, void* memory, b8 can_grow, memory_tag tag, pool_allocator* out_allocator);
+KAPI void pool_allocator_destroy(pool_allocator* allocator);
+
+// Returns an uninitialized element, or 0 if the pool is full and cannot grow.
+KAPI void* pool_allocator_allocate(pool_allocator* allocator);
+KAPI void pool_allocator_free(pool_allocator* allocator, void* element);
+
+// Returns every element to the pool. Grown blocks are kept for reuse.
+KAPI void pool_allocator_free_all(pool_allocator* allocator);
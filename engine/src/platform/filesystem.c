@@ -91,9 +91,12 @@ KAPI b8 filesystem_read_all(file_handle* handle, u8** out_bytes, u64* out_bytes_
         u64 size = ftell((FILE*)handle->handle);
         rewind((FILE*)handle->handle);
 
-        *out_bytes = kallocate(sizeof(u8) * size, MEMORY_TAG_STRING);
+        *out_bytes = kallocate_uninit(sizeof(u8) * size, MEMORY_TAG_STRING);
         *out_bytes_read = fread(*out_bytes, 1, size, (FILE*)handle->handle);
         if (*out_bytes_read != size) {
+            // Released here, since the caller only knows how much was read, not how much was allocated.
+            kfree(*out_bytes, sizeof(u8) * size, MEMORY_TAG_STRING);
+            *out_bytes = 0;
             return false;
         }
         return true;
@@ -24,6 +24,8 @@ KAPI b8 filesystem_write_line(file_handle* handle, const char* line);
 
 KAPI b8 filesystem_read(file_handle* handle, u64 data_size, void* out_data, u64* out_bytes_read);
 
+// Reads the whole file into a buffer allocated with MEMORY_TAG_STRING, which the caller frees using out_bytes_read.
+// On a short read the buffer is freed here and out_bytes is set to 0.
 KAPI b8 filesystem_read_all(file_handle* handle, u8** out_bytes, u64* out_bytes_read);
 
 KAPI b8 filesystem_write(file_handle* handle, u64 data_size, const void* data, u64* out_bytes_written);
@@ -2,6 +2,7 @@
 
 #include "defines.h"
 
+// When headless is set no window is created and there is no input; everything else works as normal.
 KAPI b8 platform_startup(
     u64* memory_requirement,
     void* state,
@@ -9,7 +10,8 @@ KAPI b8 platform_startup(
     i32 x,
     i32 y,
     i32 width,
-    i32 height);
+    i32 height,
+    b8 headless);
 
 void platform_shutdown(void* plat_state);
 
@@ -17,6 +19,27 @@ b8 platform_pump_messages();
 
 void* platform_allocate(u64 size, b8 aligned);
 void platform_free(void* block, b8 aligned);
+// Allocates a block whose address is a multiple of alignment, which must be a power of 2.
+// Blocks from this function must be released with platform_free_aligned.
+void* platform_allocate_aligned(u64 size, u16 alignment);
+void platform_free_aligned(void* block);
+
+// Virtual memory. Address space is reserved up front and only backed by physical memory once committed.
+// All addresses and sizes must be multiples of platform_page_size (or platform_large_page_size for
+// ranges reserved with large pages).
+u64 platform_page_size();
+// The size of a large (huge) page, or 0 if the platform does not support them.
+u64 platform_large_page_size();
+// Reserves a range of address space without backing it. When large_pages is set the platform is
+// asked to back the range with large pages, which is treated as a hint.
+void* platform_reserve_memory(u64 size, b8 large_pages);
+// Backs part of a reserved range so it can be read and written. Newly committed memory is zeroed.
+b8 platform_commit_memory(void* address, u64 size);
+// Returns the physical memory behind part of a range, leaving it reserved.
+void platform_decommit_memory(void* address, u64 size);
+// Releases an entire range. size must match the size given to platform_reserve_memory.
+void platform_release_memory(void* address, u64 size);
+
 void* platform_zero_memory(void* block, u64 size);
 void* platform_copy_memory(void* dest, const void* source, u64 size);
 void* platform_set_memory(void* dest, i32 value, u64 size);
@@ -29,3 +52,6 @@ f64 platform_get_absolute_time();
 // Sleep on the thread for the provided ms. This blocks the main thread.
 // Should only be used for giving time back to the OS for unused updated power.
 void platform_sleep(u64 ms);
+
+// The number of logical processors available to the process.
+KAPI u32 platform_get_processor_count();
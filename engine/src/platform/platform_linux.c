@@ -0,0 +1,825 @@
+// pthread_setaffinity_np, pthread_setname_np and CPU_SET.
+#define _GNU_SOURCE
+
+#include "platform/platform.h"
+
+#if K_PLATFORM_LINUX
+
+#include "containers/darray.h"
+
+#include "core/event.h"
+#include "core/input.h"
+#include "core/katomic.h"
+#include "core/kcondvar.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kthread.h"
+#include "core/logger.h"
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <X11/keysym.h>
+#include <xcb/xcb.h>
+
+// TODO: Find a way to keep all this vulkan stuff out of the platform code
+#include "renderer/vulkan/vulkan_types.inl"
+#define VK_USE_PLATFORM_XCB_KHR
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_xcb.h>
+
+typedef struct platform_state {
+    b8 headless;
+    xcb_connection_t* connection;
+    xcb_window_t window;
+    xcb_screen_t* screen;
+    xcb_atom_t wm_protocols;
+    xcb_atom_t wm_delete_win;
+    // Keycode to keysym table, fetched once at startup.
+    xcb_get_keyboard_mapping_reply_t* keyboard_mapping;
+    xcb_keycode_t min_keycode;
+    VkSurfaceKHR surface;
+} platform_state;
+
+static platform_state* state_ptr;
+
+// Transparent huge pages on x86_64 and aarch64 (with 4k base pages).
+#define LINUX_LARGE_PAGE_SIZE (2 * 1024 * 1024)
+
+static keys translate_keycode(u32 x_keycode);
+
+static xcb_atom_t intern_atom(xcb_connection_t* connection, const char* name) {
+    xcb_intern_atom_cookie_t cookie = xcb_intern_atom(connection, 0, strlen(name), name);
+    xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(connection, cookie, NULL);
+    if (!reply) {
+        return XCB_ATOM_NONE;
+    }
+    xcb_atom_t atom = reply->atom;
+    free(reply);
+    return atom;
+}
+
+b8 platform_startup(
+    u64* memory_requirement,
+    void* state,
+    const char* application_name,
+    i32 x,
+    i32 y,
+    i32 width,
+    i32 height,
+    b8 headless) {
+    *memory_requirement = sizeof(platform_state);
+    if (state == 0) {
+        return true;
+    }
+    state_ptr = state;
+    state_ptr->headless = headless;
+
+    if (headless) {
+        return true;
+    }
+
+    int screen_index = 0;
+    state_ptr->connection = xcb_connect(NULL, &screen_index);
+    if (xcb_connection_has_error(state_ptr->connection)) {
+        KFATAL("Failed to connect to X server via XCB. Set DISPLAY or run headless.");
+        xcb_disconnect(state_ptr->connection);
+        state_ptr->connection = 0;
+        return false;
+    }
+
+    const xcb_setup_t* setup = xcb_get_setup(state_ptr->connection);
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(setup);
+    for (i32 s = screen_index; s > 0; s--) {
+        xcb_screen_next(&it);
+    }
+    state_ptr->screen = it.data;
+
+    state_ptr->window = xcb_generate_id(state_ptr->connection);
+
+    u32 event_mask = XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK;
+    u32 event_values = XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
+                       XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
+                       XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_POINTER_MOTION |
+                       XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+    u32 value_list[] = {state_ptr->screen->black_pixel, event_values};
+
+    xcb_create_window(
+        state_ptr->connection,
+        XCB_COPY_FROM_PARENT,
+        state_ptr->window,
+        state_ptr->screen->root,
+        x,
+        y,
+        width,
+        height,
+        0,
+        XCB_WINDOW_CLASS_INPUT_OUTPUT,
+        state_ptr->screen->root_visual,
+        event_mask,
+        value_list);
+
+    xcb_change_property(
+        state_ptr->connection,
+        XCB_PROP_MODE_REPLACE,
+        state_ptr->window,
+        XCB_ATOM_WM_NAME,
+        XCB_ATOM_STRING,
+        8,
+        strlen(application_name),
+        application_name);
+
+    // Ask the window manager to send a message on close instead of killing the connection.
+    state_ptr->wm_protocols = intern_atom(state_ptr->connection, "WM_PROTOCOLS");
+    state_ptr->wm_delete_win = intern_atom(state_ptr->connection, "WM_DELETE_WINDOW");
+    xcb_change_property(
+        state_ptr->connection,
+        XCB_PROP_MODE_REPLACE,
+        state_ptr->window,
+        state_ptr->wm_protocols,
+        XCB_ATOM_ATOM,
+        32,
+        1,
+        &state_ptr->wm_delete_win);
+
+    state_ptr->min_keycode = setup->min_keycode;
+    xcb_get_keyboard_mapping_cookie_t mapping_cookie = xcb_get_keyboard_mapping(
+        state_ptr->connection,
+        setup->min_keycode,
+        setup->max_keycode - setup->min_keycode + 1);
+    state_ptr->keyboard_mapping = xcb_get_keyboard_mapping_reply(state_ptr->connection, mapping_cookie, NULL);
+
+    xcb_map_window(state_ptr->connection, state_ptr->window);
+
+    i32 stream_result = xcb_flush(state_ptr->connection);
+    if (stream_result <= 0) {
+        KFATAL("An error occurred when flusing the stream: %d", stream_result);
+        return false;
+    }
+
+    return true;
+}
+
+void platform_shutdown(void* plat_state) {
+    if (!state_ptr) {
+        return;
+    }
+    if (state_ptr->keyboard_mapping) {
+        free(state_ptr->keyboard_mapping);
+        state_ptr->keyboard_mapping = 0;
+    }
+    if (state_ptr->connection) {
+        xcb_destroy_window(state_ptr->connection, state_ptr->window);
+        xcb_disconnect(state_ptr->connection);
+        state_ptr->connection = 0;
+    }
+}
+
+static void handle_event(xcb_generic_event_t* event) {
+    switch (event->response_type & ~0x80) {
+        case XCB_KEY_PRESS:
+        case XCB_KEY_RELEASE: {
+            xcb_key_press_event_t* kb_event = (xcb_key_press_event_t*)event;
+            b8 pressed = (event->response_type & ~0x80) == XCB_KEY_PRESS;
+            keys key = translate_keycode(kb_event->detail);
+            if (key) {
+                input_process_key(key, pressed);
+            }
+        } break;
+        case XCB_BUTTON_PRESS:
+        case XCB_BUTTON_RELEASE: {
+            xcb_button_press_event_t* mouse_event = (xcb_button_press_event_t*)event;
+            b8 pressed = (event->response_type & ~0x80) == XCB_BUTTON_PRESS;
+            switch (mouse_event->detail) {
+                case XCB_BUTTON_INDEX_1:
+                    input_process_mouse_button(BUTTON_LEFT, pressed);
+                    break;
+                case XCB_BUTTON_INDEX_2:
+                    input_process_mouse_button(BUTTON_MIDDLE, pressed);
+                    break;
+                case XCB_BUTTON_INDEX_3:
+                    input_process_mouse_button(BUTTON_RIGHT, pressed);
+                    break;
+                // X reports the wheel as buttons 4 (up) and 5 (down).
+                case XCB_BUTTON_INDEX_4:
+                    if (pressed) {
+                        input_process_mouse_wheel(1);
+                    }
+                    break;
+                case XCB_BUTTON_INDEX_5:
+                    if (pressed) {
+                        input_process_mouse_wheel(-1);
+                    }
+                    break;
+            }
+        } break;
+        case XCB_MOTION_NOTIFY: {
+            xcb_motion_notify_event_t* move_event = (xcb_motion_notify_event_t*)event;
+            input_process_mouse_move(move_event->event_x, move_event->event_y);
+        } break;
+        case XCB_CONFIGURE_NOTIFY: {
+            // Also sent for moves; the application ignores resizes which don't change the size.
+            xcb_configure_notify_event_t* configure_event = (xcb_configure_notify_event_t*)event;
+            event_context context;
+            context.data.u16[0] = configure_event->width;
+            context.data.u16[1] = configure_event->height;
+            event_fire(EVENT_CODE_RESIZE, 0, context);
+        } break;
+        case XCB_CLIENT_MESSAGE: {
+            xcb_client_message_event_t* cm = (xcb_client_message_event_t*)event;
+            if (cm->data.data32[0] == state_ptr->wm_delete_win) {
+                event_context data = {};
+                event_fire(EVENT_CODE_APPLICATION_QUIT, 0, data);
+            }
+        } break;
+        default:
+            break;
+    }
+}
+
+b8 platform_pump_messages() {
+    if (!state_ptr || !state_ptr->connection) {
+        return true;
+    }
+
+    xcb_generic_event_t* event = xcb_poll_for_event(state_ptr->connection);
+    while (event) {
+        xcb_generic_event_t* next = 0;
+        if ((event->response_type & ~0x80) == XCB_KEY_RELEASE) {
+            // Key repeat shows up as a release immediately followed by a press with the same
+            // keycode and timestamp. Drop the pair so a held key stays down.
+            next = xcb_poll_for_event(state_ptr->connection);
+            if (next && (next->response_type & ~0x80) == XCB_KEY_PRESS) {
+                xcb_key_release_event_t* release = (xcb_key_release_event_t*)event;
+                xcb_key_press_event_t* press = (xcb_key_press_event_t*)next;
+                if (press->detail == release->detail && press->time == release->time) {
+                    free(event);
+                    free(next);
+                    event = xcb_poll_for_event(state_ptr->connection);
+                    continue;
+                }
+            }
+        }
+
+        handle_event(event);
+        free(event);
+        event = next ? next : xcb_poll_for_event(state_ptr->connection);
+    }
+
+    if (xcb_connection_has_error(state_ptr->connection)) {
+        KFATAL("Lost the connection to the X server.");
+        return false;
+    }
+    return true;
+}
+
+// TODO: replace all of these with custom allocators
+void* platform_allocate(u64 size, b8 aligned) {
+    return malloc(size);
+}
+
+void platform_free(void* block, b8 aligned) {
+    free(block);
+}
+
+void* platform_allocate_aligned(u64 size, u16 alignment) {
+    // posix_memalign needs at least pointer alignment.
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+    void* block = 0;
+    if (posix_memalign(&block, alignment, size) != 0) {
+        return 0;
+    }
+    return block;
+}
+
+void platform_free_aligned(void* block) {
+    free(block);
+}
+
+u64 platform_page_size() {
+    return (u64)sysconf(_SC_PAGESIZE);
+}
+
+u64 platform_large_page_size() {
+    return LINUX_LARGE_PAGE_SIZE;
+}
+
+void* platform_reserve_memory(u64 size, b8 large_pages) {
+    if (large_pages && (size % LINUX_LARGE_PAGE_SIZE) == 0) {
+        // Explicit huge pages only work if the administrator has set aside a pool for them.
+        // NOTE: No MAP_NORESERVE here; without a reservation, running out of the pool is a SIGBUS on first touch.
+        void* block = mmap(0, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (block != MAP_FAILED) {
+            return block;
+        }
+
+        // Otherwise, fall back to transparent huge pages. Those are only used for 2mb aligned
+        // regions, so over-reserve and trim the range down to an aligned one.
+        u64 padded_size = size + LINUX_LARGE_PAGE_SIZE;
+        u8* padded = mmap(0, padded_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (padded == MAP_FAILED) {
+            KERROR("platform_reserve_memory failed to reserve %llu bytes.", size);
+            return 0;
+        }
+        u8* aligned = (u8*)(((u64)padded + LINUX_LARGE_PAGE_SIZE - 1) & ~((u64)LINUX_LARGE_PAGE_SIZE - 1));
+        u64 head = aligned - padded;
+        u64 tail = padded_size - head - size;
+        if (head) {
+            munmap(padded, head);
+        }
+        if (tail) {
+            munmap(aligned + size, tail);
+        }
+        madvise(aligned, size, MADV_HUGEPAGE);
+        return aligned;
+    }
+
+    void* block = mmap(0, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (block == MAP_FAILED) {
+        KERROR("platform_reserve_memory failed to reserve %llu bytes.", size);
+        return 0;
+    }
+    return block;
+}
+
+b8 platform_commit_memory(void* address, u64 size) {
+    return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+void platform_decommit_memory(void* address, u64 size) {
+    // Drop the pages first so they come back zeroed if committed again.
+    madvise(address, size, MADV_DONTNEED);
+    mprotect(address, size, PROT_NONE);
+}
+
+void platform_release_memory(void* address, u64 size) {
+    munmap(address, size);
+}
+
+void* platform_zero_memory(void* block, u64 size) {
+    return memset(block, 0, size);
+}
+
+void* platform_copy_memory(void* dest, const void* source, u64 size) {
+    return memcpy(dest, source, size);
+}
+
+void* platform_set_memory(void* dest, i32 value, u64 size) {
+    return memset(dest, value, size);
+}
+
+// ANSI colour codes.
+// FATAL, ERROR, WARN, INFO, DEBUG, TRACE
+static const char* colour_strings[] = {"0;41", "1;31", "1;33", "1;32", "1;34", "1;30"};
+
+void platform_console_write(const char* message, u8 colour) {
+    fprintf(stdout, "\033[%sm%s\033[0m", colour_strings[colour], message);
+}
+
+void platform_console_write_error(const char* message, u8 colour) {
+    fprintf(stderr, "\033[%sm%s\033[0m", colour_strings[colour], message);
+}
+
+f64 platform_get_absolute_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 0.000000001;
+}
+
+void platform_sleep(u64 ms) {
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000 * 1000;
+    // Carry on sleeping for whatever is left if a signal interrupts.
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+    }
+}
+
+u32 platform_get_processor_count() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+}
+
+// The CLOCK_MONOTONIC time timeout_ms from now, which futex and condvar waits take as a deadline.
+static struct timespec deadline_after(u64 timeout_ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000 * 1000;
+    if (deadline.tv_nsec >= 1000 * 1000 * 1000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000 * 1000 * 1000;
+    }
+    return deadline;
+}
+
+typedef struct linux_thread_start {
+    pfn_thread_start function;
+    void* params;
+} linux_thread_start;
+
+static void* thread_entry(void* data) {
+    linux_thread_start start = *(linux_thread_start*)data;
+    platform_free(data, false);
+    return (void*)(uintptr_t)start.function(start.params);
+}
+
+b8 kthread_create(pfn_thread_start start_function_ptr, void* params, kthread* out_thread) {
+    if (!start_function_ptr || !out_thread) {
+        return false;
+    }
+
+    // Freed by the thread once it has copied it out.
+    linux_thread_start* start = platform_allocate(sizeof(linux_thread_start), false);
+    start->function = start_function_ptr;
+    start->params = params;
+
+    pthread_t handle;
+    i32 result = pthread_create(&handle, NULL, thread_entry, start);
+    if (result != 0) {
+        KERROR("kthread_create - pthread_create failed: %s", strerror(result));
+        platform_free(start, false);
+        return false;
+    }
+    out_thread->internal_data = (void*)handle;
+    return true;
+}
+
+b8 kthread_join(kthread* thread, u32* out_result) {
+    if (!thread || !thread->internal_data) {
+        return false;
+    }
+    void* result = 0;
+    i32 error = pthread_join((pthread_t)thread->internal_data, &result);
+    if (error != 0) {
+        KERROR("kthread_join - pthread_join failed: %s", strerror(error));
+        return false;
+    }
+    thread->internal_data = 0;
+    if (out_result) {
+        *out_result = (u32)(uintptr_t)result;
+    }
+    return true;
+}
+
+void kthread_detach(kthread* thread) {
+    if (thread && thread->internal_data) {
+        pthread_detach((pthread_t)thread->internal_data);
+        thread->internal_data = 0;
+    }
+}
+
+b8 kthread_set_affinity(kthread* thread, u32 processor_index) {
+    if (!thread || !thread->internal_data || processor_index >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(processor_index, &cpu_set);
+    i32 result = pthread_setaffinity_np((pthread_t)thread->internal_data, sizeof(cpu_set_t), &cpu_set);
+    if (result != 0) {
+        KWARN("kthread_set_affinity - failed to pin thread to processor %u: %s", processor_index, strerror(result));
+        return false;
+    }
+    return true;
+}
+
+b8 kthread_set_name(kthread* thread, const char* name) {
+    if (!thread || !thread->internal_data || !name) {
+        return false;
+    }
+    // Longer names are rejected outright rather than truncated.
+    char truncated[16];
+    strncpy(truncated, name, sizeof(truncated) - 1);
+    truncated[sizeof(truncated) - 1] = 0;
+    return pthread_setname_np((pthread_t)thread->internal_data, truncated) == 0;
+}
+
+u64 kthread_current_id() {
+    return (u64)syscall(SYS_gettid);
+}
+
+void kthread_yield() {
+    sched_yield();
+}
+
+b8 kmutex_create(kmutex* out_mutex) {
+    if (!out_mutex) {
+        return false;
+    }
+    pthread_mutex_t* handle = platform_allocate(sizeof(pthread_mutex_t), false);
+    i32 result = pthread_mutex_init(handle, NULL);
+    if (result != 0) {
+        KERROR("kmutex_create - pthread_mutex_init failed: %s", strerror(result));
+        platform_free(handle, false);
+        return false;
+    }
+    out_mutex->internal_data = handle;
+    return true;
+}
+
+void kmutex_destroy(kmutex* mutex) {
+    if (mutex && mutex->internal_data) {
+        pthread_mutex_destroy(mutex->internal_data);
+        platform_free(mutex->internal_data, false);
+        mutex->internal_data = 0;
+    }
+}
+
+b8 kmutex_lock(kmutex* mutex) {
+    return pthread_mutex_lock(mutex->internal_data) == 0;
+}
+
+b8 kmutex_try_lock(kmutex* mutex) {
+    return pthread_mutex_trylock(mutex->internal_data) == 0;
+}
+
+b8 kmutex_unlock(kmutex* mutex) {
+    return pthread_mutex_unlock(mutex->internal_data) == 0;
+}
+
+// A futex on the count itself, so signalling an uncontended semaphore never enters the kernel.
+typedef struct linux_semaphore {
+    katomic_u32 count;
+    katomic_u32 waiters;
+} linux_semaphore;
+
+static b8 semaphore_try_take(linux_semaphore* semaphore) {
+    u32 count = katomic_load(&semaphore->count, KATOMIC_RELAXED);
+    while (count > 0) {
+        if (katomic_compare_exchange_weak(&semaphore->count, &count, count - 1, KATOMIC_ACQUIRE, KATOMIC_RELAXED)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// deadline is absolute on CLOCK_MONOTONIC, or 0 to wait forever.
+static b8 semaphore_wait(linux_semaphore* semaphore, const struct timespec* deadline) {
+    while (!semaphore_try_take(semaphore)) {
+        katomic_fetch_add(&semaphore->waiters, 1, KATOMIC_SEQ_CST);
+        // The kernel only sleeps if the count is still zero, so a signal since the check isn't missed.
+        long result = syscall(SYS_futex, &semaphore->count, FUTEX_WAIT_BITSET_PRIVATE, 0, deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+        katomic_fetch_sub(&semaphore->waiters, 1, KATOMIC_SEQ_CST);
+        if (result == -1 && errno == ETIMEDOUT) {
+            return semaphore_try_take(semaphore);
+        }
+    }
+    return true;
+}
+
+b8 ksemaphore_create(u32 initial_count, ksemaphore* out_semaphore) {
+    if (!out_semaphore) {
+        return false;
+    }
+    linux_semaphore* semaphore = platform_allocate(sizeof(linux_semaphore), false);
+    katomic_init(&semaphore->count, initial_count);
+    katomic_init(&semaphore->waiters, 0);
+    out_semaphore->internal_data = semaphore;
+    return true;
+}
+
+void ksemaphore_destroy(ksemaphore* semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        platform_free(semaphore->internal_data, false);
+        semaphore->internal_data = 0;
+    }
+}
+
+void ksemaphore_signal(ksemaphore* semaphore, u32 count) {
+    linux_semaphore* s = semaphore->internal_data;
+    katomic_fetch_add(&s->count, count, KATOMIC_SEQ_CST);
+    if (katomic_load(&s->waiters, KATOMIC_SEQ_CST) > 0) {
+        syscall(SYS_futex, &s->count, FUTEX_WAKE_PRIVATE, count > INT32_MAX ? INT32_MAX : count, NULL, NULL, 0);
+    }
+}
+
+void ksemaphore_wait(ksemaphore* semaphore) {
+    semaphore_wait(semaphore->internal_data, NULL);
+}
+
+b8 ksemaphore_wait_timeout(ksemaphore* semaphore, u64 timeout_ms) {
+    struct timespec deadline = deadline_after(timeout_ms);
+    return semaphore_wait(semaphore->internal_data, &deadline);
+}
+
+b8 kcondvar_create(kcondvar* out_condvar) {
+    if (!out_condvar) {
+        return false;
+    }
+    // Timed waits take a monotonic deadline so they aren't thrown off by wall clock changes.
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_t* handle = platform_allocate(sizeof(pthread_cond_t), false);
+    i32 result = pthread_cond_init(handle, &attributes);
+    pthread_condattr_destroy(&attributes);
+    if (result != 0) {
+        KERROR("kcondvar_create - pthread_cond_init failed: %s", strerror(result));
+        platform_free(handle, false);
+        return false;
+    }
+    out_condvar->internal_data = handle;
+    return true;
+}
+
+void kcondvar_destroy(kcondvar* condvar) {
+    if (condvar && condvar->internal_data) {
+        pthread_cond_destroy(condvar->internal_data);
+        platform_free(condvar->internal_data, false);
+        condvar->internal_data = 0;
+    }
+}
+
+void kcondvar_wait(kcondvar* condvar, kmutex* mutex) {
+    pthread_cond_wait(condvar->internal_data, mutex->internal_data);
+}
+
+b8 kcondvar_wait_timeout(kcondvar* condvar, kmutex* mutex, u64 timeout_ms) {
+    struct timespec deadline = deadline_after(timeout_ms);
+    return pthread_cond_timedwait(condvar->internal_data, mutex->internal_data, &deadline) != ETIMEDOUT;
+}
+
+void kcondvar_signal(kcondvar* condvar) {
+    pthread_cond_signal(condvar->internal_data);
+}
+
+void kcondvar_broadcast(kcondvar* condvar) {
+    pthread_cond_broadcast(condvar->internal_data);
+}
+
+// declared in vulkan_platform.h
+void platform_get_required_extension_names(const char*** names_darray) {
+    if (state_ptr && state_ptr->headless) {
+        return;
+    }
+    darray_push(*names_darray, &"VK_KHR_xcb_surface");
+}
+
+b8 platform_create_vulkan_surface(vulkan_context* context) {
+    if (!state_ptr) {
+        return false;
+    }
+    if (!state_ptr->connection) {
+        KERROR("platform_create_vulkan_surface - there is no window to create a surface for (headless).");
+        return false;
+    }
+
+    VkXcbSurfaceCreateInfoKHR create_info = {VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR};
+    create_info.connection = state_ptr->connection;
+    create_info.window = state_ptr->window;
+
+    VkResult result = vkCreateXcbSurfaceKHR(context->instance, &create_info, context->allocator, &state_ptr->surface);
+    if (result != VK_SUCCESS) {
+        KFATAL("Vulkan surface creation failed.");
+        return false;
+    }
+    context->surface = state_ptr->surface;
+    return true;
+}
+
+static keys translate_keycode(u32 x_keycode) {
+    if (!state_ptr->keyboard_mapping || x_keycode < state_ptr->min_keycode) {
+        return 0;
+    }
+    xcb_keysym_t* keysyms = xcb_get_keyboard_mapping_keysyms(state_ptr->keyboard_mapping);
+    u32 keysyms_per_keycode = state_ptr->keyboard_mapping->keysyms_per_keycode;
+    u32 index = (x_keycode - state_ptr->min_keycode) * keysyms_per_keycode;
+    if (index >= (u32)xcb_get_keyboard_mapping_keysyms_length(state_ptr->keyboard_mapping)) {
+        return 0;
+    }
+    // The first column is the unshifted symbol, so letters come through lower case.
+    xcb_keysym_t keysym = keysyms[index];
+
+    if (keysym >= XK_a && keysym <= XK_z) {
+        return KEY_A + (keysym - XK_a);
+    }
+    if (keysym >= XK_0 && keysym <= XK_9) {
+        return KEY_0 + (keysym - XK_0);
+    }
+    if (keysym >= XK_F1 && keysym <= XK_F24) {
+        return KEY_F1 + (keysym - XK_F1);
+    }
+    if (keysym >= XK_KP_0 && keysym <= XK_KP_9) {
+        return KEY_NUMPAD0 + (keysym - XK_KP_0);
+    }
+
+    switch (keysym) {
+        case XK_BackSpace:
+            return KEY_BACKSPACE;
+        case XK_Return:
+            return KEY_ENTER;
+        case XK_Tab:
+            return KEY_TAB;
+        case XK_Pause:
+            return KEY_PAUSE;
+        case XK_Caps_Lock:
+            return KEY_CAPITAL;
+        case XK_Escape:
+            return KEY_ESCAPE;
+        case XK_Mode_switch:
+            return KEY_MODECHANGE;
+        case XK_space:
+            return KEY_SPACE;
+        case XK_Prior:
+            return KEY_PAGEUP;
+        case XK_Next:
+            return KEY_PAGEDOWN;
+        case XK_End:
+            return KEY_END;
+        case XK_Home:
+            return KEY_HOME;
+        case XK_Left:
+            return KEY_LEFT;
+        case XK_Up:
+            return KEY_UP;
+        case XK_Right:
+            return KEY_RIGHT;
+        case XK_Down:
+            return KEY_DOWN;
+        case XK_Select:
+            return KEY_SELECT;
+        case XK_Print:
+            return KEY_PRINT;
+        case XK_Insert:
+            return KEY_INSERT;
+        case XK_Delete:
+            return KEY_DELETE;
+        case XK_Help:
+            return KEY_HELP;
+        case XK_Super_L:
+            return KEY_LSUPER;
+        case XK_Super_R:
+            return KEY_RSUPER;
+        case XK_Menu:
+            return KEY_APPS;
+        case XK_KP_Multiply:
+            return KEY_MULTIPLY;
+        case XK_KP_Add:
+            return KEY_ADD;
+        case XK_KP_Separator:
+            return KEY_SEPARATOR;
+        case XK_KP_Subtract:
+            return KEY_SUBTRACT;
+        case XK_KP_Decimal:
+            return KEY_DECIMAL;
+        case XK_KP_Divide:
+            return KEY_DIVIDE;
+        case XK_KP_Equal:
+            return KEY_NUMPAD_EQUAL;
+        case XK_Num_Lock:
+            return KEY_NUMLOCK;
+        case XK_Scroll_Lock:
+            return KEY_SCROLL;
+        case XK_Shift_L:
+            return KEY_LSHIFT;
+        case XK_Shift_R:
+            return KEY_RSHIFT;
+        case XK_Control_L:
+            return KEY_LCONTROL;
+        case XK_Control_R:
+            return KEY_RCONTROL;
+        case XK_Alt_L:
+            return KEY_LALT;
+        case XK_Alt_R:
+            return KEY_RALT;
+        case XK_semicolon:
+            return KEY_SEMICOLON;
+        case XK_apostrophe:
+            return KEY_APOSTROPHE;
+        case XK_equal:
+            return KEY_EQUAL;
+        case XK_comma:
+            return KEY_COMMA;
+        case XK_minus:
+            return KEY_MINUS;
+        case XK_period:
+            return KEY_PERIOD;
+        case XK_slash:
+            return KEY_SLASH;
+        case XK_grave:
+            return KEY_GRAVE;
+        case XK_bracketleft:
+            return KEY_LBRACKET;
+        case XK_backslash:
+            return KEY_BACKSLASH;
+        case XK_bracketright:
+            return KEY_RBRACKET;
+        default:
+            return 0;
+    }
+}
+
+#endif  // K_PLATFORM_LINUX
@@ -6,8 +6,13 @@
 
 #include "core/event.h"
 #include "core/input.h"
+#include "core/kcondvar.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kthread.h"
 #include "core/logger.h"
 
+#include <malloc.h>
 #include <stdlib.h>
 #include <windows.h>
 #include <windowsx.h>
@@ -44,7 +49,8 @@ b8 platform_startup(
     i32 x,
     i32 y,
     i32 width,
-    i32 height) {
+    i32 height,
+    b8 headless) {
     *memory_requirement = sizeof(platform_state);
     if (state == 0) {
         return true;
@@ -52,6 +58,11 @@ b8 platform_startup(
     state_ptr = state;
     state_ptr->h_instance = GetModuleHandleA(0);
 
+    if (headless) {
+        clock_setup();
+        return true;
+    }
+
     HICON icon = LoadIcon(state_ptr->h_instance, IDI_APPLICATION);
     WNDCLASSA window_class;
     memset(&window_class, 0, sizeof(window_class));
@@ -156,6 +167,42 @@ void platform_free(void* block, b8 aligned) {
     free(block);
 }
 
+void* platform_allocate_aligned(u64 size, u16 alignment) {
+    return _aligned_malloc(size, alignment);
+}
+
+void platform_free_aligned(void* block) {
+    _aligned_free(block);
+}
+
+u64 platform_page_size() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+u64 platform_large_page_size() {
+    return GetLargePageMinimum();
+}
+
+void* platform_reserve_memory(u64 size, b8 large_pages) {
+    // NOTE: Large pages on Windows have to be committed at reservation time and need the
+    // SeLockMemoryPrivilege, which doesn't fit lazy committing. The hint is ignored for now.
+    return VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+b8 platform_commit_memory(void* address, u64 size) {
+    return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != 0;
+}
+
+void platform_decommit_memory(void* address, u64 size) {
+    VirtualFree(address, size, MEM_DECOMMIT);
+}
+
+void platform_release_memory(void* address, u64 size) {
+    VirtualFree(address, 0, MEM_RELEASE);
+}
+
 void* platform_zero_memory(void* block, u64 size) {
     return memset(block, 0, size);
 }
@@ -206,6 +253,203 @@ void platform_sleep(u64 ms) {
     Sleep(ms);
 }
 
+u32 platform_get_processor_count() {
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    return sysinfo.dwNumberOfProcessors;
+}
+
+// Waits longer than INFINITE - 1 ms are treated as infinite.
+static DWORD timeout_to_dword(u64 timeout_ms) {
+    return timeout_ms >= INFINITE ? INFINITE - 1 : (DWORD)timeout_ms;
+}
+
+typedef struct win32_thread_start {
+    pfn_thread_start function;
+    void* params;
+} win32_thread_start;
+
+static DWORD WINAPI thread_entry(LPVOID data) {
+    win32_thread_start start = *(win32_thread_start*)data;
+    platform_free(data, false);
+    return start.function(start.params);
+}
+
+b8 kthread_create(pfn_thread_start start_function_ptr, void* params, kthread* out_thread) {
+    if (!start_function_ptr || !out_thread) {
+        return false;
+    }
+
+    // Freed by the thread once it has copied it out.
+    win32_thread_start* start = platform_allocate(sizeof(win32_thread_start), false);
+    start->function = start_function_ptr;
+    start->params = params;
+
+    HANDLE handle = CreateThread(0, 0, thread_entry, start, 0, 0);
+    if (!handle) {
+        KERROR("kthread_create - CreateThread failed: %u", GetLastError());
+        platform_free(start, false);
+        return false;
+    }
+    out_thread->internal_data = handle;
+    return true;
+}
+
+b8 kthread_join(kthread* thread, u32* out_result) {
+    if (!thread || !thread->internal_data) {
+        return false;
+    }
+    if (WaitForSingleObject(thread->internal_data, INFINITE) != WAIT_OBJECT_0) {
+        KERROR("kthread_join - wait failed: %u", GetLastError());
+        return false;
+    }
+    DWORD exit_code = 0;
+    GetExitCodeThread(thread->internal_data, &exit_code);
+    CloseHandle(thread->internal_data);
+    thread->internal_data = 0;
+    if (out_result) {
+        *out_result = exit_code;
+    }
+    return true;
+}
+
+void kthread_detach(kthread* thread) {
+    if (thread && thread->internal_data) {
+        CloseHandle(thread->internal_data);
+        thread->internal_data = 0;
+    }
+}
+
+b8 kthread_set_affinity(kthread* thread, u32 processor_index) {
+    // TODO: Processor groups, for machines with more than 64 logical processors.
+    if (!thread || !thread->internal_data || processor_index >= 64) {
+        return false;
+    }
+    if (!SetThreadAffinityMask(thread->internal_data, (DWORD_PTR)1 << processor_index)) {
+        KWARN("kthread_set_affinity - failed to pin thread to processor %u: %u", processor_index, GetLastError());
+        return false;
+    }
+    return true;
+}
+
+b8 kthread_set_name(kthread* thread, const char* name) {
+    if (!thread || !thread->internal_data || !name) {
+        return false;
+    }
+    WCHAR wide_name[64];
+    if (!MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, 64)) {
+        return false;
+    }
+    return SUCCEEDED(SetThreadDescription(thread->internal_data, wide_name));
+}
+
+u64 kthread_current_id() {
+    return GetCurrentThreadId();
+}
+
+void kthread_yield() {
+    SwitchToThread();
+}
+
+b8 kmutex_create(kmutex* out_mutex) {
+    if (!out_mutex) {
+        return false;
+    }
+    SRWLOCK* lock = platform_allocate(sizeof(SRWLOCK), false);
+    InitializeSRWLock(lock);
+    out_mutex->internal_data = lock;
+    return true;
+}
+
+void kmutex_destroy(kmutex* mutex) {
+    if (mutex && mutex->internal_data) {
+        platform_free(mutex->internal_data, false);
+        mutex->internal_data = 0;
+    }
+}
+
+b8 kmutex_lock(kmutex* mutex) {
+    AcquireSRWLockExclusive(mutex->internal_data);
+    return true;
+}
+
+b8 kmutex_try_lock(kmutex* mutex) {
+    return TryAcquireSRWLockExclusive(mutex->internal_data) != 0;
+}
+
+b8 kmutex_unlock(kmutex* mutex) {
+    ReleaseSRWLockExclusive(mutex->internal_data);
+    return true;
+}
+
+b8 ksemaphore_create(u32 initial_count, ksemaphore* out_semaphore) {
+    if (!out_semaphore) {
+        return false;
+    }
+    HANDLE handle = CreateSemaphoreA(0, initial_count, MAXLONG, 0);
+    if (!handle) {
+        KERROR("ksemaphore_create - CreateSemaphore failed: %u", GetLastError());
+        return false;
+    }
+    out_semaphore->internal_data = handle;
+    return true;
+}
+
+void ksemaphore_destroy(ksemaphore* semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        CloseHandle(semaphore->internal_data);
+        semaphore->internal_data = 0;
+    }
+}
+
+void ksemaphore_signal(ksemaphore* semaphore, u32 count) {
+    ReleaseSemaphore(semaphore->internal_data, count, 0);
+}
+
+void ksemaphore_wait(ksemaphore* semaphore) {
+    WaitForSingleObject(semaphore->internal_data, INFINITE);
+}
+
+b8 ksemaphore_wait_timeout(ksemaphore* semaphore, u64 timeout_ms) {
+    return WaitForSingleObject(semaphore->internal_data, timeout_to_dword(timeout_ms)) == WAIT_OBJECT_0;
+}
+
+b8 kcondvar_create(kcondvar* out_condvar) {
+    if (!out_condvar) {
+        return false;
+    }
+    CONDITION_VARIABLE* condition = platform_allocate(sizeof(CONDITION_VARIABLE), false);
+    InitializeConditionVariable(condition);
+    out_condvar->internal_data = condition;
+    return true;
+}
+
+void kcondvar_destroy(kcondvar* condvar) {
+    if (condvar && condvar->internal_data) {
+        platform_free(condvar->internal_data, false);
+        condvar->internal_data = 0;
+    }
+}
+
+void kcondvar_wait(kcondvar* condvar, kmutex* mutex) {
+    SleepConditionVariableSRW(condvar->internal_data, mutex->internal_data, INFINITE, 0);
+}
+
+b8 kcondvar_wait_timeout(kcondvar* condvar, kmutex* mutex, u64 timeout_ms) {
+    if (!SleepConditionVariableSRW(condvar->internal_data, mutex->internal_data, timeout_to_dword(timeout_ms), 0)) {
+        return GetLastError() != ERROR_TIMEOUT;
+    }
+    return true;
+}
+
+void kcondvar_signal(kcondvar* condvar) {
+    WakeConditionVariable(condvar->internal_data);
+}
+
+void kcondvar_broadcast(kcondvar* condvar) {
+    WakeAllConditionVariable(condvar->internal_data);
+}
+
 // declared in vulkan_platform.h
 void platform_get_required_extension_names(const char*** names_darray) {
     darray_push(*names_darray, &"VK_KHR_win32_surface");
@@ -215,6 +459,10 @@ b8 platform_create_vulkan_surface(vulkan_context* context) {
     if (!state_ptr) {
         return false;
     }
+    if (!state_ptr->window) {
+        KERROR("platform_create_vulkan_surface - there is no window to create a surface for (headless).");
+        return false;
+    }
 
     VkWin32SurfaceCreateInfoKHR create_info = {VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR};
     create_info.hinstance = state_ptr->h_instance;
@@ -8,13 +8,16 @@ b8 renderer_backend_create(renderer_backend_type type, renderer_backend* out_ren
     if (type == RENDERER_BACKEND_TYPE_VULKAN) {
         out_renderer_backend->initialize = vulkan_initialize;
         out_renderer_backend->shutdown = vulkan_shutdown;
+        out_renderer_backend->set_config = vulkan_set_config;
         out_renderer_backend->begin_frame = vulkan_begin_frame;
         out_renderer_backend->update_global_state = vulkan_renderer_update_global_state;
         out_renderer_backend->end_frame = vulkan_end_frame;
         out_renderer_backend->resized = vulkan_resized;
         out_renderer_backend->update_object = vulkan_update_object;
+        out_renderer_backend->draw_instanced = vulkan_draw_instanced;
         out_renderer_backend->create_texture = vulkan_renderer_create_texture;
         out_renderer_backend->destroy_texture = vulkan_renderer_destroy_texture;
+        out_renderer_backend->read_pixels = vulkan_read_pixels;
 
         return true;
     }
@@ -24,11 +27,14 @@ b8 renderer_backend_create(renderer_backend_type type, renderer_backend* out_ren
 void renderer_backend_destroy(renderer_backend* backend) {
     backend->initialize = NULL;
     backend->shutdown = NULL;
+    backend->set_config = NULL;
     backend->begin_frame = NULL;
     backend->update_global_state = NULL;
     backend->end_frame = NULL;
     backend->resized = NULL;
     backend->update_object = NULL;
+    backend->draw_instanced = NULL;
     backend->create_texture = NULL;
     backend->destroy_texture = NULL;
+    backend->read_pixels = NULL;
 }
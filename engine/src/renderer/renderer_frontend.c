@@ -1,9 +1,11 @@
 #include "renderer_frontend.h"
 
+#include "containers/darray.h"
 #include "core/kmemory.h"
 #include "core/logger.h"
 
 #include "math/kmath.h"
+#include "memory/frame_allocator.h"
 #include "renderer_backend.h"
 #include "resources/resource_types.h"
 
@@ -13,8 +15,16 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "vendor/stb_image.h"
 
+typedef struct quad_submission {
+    // Copied into frame allocator memory.
+    render_instance_data* instances;
+    u32 count;
+    b8 batched;
+} quad_submission;
+
 typedef struct renderer_system_state {
     renderer_backend backend;
+    renderer_config config;
     mat4 projection;
     mat4 view;
     f32 near_clip;
@@ -22,6 +32,9 @@ typedef struct renderer_system_state {
 
     texture default_texture;
     texture test_diffuse;
+
+    // darray of quads submitted since the last frame was drawn.
+    quad_submission* quad_submissions;
 } renderer_system_state;
 
 static renderer_system_state* state_ptr;
@@ -114,7 +127,7 @@ b8 event_on_debug_event(u16 code, void* sender, void* listener_inst, event_conte
     return true;
 }
 
-b8 renderer_initialize(u64* memory_requirement, void* state, const char* application_name) {
+b8 renderer_initialize(u64* memory_requirement, void* state, const char* application_name, renderer_config config) {
     *memory_requirement = sizeof(renderer_system_state);
     if (state == 0) {
         return true;
@@ -131,7 +144,14 @@ b8 renderer_initialize(u64* memory_requirement, void* state, const char* applica
     state_ptr->projection = mat4_perspective(deg_to_rad(45.0f), 1200 / 720.0f, state_ptr->near_clip, state_ptr->far_clip);
     state_ptr->view = mat4_translation((vec3){0, 0, -3.0f});
 
-    if (!state_ptr->backend.initialize(&state_ptr->backend, application_name)) {
+    if (config.frames_in_flight == 0) {
+        config.frames_in_flight = 2;
+    }
+    config.frames_in_flight = KCLAMP(config.frames_in_flight, RENDERER_MIN_FRAMES_IN_FLIGHT, RENDERER_MAX_FRAMES_IN_FLIGHT);
+    state_ptr->config = config;
+    state_ptr->quad_submissions = darray_create(quad_submission);
+
+    if (!state_ptr->backend.initialize(&state_ptr->backend, application_name, &state_ptr->config)) {
         KFATAL("Failed to initialize renderer backend");
         return false;
     }
@@ -185,6 +205,7 @@ void renderer_shutdown() {
         renderer_destroy_texture(&state_ptr->default_texture);
         renderer_destroy_texture(&state_ptr->test_diffuse);
         state_ptr->backend.shutdown(&state_ptr->backend);
+        darray_destroy(state_ptr->quad_submissions);
     }
     state_ptr = NULL;
 }
@@ -220,6 +241,24 @@ b8 renderer_draw_frame(render_packet* packet) {
         data.object_id = 0;
         state_ptr->backend.update_object(data);
 
+        u64 submission_count = darray_length(state_ptr->quad_submissions);
+        for (u64 i = 0; i < submission_count; ++i) {
+            quad_submission* submission = &state_ptr->quad_submissions[i];
+            if (submission->batched) {
+                instanced_render_data instanced = {};
+                instanced.object_id = 0;
+                instanced.textures[0] = &state_ptr->test_diffuse;
+                instanced.instance_count = submission->count;
+                instanced.instances = submission->instances;
+                state_ptr->backend.draw_instanced(instanced);
+            } else {
+                for (u32 j = 0; j < submission->count; ++j) {
+                    data.model = submission->instances[j].model;
+                    state_ptr->backend.update_object(data);
+                }
+            }
+        }
+
         b8 result = renderer_end_frame(packet->delta_time);
         // TODO: Should error handling really be done here?
         if (!result) {
@@ -227,9 +266,27 @@ b8 renderer_draw_frame(render_packet* packet) {
             return false;
         }
     }
+    // Dropped even if the frame was skipped, since the instances only live in frame memory.
+    darray_clear(state_ptr->quad_submissions);
     return true;
 }
 
+void renderer_submit_quads(u32 count, const render_instance_data* instances, b8 batched) {
+    if (count == 0) {
+        return;
+    }
+    quad_submission submission;
+    submission.instances = frame_alloc(sizeof(render_instance_data) * count);
+    if (!submission.instances) {
+        KWARN("renderer_submit_quads - out of frame memory, dropping %u quads.", count);
+        return;
+    }
+    kcopy_memory(submission.instances, instances, sizeof(render_instance_data) * count);
+    submission.count = count;
+    submission.batched = batched;
+    darray_push(state_ptr->quad_submissions, submission);
+}
+
 void renderer_on_resized(u16 width, u16 height) {
     if (state_ptr) {
         state_ptr->projection = mat4_perspective(deg_to_rad(45.0f), width / (f32)height, state_ptr->near_clip, state_ptr->far_clip);
@@ -239,6 +296,31 @@ void renderer_on_resized(u16 width, u16 height) {
     }
 }
 
+renderer_config renderer_get_config() {
+    return state_ptr->config;
+}
+
+void renderer_set_present_mode(renderer_present_mode present_mode) {
+    if (state_ptr->config.present_mode == present_mode) {
+        return;
+    }
+    state_ptr->config.present_mode = present_mode;
+    state_ptr->backend.set_config(&state_ptr->backend, &state_ptr->config);
+}
+
+void renderer_set_frames_in_flight(u8 frames_in_flight) {
+    frames_in_flight = KCLAMP(frames_in_flight, RENDERER_MIN_FRAMES_IN_FLIGHT, RENDERER_MAX_FRAMES_IN_FLIGHT);
+    if (state_ptr->config.frames_in_flight == frames_in_flight) {
+        return;
+    }
+    state_ptr->config.frames_in_flight = frames_in_flight;
+    state_ptr->backend.set_config(&state_ptr->backend, &state_ptr->config);
+}
+
+b8 renderer_read_pixels(u32* out_width, u32* out_height, u8* out_pixels) {
+    return state_ptr->backend.read_pixels(&state_ptr->backend, out_width, out_height, out_pixels);
+}
+
 void renderer_set_view(mat4 view) {
     state_ptr->view = view;
 }
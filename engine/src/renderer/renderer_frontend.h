@@ -5,16 +5,31 @@
 struct static_mesh_data;
 struct platform_state;
 
-b8 renderer_initialize(u64* memory_requirement, void* state, const char* application_name);
+b8 renderer_initialize(u64* memory_requirement, void* state, const char* application_name, renderer_config config);
 void renderer_shutdown();
 
 void renderer_on_resized(u16 width, u16 height);
 
+KAPI renderer_config renderer_get_config();
+
+// Changes to these rebuild the swapchain before the next frame.
+KAPI void renderer_set_present_mode(renderer_present_mode present_mode);
+KAPI void renderer_set_frames_in_flight(u8 frames_in_flight);
+
 b8 renderer_draw_frame(render_packet* packet);
 
+// Copies the last rendered frame into out_pixels as tightly packed rgba8, waiting for the gpu to finish it.
+// Call with out_pixels 0 first to get the size; out_pixels must hold width * height * 4 bytes.
+// Only available when rendering offscreen (see renderer_config.offscreen).
+KAPI b8 renderer_read_pixels(u32* out_width, u32* out_height, u8* out_pixels);
+
 // Hack: This should not be exposed outside the engine
 KAPI void renderer_set_view(mat4 view);
 
+// Hack: draws the test quad once per instance in the next frame, until there's a geometry system.
+// Batched quads go out as a single instanced draw, otherwise each is drawn as its own object.
+KAPI void renderer_submit_quads(u32 count, const render_instance_data* instances, b8 batched);
+
 void renderer_create_texture(
     const char* name,
     b8 auto_release,
@@ -8,6 +8,30 @@ typedef enum renderer_backend_type {
     RENDERER_BACKEND_TYPE_VULKAN
 } renderer_backend_type;
 
+// How finished frames are handed to the display. Falls back to FIFO, which is always available.
+typedef enum renderer_present_mode {
+    // Vsync. Frames queue up behind the display.
+    RENDERER_PRESENT_MODE_FIFO,
+    // Vsync, but a late frame is shown immediately instead of waiting for the next blank.
+    RENDERER_PRESENT_MODE_FIFO_RELAXED,
+    // Vsync without blocking. The newest frame replaces any queued one.
+    RENDERER_PRESENT_MODE_MAILBOX,
+    // No vsync. Frames are shown as soon as they're done and may tear.
+    RENDERER_PRESENT_MODE_IMMEDIATE
+} renderer_present_mode;
+
+#define RENDERER_MIN_FRAMES_IN_FLIGHT 1
+#define RENDERER_MAX_FRAMES_IN_FLIGHT 3
+
+typedef struct renderer_config {
+    // How many frames the cpu may record ahead of the gpu, 1-3. 0 uses the default of 2.
+    u8 frames_in_flight;
+    renderer_present_mode present_mode;
+    // Renders into offscreen images instead of a window surface, for headless runs. Frames can be read
+    // back with renderer_read_pixels. Only read at initialize, and forced on for headless applications.
+    b8 offscreen;
+} renderer_config;
+
 // Some NVIDIA cards need uniforms to be exactly 256 bytes.
 typedef struct global_uniform_object {
     mat4 projection;  // 64 bytes
@@ -29,20 +53,40 @@ typedef struct geometry_render_data {
     texture* textures[16];
 } geometry_render_data;
 
+// Per-instance data for a batched draw, read by the vertex shader at instance rate.
+typedef struct render_instance_data {
+    mat4 model;          // 64 bytes
+    u32 material_index;  // 4 bytes
+    u32 padding[3];      // 12 bytes
+} render_instance_data;
+
+// Draws the same geometry instance_count times in a single draw call.
+typedef struct instanced_render_data {
+    u32 object_id;
+    texture* textures[16];
+    u32 instance_count;
+    // Copied by the backend, so only needs to live for the call.
+    const render_instance_data* instances;
+} instanced_render_data;
+
 typedef struct renderer_backend {
     u64 frame_number;
 
     texture* default_diffuse;
 
-    b8 (*initialize)(struct renderer_backend* backend, const char* application_name);
+    b8 (*initialize)(struct renderer_backend* backend, const char* application_name, const renderer_config* config);
     void (*shutdown)(struct renderer_backend* backend);
 
+    // Takes effect at the start of the next frame.
+    void (*set_config)(struct renderer_backend* backend, const renderer_config* config);
+
     void (*resized)(struct renderer_backend* backend, u16 width, u16 height);
 
     b8 (*begin_frame)(struct renderer_backend* backend, f32 delta_time);
     void (*update_global_state)(mat4 projection, mat4 view, vec3 view_position, vec4 ambient_colour, i32 mode);
     b8 (*end_frame)(struct renderer_backend* backend, f32 delta_time);
     void (*update_object)(geometry_render_data data);
+    void (*draw_instanced)(instanced_render_data data);
     void (*create_texture)(
         const char* name,
         b8 auto_release,
@@ -53,6 +97,9 @@ typedef struct renderer_backend {
         b8 has_transparency,
         struct texture* out_texture);
     void (*destroy_texture)(struct texture* texture);
+
+    // Copies the last rendered frame into out_pixels as tightly packed rgba8. Pass 0 for out_pixels to only get the size.
+    b8 (*read_pixels)(struct renderer_backend* backend, u32* out_width, u32* out_height, u8* out_pixels);
 } renderer_backend;
 
 typedef struct render_packet {
@@ -9,6 +9,7 @@
 #include "renderer/vulkan/vulkan_shader_utils.h"
 
 #define BUILTIN_SHADER_NAME_OBJECT "Builtin.ObjectShader"
+#define BUILTIN_SHADER_NAME_OBJECT_INSTANCED "Builtin.ObjectShaderInstanced"
 
 b8 vulkan_object_shader_create(vulkan_context* context, texture* default_texture, vulkan_object_shader* out_shader) {
     out_shader->default_diffuse = default_texture;
@@ -21,6 +22,10 @@ b8 vulkan_object_shader_create(vulkan_context* context, texture* default_texture
             return false;
         }
     }
+    if (!create_shader_module(context, BUILTIN_SHADER_NAME_OBJECT_INSTANCED, "vert", VK_SHADER_STAGE_VERTEX_BIT, 0, &out_shader->instanced_vertex_stage)) {
+        KERROR("Unable to create vert shader module for '%s'.", BUILTIN_SHADER_NAME_OBJECT_INSTANCED);
+        return false;
+    }
 
     VkDescriptorSetLayoutBinding global_ubo_layout_binding;
     global_ubo_layout_binding.binding = 0;
@@ -36,19 +41,31 @@ b8 vulkan_object_shader_create(vulkan_context* context, texture* default_texture
 
     VkDescriptorPoolSize global_pool_size;
     global_pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    global_pool_size.descriptorCount = context->swapchain.image_count;
+    global_pool_size.descriptorCount = VULKAN_MAX_FRAMES_IN_FLIGHT;
 
     VkDescriptorPoolCreateInfo global_pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
     global_pool_info.poolSizeCount = 1;
     global_pool_info.pPoolSizes = &global_pool_size;
-    global_pool_info.maxSets = context->swapchain.image_count;
+    global_pool_info.maxSets = VULKAN_MAX_FRAMES_IN_FLIGHT;
     VK_CHECK(vkCreateDescriptorPool(context->device.logical_device, &global_pool_info, context->allocator, &out_shader->global_descriptor_pool));
 
+    // Object uniforms: a single dynamic uniform buffer descriptor shared by every object.
+    VkDescriptorSetLayoutBinding object_ubo_layout_binding;
+    object_ubo_layout_binding.binding = 0;
+    object_ubo_layout_binding.descriptorCount = 1;
+    object_ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    object_ubo_layout_binding.pImmutableSamplers = 0;
+    object_ubo_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo object_ubo_layout_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    object_ubo_layout_info.bindingCount = 1;
+    object_ubo_layout_info.pBindings = &object_ubo_layout_binding;
+    VK_CHECK(vkCreateDescriptorSetLayout(context->device.logical_device, &object_ubo_layout_info, context->allocator, &out_shader->object_uniform_descriptor_set_layout));
+
     // Local/Object Descriptors
     const u32 local_sampler_count = 1;
     VkDescriptorType descriptor_types[VULKAN_DESCRIPTORS_PER_OBJECT] = {
-        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,          // Binding 0 - uniform buffer
-        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  // Binding 1 - Diffuse sampler layout.
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  // Binding 0 - Diffuse sampler layout.
     };
     VkDescriptorSetLayoutBinding bindings[VULKAN_DESCRIPTORS_PER_OBJECT];
     kzero_memory(&bindings, sizeof(VkDescriptorSetLayoutBinding) * VULKAN_DESCRIPTORS_PER_OBJECT);
@@ -62,21 +79,21 @@ b8 vulkan_object_shader_create(vulkan_context* context, texture* default_texture
     VkDescriptorSetLayoutCreateInfo layout_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
     layout_info.bindingCount = VULKAN_DESCRIPTORS_PER_OBJECT;
     layout_info.pBindings = bindings;
-    VK_CHECK(vkCreateDescriptorSetLayout(context->device.logical_device, &layout_info, 0, &out_shader->object_descriptor_set_layout));
+    VK_CHECK(vkCreateDescriptorSetLayout(context->device.logical_device, &layout_info, context->allocator, &out_shader->object_descriptor_set_layout));
 
-    // Local/Object descriptor pool: Used for object-specific items like diffuse colour
+    // Local/Object descriptor pool: one set per object per frame for samplers, plus the shared object uniform set.
     VkDescriptorPoolSize object_pool_sizes[2];
-    object_pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    object_pool_sizes[0].descriptorCount = MAX_VULKAN_OBJECT_COUNT;
+    object_pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    object_pool_sizes[0].descriptorCount = 1;
     object_pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    object_pool_sizes[1].descriptorCount = local_sampler_count * MAX_VULKAN_OBJECT_COUNT;
-    ;
+    object_pool_sizes[1].descriptorCount = local_sampler_count * MAX_VULKAN_OBJECT_COUNT * VULKAN_MAX_FRAMES_IN_FLIGHT;
 
     VkDescriptorPoolCreateInfo object_pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
     object_pool_info.poolSizeCount = 2;
     object_pool_info.pPoolSizes = object_pool_sizes;
-    object_pool_info.maxSets = MAX_VULKAN_OBJECT_COUNT;
-    ;
+    object_pool_info.maxSets = MAX_VULKAN_OBJECT_COUNT * VULKAN_MAX_FRAMES_IN_FLIGHT + 1;
+    // Object sets are freed individually when their resources are released.
+    object_pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
     // Create object descriptor pool.
     VK_CHECK(vkCreateDescriptorPool(context->device.logical_device, &object_pool_info, context->allocator, &out_shader->object_descriptor_pool));
@@ -95,9 +112,19 @@ b8 vulkan_object_shader_create(vulkan_context* context, texture* default_texture
     scissor.extent.width = context->framebuffer_width;
     scissor.extent.height = context->framebuffer_height;
 
+    VkVertexInputBindingDescription binding_descriptions[2];
+    binding_descriptions[0].binding = 0;
+    binding_descriptions[0].stride = sizeof(vertex_3d);
+    binding_descriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    binding_descriptions[1].binding = 1;
+    binding_descriptions[1].stride = sizeof(render_instance_data);
+    binding_descriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
     u32 offset = 0;
 #define ATTRIBUTE_COUNT 2
-    VkVertexInputAttributeDescription attribute_descriptions[ATTRIBUTE_COUNT];
+// Per vertex attributes, then the model matrix's four columns and the material index.
+#define INSTANCED_ATTRIBUTE_COUNT (ATTRIBUTE_COUNT + 5)
+    VkVertexInputAttributeDescription attribute_descriptions[INSTANCED_ATTRIBUTE_COUNT];
     VkFormat formats[ATTRIBUTE_COUNT] = {VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32_SFLOAT};
     u64 sizes[ATTRIBUTE_COUNT] = {sizeof(vec3), sizeof(vec2)};
     for (u32 i = 0; i < ATTRIBUTE_COUNT; i++) {
@@ -107,10 +134,23 @@ b8 vulkan_object_shader_create(vulkan_context* context, texture* default_texture
         attribute_descriptions[i].offset = offset;
         offset += sizes[i];
     }
+    for (u32 i = 0; i < 4; i++) {
+        VkVertexInputAttributeDescription* column = &attribute_descriptions[ATTRIBUTE_COUNT + i];
+        column->binding = 1;
+        column->location = ATTRIBUTE_COUNT + i;
+        column->format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        column->offset = sizeof(vec4) * i;
+    }
+    VkVertexInputAttributeDescription* material_index = &attribute_descriptions[ATTRIBUTE_COUNT + 4];
+    material_index->binding = 1;
+    material_index->location = ATTRIBUTE_COUNT + 4;
+    material_index->format = VK_FORMAT_R32_UINT;
+    material_index->offset = sizeof(mat4);
 
-#define DESCRIPTOR_SET_LAYOUT_COUNT 2
+#define DESCRIPTOR_SET_LAYOUT_COUNT 3
     VkDescriptorSetLayout layouts[DESCRIPTOR_SET_LAYOUT_COUNT] = {
         out_shader->global_descriptor_set_layout,
+        out_shader->object_uniform_descriptor_set_layout,
         out_shader->object_descriptor_set_layout};
 
     VkPipelineShaderStageCreateInfo stage_create_infos[OBJECT_SHADER_STAGE_COUNT];
@@ -123,6 +163,8 @@ b8 vulkan_object_shader_create(vulkan_context* context, texture* default_texture
     if (!vulkan_graphics_pipeline_create(
             context,
             &context->main_renderpass,
+            1,
+            binding_descriptions,
             ATTRIBUTE_COUNT,
             attribute_descriptions,
             DESCRIPTOR_SET_LAYOUT_COUNT,
@@ -137,40 +179,113 @@ b8 vulkan_object_shader_create(vulkan_context* context, texture* default_texture
         return false;
     }
 
+    stage_create_infos[0] = out_shader->instanced_vertex_stage.shader_stage_create_info;
+    if (!vulkan_graphics_pipeline_create(
+            context,
+            &context->main_renderpass,
+            2,
+            binding_descriptions,
+            INSTANCED_ATTRIBUTE_COUNT,
+            attribute_descriptions,
+            DESCRIPTOR_SET_LAYOUT_COUNT,
+            layouts,
+            OBJECT_SHADER_STAGE_COUNT,
+            stage_create_infos,
+            viewport,
+            scissor,
+            false,
+            &out_shader->instanced_pipeline)) {
+        KERROR("Failed to load instanced graphics pipeline for object shader");
+        return false;
+    }
+
+    u64 min_alignment = context->device.properties.limits.minUniformBufferOffsetAlignment;
+    out_shader->global_uniform_stride = sizeof(global_uniform_object);
+    if (min_alignment > 0) {
+        out_shader->global_uniform_stride = (out_shader->global_uniform_stride + min_alignment - 1) & ~(min_alignment - 1);
+    }
+
+    // Uniform buffers are rewritten every frame, so they stay mapped. Coherency isn't required;
+    // non-coherent memory gets flushed after each write.
     u32 device_local_bits = context->device.supports_device_local_host_visible ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : 0;
     if (!vulkan_buffer_create(
             context,
-            sizeof(global_uniform_object),
+            out_shader->global_uniform_stride * VULKAN_MAX_FRAMES_IN_FLIGHT,
             VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | device_local_bits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | device_local_bits,
+            true,
             true,
             &out_shader->global_uniform_buffer)) {
         KERROR("Vulkan buffer creation failed for object shader.");
         return false;
     }
 
-    VkDescriptorSetLayout global_layouts[3] = {
-        out_shader->global_descriptor_set_layout,
-        out_shader->global_descriptor_set_layout,
-        out_shader->global_descriptor_set_layout};
+    VkDescriptorSetLayout global_layouts[VULKAN_MAX_FRAMES_IN_FLIGHT];
+    for (u32 i = 0; i < VULKAN_MAX_FRAMES_IN_FLIGHT; ++i) {
+        global_layouts[i] = out_shader->global_descriptor_set_layout;
+    }
 
     VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
     alloc_info.descriptorPool = out_shader->global_descriptor_pool;
-    alloc_info.descriptorSetCount = 3;
+    alloc_info.descriptorSetCount = VULKAN_MAX_FRAMES_IN_FLIGHT;
     alloc_info.pSetLayouts = global_layouts;
     VK_CHECK(vkAllocateDescriptorSets(context->device.logical_device, &alloc_info, out_shader->global_descriptor_sets));
 
+    // Each frame's set points at that frame's slot, so nothing needs rewriting per frame.
+    for (u32 i = 0; i < VULKAN_MAX_FRAMES_IN_FLIGHT; ++i) {
+        VkDescriptorBufferInfo global_buffer_info;
+        global_buffer_info.buffer = out_shader->global_uniform_buffer.handle;
+        global_buffer_info.offset = out_shader->global_uniform_stride * i;
+        global_buffer_info.range = sizeof(global_uniform_object);
+
+        VkWriteDescriptorSet global_write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        global_write.dstSet = out_shader->global_descriptor_sets[i];
+        global_write.dstBinding = 0;
+        global_write.dstArrayElement = 0;
+        global_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        global_write.descriptorCount = 1;
+        global_write.pBufferInfo = &global_buffer_info;
+        vkUpdateDescriptorSets(context->device.logical_device, 1, &global_write, 0, 0);
+    }
+
+    out_shader->object_uniform_stride = sizeof(object_uniform_object);
+    if (min_alignment > 0) {
+        out_shader->object_uniform_stride = (out_shader->object_uniform_stride + min_alignment - 1) & ~(min_alignment - 1);
+    }
+    u64 object_uniform_size = out_shader->object_uniform_stride * MAX_VULKAN_OBJECT_COUNT * VULKAN_MAX_FRAMES_IN_FLIGHT;
     if (!vulkan_buffer_create(
             context,
-            sizeof(object_uniform_object),
+            object_uniform_size,
             VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | device_local_bits,
+            true,
             true,
             &out_shader->object_uniform_buffer)) {
         KERROR("Material instance buffer creation failed for shader.");
         return false;
     }
 
+    VkDescriptorSetAllocateInfo object_uniform_alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    object_uniform_alloc_info.descriptorPool = out_shader->object_descriptor_pool;
+    object_uniform_alloc_info.descriptorSetCount = 1;
+    object_uniform_alloc_info.pSetLayouts = &out_shader->object_uniform_descriptor_set_layout;
+    VK_CHECK(vkAllocateDescriptorSets(context->device.logical_device, &object_uniform_alloc_info, &out_shader->object_uniform_descriptor_set));
+
+    // The range covers one object. Which object (and frame) is picked by the dynamic offset at bind time.
+    VkDescriptorBufferInfo object_uniform_buffer_info;
+    object_uniform_buffer_info.buffer = out_shader->object_uniform_buffer.handle;
+    object_uniform_buffer_info.offset = 0;
+    object_uniform_buffer_info.range = sizeof(object_uniform_object);
+
+    VkWriteDescriptorSet object_uniform_write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    object_uniform_write.dstSet = out_shader->object_uniform_descriptor_set;
+    object_uniform_write.dstBinding = 0;
+    object_uniform_write.dstArrayElement = 0;
+    object_uniform_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    object_uniform_write.descriptorCount = 1;
+    object_uniform_write.pBufferInfo = &object_uniform_buffer_info;
+    vkUpdateDescriptorSets(context->device.logical_device, 1, &object_uniform_write, 0, 0);
+
     return true;
 }
 
@@ -179,6 +294,7 @@ void vulkan_object_shader_destroy(vulkan_context* context, struct vulkan_object_
 
     vkDestroyDescriptorPool(logical_device, shader->object_descriptor_pool, context->allocator);
     vkDestroyDescriptorSetLayout(logical_device, shader->object_descriptor_set_layout, context->allocator);
+    vkDestroyDescriptorSetLayout(logical_device, shader->object_uniform_descriptor_set_layout, context->allocator);
 
     vulkan_buffer_destroy(context, &shader->global_uniform_buffer);
     vulkan_buffer_destroy(context, &shader->object_uniform_buffer);
@@ -187,103 +303,76 @@ void vulkan_object_shader_destroy(vulkan_context* context, struct vulkan_object_
     vkDestroyDescriptorPool(logical_device, shader->global_descriptor_pool, context->allocator);
     vkDestroyDescriptorSetLayout(logical_device, shader->global_descriptor_set_layout, context->allocator);
     vulkan_pipeline_destroy(context, &shader->pipeline);
+    vulkan_pipeline_destroy(context, &shader->instanced_pipeline);
     for (u32 i = 0; i < OBJECT_SHADER_STAGE_COUNT; i++) {
         vkDestroyShaderModule(context->device.logical_device, shader->stages[i].handle, context->allocator);
         shader->stages[i].handle = NULL;
     }
+    vkDestroyShaderModule(context->device.logical_device, shader->instanced_vertex_stage.handle, context->allocator);
+    shader->instanced_vertex_stage.handle = NULL;
 }
 
-void vulkan_object_shader_use(vulkan_context* context, struct vulkan_object_shader* shader) {
-    u32 image_index = context->image_index;
-    vulkan_pipeline_bind(&context->graphics_command_buffers[image_index], VK_PIPELINE_BIND_POINT_GRAPHICS, &shader->pipeline);
-}
-
-void vulkan_object_shader_update_global_state(vulkan_context* context, struct vulkan_object_shader* shader, f32 delta_time) {
-    u32 image_index = context->image_index;
-    VkCommandBuffer command_buffer = context->graphics_command_buffers[image_index].handle;
-    VkDescriptorSet global_descriptor = shader->global_descriptor_sets[image_index];
+static void use_pipeline(vulkan_context* context, struct vulkan_object_shader* shader, vulkan_command_buffer* command_buffer, vulkan_pipeline* pipeline) {
+    vulkan_pipeline_bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
-    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shader->pipeline.pipeline_layout, 0, 1, &global_descriptor, 0, 0);
+    VkDescriptorSet global_descriptor = shader->global_descriptor_sets[context->current_frame];
+    vkCmdBindDescriptorSets(command_buffer->handle, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline_layout, 0, 1, &global_descriptor, 0, 0);
+}
 
-    u32 range = sizeof(global_uniform_object);
-    u64 offset = 0;
+void vulkan_object_shader_use(vulkan_context* context, struct vulkan_object_shader* shader, vulkan_command_buffer* command_buffer) {
+    use_pipeline(context, shader, command_buffer, &shader->pipeline);
+}
 
-    vulkan_buffer_load_data(context, &shader->global_uniform_buffer, offset, range, 0, &shader->global_ubo);
+void vulkan_object_shader_use_instanced(vulkan_context* context, struct vulkan_object_shader* shader, vulkan_command_buffer* command_buffer) {
+    use_pipeline(context, shader, command_buffer, &shader->instanced_pipeline);
+}
 
-    VkDescriptorBufferInfo bufferInfo;
-    bufferInfo.buffer = shader->global_uniform_buffer.handle;
-    bufferInfo.offset = offset;
-    bufferInfo.range = range;
+void vulkan_object_shader_update_global_state(vulkan_context* context, struct vulkan_object_shader* shader, f32 delta_time) {
+    // The slot is keyed by the frame in flight, whose fence has already been waited on in begin_frame.
+    u32 frame = context->current_frame;
+    u64 offset = shader->global_uniform_stride * frame;
+    kcopy_memory((u8*)shader->global_uniform_buffer.mapped + offset, &shader->global_ubo, sizeof(global_uniform_object));
+    vulkan_buffer_flush(context, &shader->global_uniform_buffer, offset, sizeof(global_uniform_object));
 
-    VkWriteDescriptorSet descriptor_write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    descriptor_write.dstSet = shader->global_descriptor_sets[image_index];
-    descriptor_write.dstBinding = 0;
-    descriptor_write.dstArrayElement = 0;
-    descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    descriptor_write.descriptorCount = 1;
-    descriptor_write.pBufferInfo = &bufferInfo;
+    // TODO: get diffuse colour from a material.
+    shader->diffuse_accumulator += 0.01f;
+}
 
-    vkUpdateDescriptorSets(context->device.logical_device, 1, &descriptor_write, 0, 0);
+// Writes the object's uniform and samplers and binds its sets.
+static u64 object_uniform_offset(vulkan_context* context, struct vulkan_object_shader* shader, u32 object_id) {
+    return (((u64)context->current_frame * MAX_VULKAN_OBJECT_COUNT) + object_id) * shader->object_uniform_stride;
 }
 
-void vulkan_object_shader_update_object(vulkan_context* context, struct vulkan_object_shader* shader, geometry_render_data data) {
-    u32 image_index = context->image_index;
-    VkCommandBuffer command_buffer = context->graphics_command_buffers[image_index].handle;
+void vulkan_object_shader_prepare_object(vulkan_context* context, struct vulkan_object_shader* shader, u32 object_id, texture* const* textures) {
+    // Sets are per frame in flight rather than per swapchain image, since only the frame's fence guarantees they're idle.
+    u32 frame = context->current_frame;
 
-    vkCmdPushConstants(command_buffer, shader->pipeline.pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mat4), &data.model);
-    vulkan_object_shader_object_state* object_state = &shader->object_states[data.object_id];
-    VkDescriptorSet object_descriptor_set = object_state->descriptor_sets[image_index];
+    vulkan_object_shader_object_state* object_state = &shader->object_states[object_id];
+    VkDescriptorSet object_descriptor_set = object_state->descriptor_sets[frame];
 
     VkWriteDescriptorSet descriptor_writes[VULKAN_DESCRIPTORS_PER_OBJECT];
     kzero_memory(descriptor_writes, sizeof(VkWriteDescriptorSet) * VULKAN_DESCRIPTORS_PER_OBJECT);
     u32 descriptor_count = 0;
     u32 descriptor_index = 0;
 
-    // Descriptor 0 - Uniform buffer
-    u32 range = sizeof(object_uniform_object);
-    u64 offset = sizeof(object_uniform_object) * data.object_id;  // also the index into the array.
-    object_uniform_object obo;
+    // Object uniform - written straight into this frame's region of the mapped buffer.
+    u64 offset = object_uniform_offset(context, shader, object_id);
+    object_uniform_object* obo = (object_uniform_object*)((u8*)shader->object_uniform_buffer.mapped + offset);
 
     // TODO: get diffuse colour from a material.
-    static f32 accumulator = 0.0f;
-    accumulator += 0.01f;
-    f32 s = (ksin(accumulator) + 1.0f) / 2.0f;  // scale from -1, 1 to 0, 1
-    obo.diffuse_color.r = s;
-    obo.diffuse_color.g = s;
-    obo.diffuse_color.b = s;
-    obo.diffuse_color.a = s;
-
-    // Load the data into the buffer.
-    vulkan_buffer_load_data(context, &shader->object_uniform_buffer, offset, range, 0, &obo);
-
-    // Only do this if the descriptor has not yet been updated.
-    if (object_state->descriptor_states[descriptor_index].generations[image_index] == INVALID_ID) {
-        VkDescriptorBufferInfo buffer_info;
-        buffer_info.buffer = shader->object_uniform_buffer.handle;
-        buffer_info.offset = offset;
-        buffer_info.range = range;
-
-        VkWriteDescriptorSet descriptor = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        descriptor.dstSet = object_descriptor_set;
-        descriptor.dstBinding = descriptor_index;
-        descriptor.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptor.descriptorCount = 1;
-        descriptor.pBufferInfo = &buffer_info;
-
-        descriptor_writes[descriptor_count] = descriptor;
-        descriptor_count++;
-
-        // Update the frame generation. In this case it is only needed once since this is a buffer.
-        object_state->descriptor_states[descriptor_index].generations[image_index] = 1;
-    }
-    descriptor_index++;
+    f32 s = (ksin(shader->diffuse_accumulator) + 1.0f) / 2.0f;  // scale from -1, 1 to 0, 1
+    obo->diffuse_color.r = s;
+    obo->diffuse_color.g = s;
+    obo->diffuse_color.b = s;
+    obo->diffuse_color.a = s;
+    vulkan_buffer_flush(context, &shader->object_uniform_buffer, offset, sizeof(object_uniform_object));
 
     // TODO: samplers.
     const u32 sampler_count = 1;
     VkDescriptorImageInfo image_infos[1];
     for (u32 sampler_index = 0; sampler_index < sampler_count; sampler_index++) {
-        texture* t = data.textures[sampler_index];
-        u32* descriptor_generation = &object_state->descriptor_states[descriptor_index].generations[image_index];
+        texture* t = textures[sampler_index];
+        u32* descriptor_generation = &object_state->descriptor_states[descriptor_index].generations[frame];
 
         if (t->generation == INVALID_ID) {
             t = shader->default_diffuse;
@@ -317,6 +406,19 @@ void vulkan_object_shader_update_object(vulkan_context* context, struct vulkan_o
     if (descriptor_count > 0) {
         vkUpdateDescriptorSets(context->device.logical_device, descriptor_count, descriptor_writes, 0, 0);
     }
+}
+
+static void bind_object(vulkan_context* context, struct vulkan_object_shader* shader, VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout, u32 object_id) {
+    VkDescriptorSet object_sets[2] = {shader->object_uniform_descriptor_set, shader->object_states[object_id].descriptor_sets[context->current_frame]};
+    u32 dynamic_offset = (u32)object_uniform_offset(context, shader, object_id);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 1, 2, object_sets, 1, &dynamic_offset);
+}
+
+void vulkan_object_shader_update_object(vulkan_context* context, struct vulkan_object_shader* shader, vulkan_command_buffer* command_buffer, geometry_render_data data) {
+    vkCmdPushConstants(command_buffer->handle, shader->pipeline.pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mat4), &data.model);
+    bind_object(context, shader, command_buffer->handle, shader->pipeline.pipeline_layout, data.object_id);
+}
 
-    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shader->pipeline.pipeline_layout, 1, 1, &object_descriptor_set, 0, 0);
+void vulkan_object_shader_update_instanced(vulkan_context* context, struct vulkan_object_shader* shader, vulkan_command_buffer* command_buffer, const vulkan_instanced_draw* draw) {
+    bind_object(context, shader, command_buffer->handle, shader->instanced_pipeline.pipeline_layout, draw->object_id);
 }
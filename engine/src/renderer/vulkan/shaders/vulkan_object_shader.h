@@ -8,11 +8,24 @@ b8 vulkan_object_shader_create(vulkan_context* context, texture* default_diffuse
 
 void vulkan_object_shader_destroy(vulkan_context* context, struct vulkan_object_shader* shader);
 
-void vulkan_object_shader_use(vulkan_context* context, struct vulkan_object_shader* shader);
+// Binds the pipeline and this frame's global descriptor set.
+void vulkan_object_shader_use(vulkan_context* context, struct vulkan_object_shader* shader, vulkan_command_buffer* command_buffer);
 
+// As vulkan_object_shader_use, for the pipeline which reads model matrices from the instance buffer.
+void vulkan_object_shader_use_instanced(vulkan_context* context, struct vulkan_object_shader* shader, vulkan_command_buffer* command_buffer);
+
+// Writes global_ubo for the current frame. Records nothing.
 void vulkan_object_shader_update_global_state(vulkan_context* context, struct vulkan_object_shader* shader, f32 delta_time);
 
-void vulkan_object_shader_update_object(vulkan_context* context, struct vulkan_object_shader* shader, geometry_render_data data);
+// Writes the object's uniform and descriptor set for the current frame. Records nothing, and must be
+// called on one thread before any recording which draws the object.
+void vulkan_object_shader_prepare_object(vulkan_context* context, struct vulkan_object_shader* shader, u32 object_id, texture* const* textures);
+
+// Only records, so it's safe to call from several threads at once once the object is prepared.
+void vulkan_object_shader_update_object(vulkan_context* context, struct vulkan_object_shader* shader, vulkan_command_buffer* command_buffer, geometry_render_data data);
+
+// Binds the object sets for a batched draw. The instanced pipeline must already be in use.
+void vulkan_object_shader_update_instanced(vulkan_context* context, struct vulkan_object_shader* shader, vulkan_command_buffer* command_buffer, const vulkan_instanced_draw* draw);
 
 b8 vulkan_object_shader_acquire_resources(vulkan_context* context, struct vulkan_object_shader* shader, u32* out_object_id);
 void vulkan_object_shader_release_resources(vulkan_context* context, struct vulkan_object_shader* shader, u32 object_id);
@@ -0,0 +1,134 @@
+#include "vulkan_allocator.h"
+
+#include "core/logger.h"
+
+// Stored directly in front of every block handed to the driver.
+typedef struct vulkan_allocation_header {
+    u64 size;
+    u32 alignment;
+    u32 scope;
+} vulkan_allocation_header;
+
+static const char* scope_names[VULKAN_ALLOCATION_SCOPE_COUNT] = {
+    "Command",
+    "Object",
+    "Cache",
+    "Device",
+    "Instance"};
+
+// Space reserved in front of the returned pointer. Keeps the pointer aligned and leaves room for the header.
+static u64 header_offset(u64 alignment) {
+    return alignment > sizeof(vulkan_allocation_header) ? alignment : sizeof(vulkan_allocation_header);
+}
+
+static vulkan_allocation_header* get_header(void* memory) {
+    return (vulkan_allocation_header*)((u8*)memory - sizeof(vulkan_allocation_header));
+}
+
+// NOTE: Vulkan requires these callbacks to be safe to call from several threads at once. Everything
+// shared goes through kmemory, which locks its budget and tracker, or through the atomic stats.
+static void* VKAPI_CALL vulkan_alloc_allocation(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope allocation_scope) {
+    if (size == 0) {
+        return 0;
+    }
+    if (alignment < sizeof(vulkan_allocation_header)) {
+        alignment = sizeof(vulkan_allocation_header);
+    }
+    if (alignment > 0x8000) {
+        KERROR("vulkan_alloc_allocation - alignment of %llu is not supported.", (u64)alignment);
+        return 0;
+    }
+
+    u64 offset = header_offset(alignment);
+    u8* block = kallocate_aligned(offset + size, (u16)alignment, MEMORY_TAG_RENDERER);
+    if (!block) {
+        return 0;
+    }
+
+    u8* memory = block + offset;
+    vulkan_allocation_header* header = get_header(memory);
+    header->size = size;
+    header->alignment = (u32)alignment;
+    header->scope = allocation_scope;
+
+    vulkan_allocator_stats* stats = user_data;
+    __atomic_add_fetch(&stats->allocated[allocation_scope], size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->counts[allocation_scope], 1, __ATOMIC_RELAXED);
+    return memory;
+}
+
+static void VKAPI_CALL vulkan_free_allocation(void* user_data, void* memory) {
+    if (!memory) {
+        return;
+    }
+
+    vulkan_allocation_header* header = get_header(memory);
+    u64 size = header->size;
+    u32 alignment = header->alignment;
+    u32 scope = header->scope;
+    u64 offset = header_offset(alignment);
+
+    vulkan_allocator_stats* stats = user_data;
+    __atomic_sub_fetch(&stats->allocated[scope], size, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&stats->counts[scope], 1, __ATOMIC_RELAXED);
+
+    kfree_aligned((u8*)memory - offset, offset + size, (u16)alignment, MEMORY_TAG_RENDERER);
+}
+
+static void* VKAPI_CALL vulkan_realloc_allocation(void* user_data, void* original, size_t size, size_t alignment, VkSystemAllocationScope allocation_scope) {
+    if (!original) {
+        return vulkan_alloc_allocation(user_data, size, alignment, allocation_scope);
+    }
+    if (size == 0) {
+        vulkan_free_allocation(user_data, original);
+        return 0;
+    }
+
+    // NOTE: The spec requires alignment to match the original allocation, so a fresh block is always compatible.
+    // The original belongs to the calling thread until it is freed, so its header can be read without a lock.
+    vulkan_allocation_header* header = get_header(original);
+    if (header->size == size) {
+        return original;
+    }
+    void* result = vulkan_alloc_allocation(user_data, size, alignment, allocation_scope);
+    if (!result) {
+        // The original must be left untouched on failure.
+        return 0;
+    }
+    kcopy_memory(result, original, header->size < size ? header->size : size);
+    vulkan_free_allocation(user_data, original);
+    return result;
+}
+
+static void VKAPI_CALL vulkan_internal_alloc_notification(void* user_data, size_t size, VkInternalAllocationType allocation_type, VkSystemAllocationScope allocation_scope) {
+    vulkan_allocator_stats* stats = user_data;
+    __atomic_add_fetch(&stats->internal_allocated[allocation_scope], size, __ATOMIC_RELAXED);
+}
+
+static void VKAPI_CALL vulkan_internal_free_notification(void* user_data, size_t size, VkInternalAllocationType allocation_type, VkSystemAllocationScope allocation_scope) {
+    vulkan_allocator_stats* stats = user_data;
+    __atomic_sub_fetch(&stats->internal_allocated[allocation_scope], size, __ATOMIC_RELAXED);
+}
+
+void vulkan_allocator_create(vulkan_allocator_stats* stats, VkAllocationCallbacks* out_callbacks) {
+    kzero_memory(stats, sizeof(vulkan_allocator_stats));
+    out_callbacks->pUserData = stats;
+    out_callbacks->pfnAllocation = vulkan_alloc_allocation;
+    out_callbacks->pfnReallocation = vulkan_realloc_allocation;
+    out_callbacks->pfnFree = vulkan_free_allocation;
+    out_callbacks->pfnInternalAllocation = vulkan_internal_alloc_notification;
+    out_callbacks->pfnInternalFree = vulkan_internal_free_notification;
+}
+
+u32 vulkan_allocator_report_usage(void* user_data, memory_usage_entry* out_entries, u32 max_entries) {
+    vulkan_allocator_stats* stats = user_data;
+    u32 count = 0;
+    for (u32 i = 0; i < VULKAN_ALLOCATION_SCOPE_COUNT && count < max_entries; ++i) {
+        out_entries[count].name = scope_names[i];
+        // Internal allocations have no count of their own, so fold their bytes into the scope.
+        out_entries[count].size = __atomic_load_n(&stats->allocated[i], __ATOMIC_RELAXED) + __atomic_load_n(&stats->internal_allocated[i], __ATOMIC_RELAXED);
+        out_entries[count].count = __atomic_load_n(&stats->counts[i], __ATOMIC_RELAXED);
+        count++;
+    }
+    return count;
+}
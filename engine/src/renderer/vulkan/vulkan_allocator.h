@@ -0,0 +1,13 @@
+#pragma once
+
+#include "core/kmemory.h"
+#include "vulkan_types.inl"
+
+// Fills out callbacks which route driver host allocations through kmemory under MEMORY_TAG_RENDERER,
+// recording per-scope usage in stats. The driver calls them from whichever thread is making the
+// Vulkan call, e.g. job workers recording command buffers, so they rely on kallocate_aligned and
+// kfree_aligned being thread safe and keep no state of their own beyond the atomic stats.
+void vulkan_allocator_create(vulkan_allocator_stats* stats, VkAllocationCallbacks* out_callbacks);
+
+// A memory usage reporter (see memory_register_usage_reporter) for a vulkan_allocator_stats.
+u32 vulkan_allocator_report_usage(void* user_data, memory_usage_entry* out_entries, u32 max_entries);
@@ -9,18 +9,29 @@
 
 #include "math/math_types.h"
 #include "shaders/vulkan_object_shader.h"
+#include "vulkan_allocator.h"
 #include "vulkan_buffer.h"
 #include "vulkan_command_buffer.h"
+#include "vulkan_deletion_queue.h"
 #include "vulkan_device.h"
+#include "vulkan_draw_recorder.h"
 #include "vulkan_fence.h"
 #include "vulkan_framebuffer.h"
 #include "vulkan_image.h"
+#include "vulkan_memory.h"
 #include "vulkan_platform.h"
 #include "vulkan_renderpass.h"
+#include "vulkan_staging_buffer.h"
 #include "vulkan_swapchain.h"
+#include "vulkan_transfer.h"
 #include "vulkan_types.inl"
 #include "vulkan_utils.h"
 
+// Set to 0 to let the driver manage its own host memory.
+#ifndef KVULKAN_USE_CUSTOM_ALLOCATOR
+#define KVULKAN_USE_CUSTOM_ALLOCATOR 1
+#endif
+
 static vulkan_context context;
 static u32 cached_framebuffer_width = 0;
 static u32 cached_framebuffer_height = 0;
@@ -35,25 +46,27 @@ b8 create_buffers(vulkan_context* context);
 
 void regenerate_framebuffers(renderer_backend* backend, vulkan_swapchain* swapchain, vulkan_renderpass* renderpass);
 void create_command_buffers(renderer_backend* backend);
+void create_sync_objects();
+void destroy_sync_objects();
 b8 recreate_swapchain(renderer_backend* backend);
 
-void upload_data_range(vulkan_context* context, VkCommandPool pool, VkFence fence, VkQueue queue, vulkan_buffer* buffer, u64 offset, u64 size, void* data) {
-    VkBufferUsageFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    vulkan_buffer staging;
-    vulkan_buffer_create(context, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, flags, true, &staging);
-
-    vulkan_buffer_load_data(context, &staging, 0, size, 0, data);
-
-    vulkan_buffer_copy_to(context, pool, fence, queue, staging.handle, 0, buffer->handle, offset, size);
-
-    vulkan_buffer_destroy(context, &staging);
-}
-
-b8 vulkan_initialize(renderer_backend* backend, const char* application_name) {
+b8 vulkan_initialize(renderer_backend* backend, const char* application_name, const renderer_config* config) {
     context.find_memory_index = find_memory_index;
-
-    // TODO: Implement custom allocator
+    context.config = *config;
+    context.offscreen = config->offscreen;
+
+#if KVULKAN_USE_CUSTOM_ALLOCATOR
+    vulkan_allocator_create(&context.allocator_stats, &context.allocation_callbacks);
+    context.allocator = &context.allocation_callbacks;
+    memory_register_usage_reporter("Vulkan host allocations", vulkan_allocator_report_usage, &context.allocator_stats);
+#else
     context.allocator = NULL;
+#endif
+
+    if (!pool_allocator_create(sizeof(vulkan_texture_data), 64, 0, true, MEMORY_TAG_TEXTURE, &context.texture_data_pool)) {
+        KERROR("Failed to create texture data pool.");
+        return false;
+    }
 
     application_get_framebuffer_size(&cached_framebuffer_width, &cached_framebuffer_height);
     // TODO: de-jankify this, application isn't actually setting defaults
@@ -73,8 +86,10 @@ b8 vulkan_initialize(renderer_backend* backend, const char* application_name) {
     create_info.pApplicationInfo = &app_info;
 
     const char** required_extensions = darray_create(const char*);
-    darray_push(required_extensions, &VK_KHR_SURFACE_EXTENSION_NAME);
-    platform_get_required_extension_names(&required_extensions);
+    if (!context.offscreen) {
+        darray_push(required_extensions, &VK_KHR_SURFACE_EXTENSION_NAME);
+        platform_get_required_extension_names(&required_extensions);
+    }
 #if defined(_DEBUG)
     darray_push(required_extensions, &VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     KDEBUG("Required extensions");
@@ -144,18 +159,42 @@ b8 vulkan_initialize(renderer_backend* backend, const char* application_name) {
     KDEBUG("Vulkan debugger created");
 #endif
 
-    KDEBUG("Creating Vulkan surface...");
-    if (!platform_create_vulkan_surface(&context)) {
-        KERROR("Failed to create platform surface");
-        return false;
+    // Offscreen rendering needs no surface, so it also runs without a display or on a software
+    // implementation such as lavapipe.
+    if (context.offscreen) {
+        KINFO("Rendering offscreen, no surface will be created");
+    } else {
+        KDEBUG("Creating Vulkan surface...");
+        if (!platform_create_vulkan_surface(&context)) {
+            KERROR("Failed to create platform surface");
+            return false;
+        }
+        KDEBUG("Vulkan surface created");
     }
-    KDEBUG("Vulkan surface created");
 
     if (!vulkan_device_create(&context)) {
         KERROR("Failed to create vulkan device");
         return false;
     }
 
+    if (!vulkan_memory_allocator_create(&context, &context.memory_allocator)) {
+        KERROR("Failed to create vulkan device memory allocator");
+        return false;
+    }
+    memory_register_usage_reporter("Vulkan device memory", vulkan_memory_report_usage, &context.memory_allocator);
+
+    // TODO: Make configurable. Bounds the largest single upload (a 4096x4096 rgba texture).
+    u64 staging_buffer_size = 64 * 1024 * 1024;
+    if (!vulkan_staging_buffer_create(&context, staging_buffer_size, &context.staging_buffer)) {
+        KERROR("Failed to create vulkan staging buffer");
+        return false;
+    }
+
+    if (!vulkan_transfer_create(&context, &context.transfer)) {
+        KERROR("Failed to create vulkan transfer batches");
+        return false;
+    }
+
     vulkan_swapchain_create(
         &context,
         context.framebuffer_width,
@@ -175,20 +214,12 @@ b8 vulkan_initialize(renderer_backend* backend, const char* application_name) {
 
     create_command_buffers(backend);
 
-    context.image_available_semaphores = darray_reserve(VkSemaphore, context.swapchain.max_frames_in_flight);
-    context.queue_complete_semaphores = darray_reserve(VkSemaphore, context.swapchain.max_frames_in_flight);
-    context.in_flight_fences = darray_reserve(vulkan_fence, context.swapchain.max_frames_in_flight);
+    create_sync_objects();
 
-    for (u8 i = 0; i < context.swapchain.max_frames_in_flight; i++) {
-        VkSemaphoreCreateInfo semaphore_create_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
-        vkCreateSemaphore(context.device.logical_device, &semaphore_create_info, context.allocator, &context.image_available_semaphores[i]);
-        vkCreateSemaphore(context.device.logical_device, &semaphore_create_info, context.allocator, &context.queue_complete_semaphores[i]);
-
-        // Create the fence in a signaled state, indicating that the first frame has already been "rendered"
-        // This will prevent the application from waiting indefinitely for the first frame to render since it
-        // cannot be rendered until a frame is "rendered" before it.
-        vulkan_fence_create(&context, true, &context.in_flight_fences[i]);
-    }
+    context.frame_number = 1;
+    context.completed_frame_number = 0;
+    context.last_rendered_image_index = -1;
+    vulkan_deletion_queue_create(&context);
 
     context.images_in_flight = darray_reserve(vulkan_fence, context.swapchain.image_count);
     for (u32 i = 0; i < context.swapchain.image_count; i++) {
@@ -201,6 +232,11 @@ b8 vulkan_initialize(renderer_backend* backend, const char* application_name) {
 
     create_buffers(&context);
 
+    if (!vulkan_draw_recorder_create(&context)) {
+        KERROR("Failed to create draw recorder.");
+        return false;
+    }
+
 // TODO: Temporary test code
 #define VERT_COUNT 4
     vertex_3d verts[VERT_COUNT];
@@ -229,8 +265,8 @@ b8 vulkan_initialize(renderer_backend* backend, const char* application_name) {
 #define INDEX_COUNT 6
     u32 indices[INDEX_COUNT] = {0, 1, 2, 0, 3, 1};
 
-    upload_data_range(&context, context.device.graphics_command_pool, 0, context.device.graphics_queue, &context.object_vertex_buffer, 0, sizeof(vertex_3d) * VERT_COUNT, verts);
-    upload_data_range(&context, context.device.graphics_command_pool, 0, context.device.graphics_queue, &context.object_index_buffer, 0, sizeof(u32) * INDEX_COUNT, indices);
+    vulkan_transfer_upload_buffer(&context, &context.transfer, &context.object_vertex_buffer, 0, sizeof(vertex_3d) * VERT_COUNT, verts, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+    vulkan_transfer_upload_buffer(&context, &context.transfer, &context.object_index_buffer, 0, sizeof(u32) * INDEX_COUNT, indices, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
 
     u32 object_id = 0;
     if (!vulkan_object_shader_acquire_resources(&context, &context.object_shader, &object_id)) {
@@ -245,34 +281,18 @@ b8 vulkan_initialize(renderer_backend* backend, const char* application_name) {
 void vulkan_shutdown(renderer_backend* backend) {
     vkDeviceWaitIdle(context.device.logical_device);
 
+    vulkan_draw_recorder_destroy(&context);
+
+    if (context.readback_buffer.handle) {
+        vulkan_buffer_destroy(&context, &context.readback_buffer);
+    }
+
     vulkan_buffer_destroy(&context, &context.object_vertex_buffer);
     vulkan_buffer_destroy(&context, &context.object_index_buffer);
 
     vulkan_object_shader_destroy(&context, &context.object_shader);
 
-    for (u8 i = 0; i < context.swapchain.max_frames_in_flight; i++) {
-        if (context.image_available_semaphores[i]) {
-            vkDestroySemaphore(
-                context.device.logical_device,
-                context.image_available_semaphores[i],
-                context.allocator);
-        }
-        if (context.queue_complete_semaphores[i]) {
-            vkDestroySemaphore(
-                context.device.logical_device,
-                context.queue_complete_semaphores[i],
-                context.allocator);
-        }
-        vulkan_fence_destroy(&context, &context.in_flight_fences[i]);
-    }
-    darray_destroy(context.image_available_semaphores);
-    context.image_available_semaphores = NULL;
-
-    darray_destroy(context.queue_complete_semaphores);
-    context.queue_complete_semaphores = NULL;
-
-    darray_destroy(context.in_flight_fences);
-    context.in_flight_fences = NULL;
+    destroy_sync_objects();
 
     darray_destroy(context.images_in_flight);
     context.images_in_flight = NULL;
@@ -297,6 +317,14 @@ void vulkan_shutdown(renderer_backend* backend) {
 
     vulkan_swapchain_destroy(&context, &context.swapchain);
 
+    // The device is idle by now, so anything still queued can go.
+    vulkan_deletion_queue_destroy(&context);
+    vulkan_transfer_destroy(&context, &context.transfer);
+    vulkan_staging_buffer_destroy(&context, &context.staging_buffer);
+
+    memory_unregister_usage_reporter(vulkan_memory_report_usage, &context.memory_allocator);
+    vulkan_memory_allocator_destroy(&context, &context.memory_allocator);
+
     KDEBUG("Destroying Vulkan device");
     vulkan_device_destroy(&context);
 
@@ -315,6 +343,19 @@ void vulkan_shutdown(renderer_backend* backend) {
 
     KDEBUG("Destroying Vulkan instance");
     vkDestroyInstance(context.instance, context.allocator);
+
+#if KVULKAN_USE_CUSTOM_ALLOCATOR
+    memory_unregister_usage_reporter(vulkan_allocator_report_usage, &context.allocator_stats);
+    context.allocator = NULL;
+#endif
+
+    pool_allocator_destroy(&context.texture_data_pool);
+}
+
+void vulkan_set_config(renderer_backend* backend, const renderer_config* config) {
+    context.config = *config;
+    context.config_changed = true;
+    KINFO("Vulkan renderer config changed: %u frames in flight, present mode %u", config->frames_in_flight, config->present_mode);
 }
 
 void vulkan_resized(renderer_backend* backend, u16 width, u16 height) {
@@ -327,32 +368,20 @@ void vulkan_resized(renderer_backend* backend, u16 width, u16 height) {
 
 b8 vulkan_begin_frame(renderer_backend* backend, f32 delta_time) {
     context.frame_delta_time = delta_time;
-    vulkan_device* device = &context.device;
     if (context.recreating_swapchain) {
-        VkResult result = vkDeviceWaitIdle(device->logical_device);
-        if (!vulkan_result_is_success(result)) {
-            KERROR("vulkan_renderer_backend_begin_frame vkDeviceWaitIdle (1) failed: '%s'", vulkan_result_string(result, true));
-            return false;
-        }
         KINFO("Recreating swap chain, booting");
         return false;
     }
 
-    if (context.framebuffer_size_generation != context.framebuffer_size_last_generation) {
-        VkResult result = vkDeviceWaitIdle(device->logical_device);
-        if (!vulkan_result_is_success(result)) {
-            KERROR("vulkan_renderer_backend_begin_frame vkDeviceWaitIdle (2) failed: '%s'", vulkan_result_string(result, true));
-            return false;
-        }
-
+    // The frame carries on with the new swapchain rather than being dropped.
+    if (context.swapchain.out_of_date ||
+        context.framebuffer_size_generation != context.framebuffer_size_last_generation ||
+        context.config_changed) {
         // if the swapchain recreation failed (because for example the application is minimized)
         // boot out before unsetting the flag
         if (!recreate_swapchain(backend)) {
             return false;
         }
-
-        KINFO("Resized. botting.");
-        return false;
     }
 
     // TODO: Fix this timeout?
@@ -364,6 +393,14 @@ b8 vulkan_begin_frame(renderer_backend* backend, f32 delta_time) {
         return false;
     }
 
+    // Every frame up to the one which last used this fence is done, along with anything it released.
+    u64 slot_frame_number = context.in_flight_frame_numbers[context.current_frame];
+    if (slot_frame_number > context.completed_frame_number) {
+        context.completed_frame_number = slot_frame_number;
+    }
+    vulkan_deletion_queue_process(&context, context.completed_frame_number);
+    vulkan_staging_buffer_reclaim(&context, &context.staging_buffer);
+
     // Acquire the next image from the swapchain. Pass along the semaphore that should signal when this completes.
     // This same semaphore will later be waited on by the queue submission to ensure this image is available
     if (!vulkan_swapchain_acquire_next_image_index(
@@ -373,31 +410,30 @@ b8 vulkan_begin_frame(renderer_backend* backend, f32 delta_time) {
             context.image_available_semaphores[context.current_frame],
             0,
             &context.image_index)) {
-        return false;
+        // The surface changed under us. A failed acquire signals nothing, so retrying once is safe.
+        if (!context.swapchain.out_of_date || !recreate_swapchain(backend)) {
+            return false;
+        }
+        if (!vulkan_swapchain_acquire_next_image_index(
+                &context,
+                &context.swapchain,
+                UINT64_MAX,
+                context.image_available_semaphores[context.current_frame],
+                0,
+                &context.image_index)) {
+            return false;
+        }
     }
 
+    // Only now that the acquire has succeeded. Recreating the swapchain above starts the frame slots
+    // again from 0, and that slot's secondaries are the ones which need recycling. Its fence was
+    // waited on by the recreate.
+    vulkan_draw_recorder_begin_frame(&context);
+
     vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
     vulkan_command_buffer_reset(command_buffer);
     vulkan_command_buffer_begin(command_buffer, false, false, false);
 
-    VkViewport viewport;
-    viewport.x = 0.0f;
-    viewport.y = (f32)context.framebuffer_height;
-    viewport.width = (f32)context.framebuffer_width;
-    // Negate here so the view port is consistent with OpenGL's
-    viewport.height = -(f32)context.framebuffer_height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor;
-    scissor.offset.x = 0;
-    scissor.offset.y = 0;
-    scissor.extent.width = context.framebuffer_width;
-    scissor.extent.height = context.framebuffer_height;
-
-    vkCmdSetViewport(command_buffer->handle, 0, 1, &viewport);
-    vkCmdSetScissor(command_buffer->handle, 0, 1, &scissor);
-
     // TODO: Probably don't need to do this every frame
     context.main_renderpass.w = context.framebuffer_width;
     context.main_renderpass.h = context.framebuffer_height;
@@ -405,15 +441,14 @@ b8 vulkan_begin_frame(renderer_backend* backend, f32 delta_time) {
     vulkan_renderpass_begin(
         command_buffer,
         &context.main_renderpass,
-        context.swapchain.framebuffers[context.image_index].handle);
+        context.swapchain.framebuffers[context.image_index].handle,
+        VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
     return true;
 }
 
 // Take copies instead of references so the engine can continue simulation without being blocked by renderering
 void vulkan_renderer_update_global_state(mat4 projection, mat4 view, vec3 view_position, vec4 ambient_colour, i32 mode) {
-    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
-    vulkan_object_shader_use(&context, &context.object_shader);
     context.object_shader.global_ubo.projection = projection;
     context.object_shader.global_ubo.view = view;
     vulkan_object_shader_update_global_state(&context, &context.object_shader, context.frame_delta_time);
@@ -422,6 +457,8 @@ void vulkan_renderer_update_global_state(mat4 projection, mat4 view, vec3 view_p
 b8 vulkan_end_frame(renderer_backend* backend, f32 delta_time) {
     vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
 
+    vulkan_draw_recorder_execute(&context, command_buffer, context.swapchain.framebuffers[context.image_index].handle);
+
     vulkan_renderpass_end(command_buffer, &context.main_renderpass);
 
     vulkan_command_buffer_end(command_buffer);
@@ -439,15 +476,19 @@ b8 vulkan_end_frame(renderer_backend* backend, f32 delta_time) {
 
     vulkan_fence_reset(&context, &context.in_flight_fences[context.current_frame]);
 
+    // Kick off anything uploaded this frame. The submit below is ordered behind it on the gpu.
+    vulkan_transfer_flush(&context, &context.transfer);
+
     VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
 
     submit_info.commandBufferCount = 1;
     submit_info.pCommandBuffers = &command_buffer->handle;
 
-    submit_info.signalSemaphoreCount = 1;
+    // Offscreen images aren't acquired or presented, so there's nothing to wait on or signal.
+    submit_info.signalSemaphoreCount = context.offscreen ? 0 : 1;
     submit_info.pSignalSemaphores = &context.queue_complete_semaphores[context.current_frame];
 
-    submit_info.waitSemaphoreCount = 1;
+    submit_info.waitSemaphoreCount = context.offscreen ? 0 : 1;
     submit_info.pWaitSemaphores = &context.image_available_semaphores[context.current_frame];
 
     VkPipelineStageFlags flags[1] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
@@ -466,6 +507,10 @@ b8 vulkan_end_frame(renderer_backend* backend, f32 delta_time) {
 
     vulkan_command_buffer_update_submitted(command_buffer);
 
+    context.last_rendered_image_index = context.image_index;
+    context.in_flight_frame_numbers[context.current_frame] = context.frame_number;
+    context.frame_number++;
+
     vulkan_swapchain_present(
         &context,
         &context.swapchain,
@@ -478,19 +523,110 @@ b8 vulkan_end_frame(renderer_backend* backend, f32 delta_time) {
 }
 
 void vulkan_update_object(geometry_render_data data) {
-    vulkan_object_shader_update_object(&context, &context.object_shader, data);
+    // Recorded into secondary command buffers at the end of the frame.
+    vulkan_draw_recorder_push(&context, &data);
+}
 
-    // TODO: temporary test code
-    vulkan_object_shader_use(&context, &context.object_shader);
+void vulkan_draw_instanced(instanced_render_data data) {
+    vulkan_draw_recorder_push_instanced(&context, &data);
+}
 
-    vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
-    VkDeviceSize offsets[1] = {0};
-    vkCmdBindVertexBuffers(command_buffer->handle, 0, 1, &context.object_vertex_buffer.handle, (VkDeviceSize*)offsets);
+b8 vulkan_read_pixels(renderer_backend* backend, u32* out_width, u32* out_height, u8* out_pixels) {
+    *out_width = context.framebuffer_width;
+    *out_height = context.framebuffer_height;
+    if (!out_pixels) {
+        return true;
+    }
 
-    vkCmdBindIndexBuffer(command_buffer->handle, context.object_index_buffer.handle, 0, VK_INDEX_TYPE_UINT32);
+    // A presented image belongs to the presentation engine until it's acquired again.
+    if (!context.offscreen) {
+        KWARN("vulkan_read_pixels - only supported when rendering offscreen.");
+        return false;
+    }
+    if (context.last_rendered_image_index < 0) {
+        KWARN("vulkan_read_pixels - no frame has been rendered yet.");
+        return false;
+    }
 
-    vkCmdDrawIndexed(command_buffer->handle, 6, 1, 0, 0, 0);
-    // TODO: end temporary test code
+    u64 size = (u64)context.framebuffer_width * context.framebuffer_height * 4;
+    if (context.readback_buffer.total_size < size) {
+        if (context.readback_buffer.handle) {
+            vulkan_buffer_destroy(&context, &context.readback_buffer);
+        }
+        if (!vulkan_buffer_create(
+                &context,
+                size,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                true,
+                true,
+                &context.readback_buffer)) {
+            KERROR("vulkan_read_pixels - readback buffer creation failed.");
+            return false;
+        }
+    }
+
+    VkImage image = context.swapchain.images[context.last_rendered_image_index];
+
+    vulkan_command_buffer command_buffer;
+    vulkan_command_buffer_allocate_and_begin_single_use(&context, context.device.graphics_command_pool, &command_buffer);
+
+    // The renderpass left the image in TRANSFER_SRC_OPTIMAL, but its writes still need to be made
+    // visible to the copy. Submission order puts the frame which rendered it in the first scope.
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(
+        command_buffer.handle,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, 0, 0, 0, 1, &barrier);
+
+    VkBufferImageCopy region = {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent.width = context.framebuffer_width;
+    region.imageExtent.height = context.framebuffer_height;
+    region.imageExtent.depth = 1;
+    vkCmdCopyImageToBuffer(command_buffer.handle, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, context.readback_buffer.handle, 1, &region);
+
+    VkBufferMemoryBarrier host_barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+    host_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    host_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    host_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    host_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    host_barrier.buffer = context.readback_buffer.handle;
+    host_barrier.offset = 0;
+    host_barrier.size = size;
+    vkCmdPipelineBarrier(
+        command_buffer.handle,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0, 0, 0, 1, &host_barrier, 0, 0);
+
+    vulkan_command_buffer_end_single_use(&context, context.device.graphics_command_pool, &command_buffer, context.device.graphics_queue, 0);
+
+    // This is a sync point by design: the caller wants the pixels now.
+    VK_CHECK(vkQueueWaitIdle(context.device.graphics_queue));
+
+    vulkan_buffer_invalidate(&context, &context.readback_buffer, 0, size);
+    kcopy_memory(out_pixels, context.readback_buffer.mapped, size);
+    return true;
 }
 
 VKAPI_ATTR VkBool32 VKAPI_CALL
@@ -574,6 +710,56 @@ void create_command_buffers(renderer_backend* backend) {
     KINFO("Vulkan command buffers created");
 }
 
+void create_sync_objects() {
+    u8 frames_in_flight = context.swapchain.max_frames_in_flight;
+    context.image_available_semaphores = darray_reserve(VkSemaphore, frames_in_flight);
+    context.queue_complete_semaphores = darray_reserve(VkSemaphore, frames_in_flight);
+    context.in_flight_fences = darray_reserve(vulkan_fence, frames_in_flight);
+    context.in_flight_frame_numbers = darray_reserve(u64, frames_in_flight);
+
+    for (u8 i = 0; i < frames_in_flight; i++) {
+        VkSemaphoreCreateInfo semaphore_create_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        vkCreateSemaphore(context.device.logical_device, &semaphore_create_info, context.allocator, &context.image_available_semaphores[i]);
+        vkCreateSemaphore(context.device.logical_device, &semaphore_create_info, context.allocator, &context.queue_complete_semaphores[i]);
+
+        // Create the fence in a signaled state, indicating that the first frame has already been "rendered"
+        // This will prevent the application from waiting indefinitely for the first frame to render since it
+        // cannot be rendered until a frame is "rendered" before it.
+        vulkan_fence_create(&context, true, &context.in_flight_fences[i]);
+        context.in_flight_frame_numbers[i] = 0;
+    }
+}
+
+// Assumes the device is idle.
+void destroy_sync_objects() {
+    for (u8 i = 0; i < context.swapchain.max_frames_in_flight; i++) {
+        if (context.image_available_semaphores[i]) {
+            vkDestroySemaphore(
+                context.device.logical_device,
+                context.image_available_semaphores[i],
+                context.allocator);
+        }
+        if (context.queue_complete_semaphores[i]) {
+            vkDestroySemaphore(
+                context.device.logical_device,
+                context.queue_complete_semaphores[i],
+                context.allocator);
+        }
+        vulkan_fence_destroy(&context, &context.in_flight_fences[i]);
+    }
+    darray_destroy(context.image_available_semaphores);
+    context.image_available_semaphores = NULL;
+
+    darray_destroy(context.queue_complete_semaphores);
+    context.queue_complete_semaphores = NULL;
+
+    darray_destroy(context.in_flight_fences);
+    context.in_flight_fences = NULL;
+
+    darray_destroy(context.in_flight_frame_numbers);
+    context.in_flight_frame_numbers = NULL;
+}
+
 b8 recreate_swapchain(renderer_backend* backend) {
     if (context.recreating_swapchain) {
         KDEBUG("recreate_swapchain called when already recreating");
@@ -586,41 +772,91 @@ b8 recreate_swapchain(renderer_backend* backend) {
     }
 
     context.recreating_swapchain = true;
-    vkDeviceWaitIdle(context.device.logical_device);
 
-    for (u32 i = 0; i < context.swapchain.image_count; i++) {
-        context.images_in_flight[i] = NULL;
+    b8 frames_in_flight_changed = context.config.frames_in_flight != context.swapchain.max_frames_in_flight;
+    if (frames_in_flight_changed) {
+        // The per-frame semaphores are about to be destroyed, and a queued present may still wait on one.
+        vkDeviceWaitIdle(context.device.logical_device);
+    } else {
+        // Only the frames in flight can be rendering to the old images. Presents still queued against them
+        // are covered by deferring the old swapchain's destruction rather than waiting here.
+        for (u8 i = 0; i < context.swapchain.max_frames_in_flight; i++) {
+            if (!vulkan_fence_wait(&context, &context.in_flight_fences[i], UINT64_MAX)) {
+                KWARN("recreate_swapchain - in-flight fence wait failure!");
+            }
+        }
+    }
+
+    // Frame slots are handed out from scratch with the new swapchain. Everything submitted is done.
+    context.completed_frame_number = context.frame_number - 1;
+    for (u8 i = 0; i < context.swapchain.max_frames_in_flight; i++) {
+        context.in_flight_frame_numbers[i] = 0;
+    }
+    vulkan_deletion_queue_process(&context, context.completed_frame_number);
+
+    // Framebuffers reference the old image views, so they go first.
+    u32 old_image_count = context.swapchain.image_count;
+    for (u32 i = 0; i < old_image_count; i++) {
+        vulkan_framebuffer_destroy(&context, &context.swapchain.framebuffers[i]);
+    }
+
+    if (frames_in_flight_changed) {
+        destroy_sync_objects();
+        context.swapchain.max_frames_in_flight = context.config.frames_in_flight;
     }
 
-    vulkan_device_query_swapchain_support(
-        context.device.physical_device,
-        context.surface,
-        &context.device.swapchain_support);
+    if (!context.offscreen) {
+        vulkan_device_query_swapchain_support(
+            context.device.physical_device,
+            context.surface,
+            &context.device.swapchain_support);
+    }
     vulkan_device_detect_depth_format(&context.device);
 
+    // A config change or out of date surface doesn't supply a new size.
+    if (cached_framebuffer_width == 0 || cached_framebuffer_height == 0) {
+        cached_framebuffer_width = context.framebuffer_width;
+        cached_framebuffer_height = context.framebuffer_height;
+    }
+
     vulkan_swapchain_recreate(
         &context,
         cached_framebuffer_width,
         cached_framebuffer_height,
         &context.swapchain);
+    context.config_changed = false;
+
+    if (frames_in_flight_changed) {
+        create_sync_objects();
+    }
+
+    // Command buffers are reset every frame, so they're only rebuilt when there are a different number of images.
+    if (context.swapchain.image_count != old_image_count) {
+        for (u32 i = 0; i < old_image_count; i++) {
+            vulkan_command_buffer_free(&context, context.device.graphics_command_pool, &context.graphics_command_buffers[i]);
+        }
+        darray_destroy(context.graphics_command_buffers);
+        context.graphics_command_buffers = NULL;
+        create_command_buffers(backend);
+
+        darray_destroy(context.swapchain.framebuffers);
+        context.swapchain.framebuffers = darray_reserve(vulkan_framebuffer, context.swapchain.image_count);
+        darray_destroy(context.images_in_flight);
+        context.images_in_flight = darray_reserve(vulkan_fence*, context.swapchain.image_count);
+    }
+    for (u32 i = 0; i < context.swapchain.image_count; i++) {
+        context.images_in_flight[i] = NULL;
+    }
+    // The new images hold nothing yet.
+    context.last_rendered_image_index = -1;
 
     context.framebuffer_width = cached_framebuffer_width;
     context.framebuffer_height = cached_framebuffer_height;
-    context.main_renderpass.w = context.framebuffer_width;
-    context.main_renderpass.h = context.framebuffer_height;
     cached_framebuffer_width = 0;
     cached_framebuffer_height = 0;
 
     context.framebuffer_size_last_generation = context.framebuffer_size_generation;
 
-    for (u32 i = 0; i < context.swapchain.image_count; i++) {
-        vulkan_command_buffer_free(&context, context.device.graphics_command_pool, &context.graphics_command_buffers[i]);
-    }
-
-    for (u32 i = 0; i < context.swapchain.image_count; i++) {
-        vulkan_framebuffer_destroy(&context, &context.swapchain.framebuffers[i]);
-    }
-
     context.main_renderpass.x = 0;
     context.main_renderpass.y = 0;
     context.main_renderpass.w = context.framebuffer_width;
@@ -628,8 +864,6 @@ b8 recreate_swapchain(renderer_backend* backend) {
 
     regenerate_framebuffers(backend, &context.swapchain, &context.main_renderpass);
 
-    create_command_buffers(backend);
-
     context.recreating_swapchain = false;
 
     return true;
@@ -645,6 +879,7 @@ b8 create_buffers(vulkan_context* context) {
             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             memory_property_flags,
             true,
+            false,
             &context->object_vertex_buffer)) {
         KERROR("Error creating vertex buffer.");
         return false;
@@ -658,6 +893,7 @@ b8 create_buffers(vulkan_context* context) {
             VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             memory_property_flags,
             true,
+            false,
             &context->object_index_buffer)) {
         KERROR("Error creating vertex buffer.");
         return false;
@@ -673,22 +909,14 @@ void vulkan_renderer_create_texture(const char* name, b8 auto_release, i32 width
     out_texture->generation = INVALID_ID;
 
     // Internal data creation.
-    // TODO: Use an allocator for this.
-    out_texture->internal_data = (vulkan_texture_data*)kallocate(sizeof(vulkan_texture_data), MEMORY_TAG_TEXTURE);
+    out_texture->internal_data = (vulkan_texture_data*)pool_allocator_allocate(&context.texture_data_pool);
+    kzero_memory(out_texture->internal_data, sizeof(vulkan_texture_data));
     vulkan_texture_data* data = (vulkan_texture_data*)out_texture->internal_data;
     VkDeviceSize image_size = width * height * channel_count;
 
     // NOTE: Assumes 8 bits per channel.
     VkFormat image_format = VK_FORMAT_R8G8B8A8_UNORM;
 
-    // Create a staging buffer and load data into it.
-    VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    VkMemoryPropertyFlags memory_prop_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    vulkan_buffer staging;
-    vulkan_buffer_create(&context, image_size, usage, memory_prop_flags, true, &staging);
-
-    vulkan_buffer_load_data(&context, &staging, 0, image_size, 0, pixels);
-
     // NOTE: Lots of assumptions here, different texture types will require
     // different options here.
     vulkan_image_create(
@@ -704,34 +932,10 @@ void vulkan_renderer_create_texture(const char* name, b8 auto_release, i32 width
         VK_IMAGE_ASPECT_COLOR_BIT,
         &data->image);
 
-    vulkan_command_buffer temp_buffer;
-    VkCommandPool pool = context.device.graphics_command_pool;
-    VkQueue queue = context.device.graphics_queue;
-    vulkan_command_buffer_allocate_and_begin_single_use(&context, pool, &temp_buffer);
-
-    // Transition the layout from whatever it is currently to optimal for recieving data.
-    vulkan_image_transition_layout(
-        &context,
-        &temp_buffer,
-        &data->image,
-        image_format,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-    // Copy the data from the buffer.
-    vulkan_image_copy_from_buffer(&context, &data->image, staging.handle, &temp_buffer);
-
-    // Transition from optimal for data reciept to shader-read-only optimal layout.
-    vulkan_image_transition_layout(
-        &context,
-        &temp_buffer,
-        &data->image,
-        image_format,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    vulkan_command_buffer_end_single_use(&context, pool, &temp_buffer, queue);
-    vulkan_buffer_destroy(&context, &staging);
+    // Recorded on the transfer queue and submitted with the next frame, so this doesn't wait on the gpu.
+    if (!vulkan_transfer_upload_image(&context, &context.transfer, &data->image, image_size, pixels)) {
+        KERROR("vulkan_renderer_create_texture - failed to upload pixels for texture '%s'.", name);
+    }
 
     // Create a sampler for the texture
     VkSamplerCreateInfo sampler_info = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
@@ -763,16 +967,14 @@ void vulkan_renderer_create_texture(const char* name, b8 auto_release, i32 width
 }
 
 void vulkan_renderer_destroy_texture(struct texture* texture) {
-    vkDeviceWaitIdle(context.device.logical_device);
-
     vulkan_texture_data* data = (vulkan_texture_data*)texture->internal_data;
     if (data != NULL) {
-        vulkan_image_destroy(&context, &data->image);
-        kzero_memory(&data->image, sizeof(vulkan_image));
-        vkDestroySampler(context.device.logical_device, data->sampler, context.allocator);
+        // In-flight frames (and any pending upload) may still reference these, so destroy them once those finish.
+        vulkan_deletion_queue_push_image(&context, &data->image);
+        vulkan_deletion_queue_push_sampler(&context, data->sampler);
         data->sampler = 0;
 
-        kfree(texture->internal_data, sizeof(vulkan_texture_data), MEMORY_TAG_TEXTURE);
+        pool_allocator_free(&context.texture_data_pool, texture->internal_data);
     }
 
     kzero_memory(texture, sizeof(struct texture));
@@ -785,20 +987,20 @@ b8 vulkan_object_shader_acquire_resources(vulkan_context* context, struct vulkan
     u32 object_id = *out_object_id;
     vulkan_object_shader_object_state* object_state = &shader->object_states[object_id];
     for (u32 i = 0; i < VULKAN_DESCRIPTORS_PER_OBJECT; i++) {
-        for (u32 j = 0; j < 3; j++) {
+        for (u32 j = 0; j < VULKAN_MAX_FRAMES_IN_FLIGHT; j++) {
             object_state->descriptor_states[i].generations[j] = INVALID_ID;
         }
     }
 
     // Allocate descriptor sets.
-    VkDescriptorSetLayout layouts[3] = {
-        shader->object_descriptor_set_layout,
-        shader->object_descriptor_set_layout,
-        shader->object_descriptor_set_layout};
+    VkDescriptorSetLayout layouts[VULKAN_MAX_FRAMES_IN_FLIGHT];
+    for (u32 i = 0; i < VULKAN_MAX_FRAMES_IN_FLIGHT; i++) {
+        layouts[i] = shader->object_descriptor_set_layout;
+    }
 
     VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
     alloc_info.descriptorPool = shader->object_descriptor_pool;
-    alloc_info.descriptorSetCount = 3;  // one per frame
+    alloc_info.descriptorSetCount = VULKAN_MAX_FRAMES_IN_FLIGHT;  // one per frame
     alloc_info.pSetLayouts = layouts;
     VkResult result = vkAllocateDescriptorSets(context->device.logical_device, &alloc_info, object_state->descriptor_sets);
     if (result != VK_SUCCESS) {
@@ -812,7 +1014,7 @@ b8 vulkan_object_shader_acquire_resources(vulkan_context* context, struct vulkan
 void vulkan_object_shader_release_resources(vulkan_context* context, struct vulkan_object_shader* shader, u32 object_id) {
     vulkan_object_shader_object_state* object_state = &shader->object_states[object_id];
 
-    const u32 descriptor_set_count = 3;
+    const u32 descriptor_set_count = VULKAN_MAX_FRAMES_IN_FLIGHT;
     // Release object descriptor sets.
     VkResult result = vkFreeDescriptorSets(context->device.logical_device, shader->object_descriptor_pool, descriptor_set_count, object_state->descriptor_sets);
     if (result != VK_SUCCESS) {
@@ -820,7 +1022,7 @@ void vulkan_object_shader_release_resources(vulkan_context* context, struct vulk
     }
 
     for (u32 i = 0; i < VULKAN_DESCRIPTORS_PER_OBJECT; i++) {
-        for (u32 j = 0; j < 3; j++) {
+        for (u32 j = 0; j < VULKAN_MAX_FRAMES_IN_FLIGHT; j++) {
             object_state->descriptor_states[i].generations[j] = INVALID_ID;
         }
     }
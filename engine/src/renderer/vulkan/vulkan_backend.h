@@ -3,9 +3,11 @@
 #include "renderer/renderer_backend.h"
 #include "resources/resource_types.h"
 
-b8 vulkan_initialize(renderer_backend* backend, const char* application_name);
+b8 vulkan_initialize(renderer_backend* backend, const char* application_name, const renderer_config* config);
 void vulkan_shutdown(renderer_backend* backend);
 
+void vulkan_set_config(renderer_backend* backend, const renderer_config* config);
+
 void vulkan_resized(renderer_backend* backend, u16 width, u16 height);
 
 b8 vulkan_begin_frame(renderer_backend* backend, f32 delta_time);
@@ -13,6 +15,9 @@ void vulkan_renderer_update_global_state(mat4 projection, mat4 view, vec3 view_p
 b8 vulkan_end_frame(renderer_backend* backend, f32 delta_time);
 
 void vulkan_update_object(geometry_render_data data);
+void vulkan_draw_instanced(instanced_render_data data);
 
 void vulkan_renderer_create_texture(const char* name, b8 auto_release, i32 width, i32 height, i32 channel_count, const u8* pixels, b8 has_transparency, texture* out_texture);
 void vulkan_renderer_destroy_texture(texture* texture);
+
+b8 vulkan_read_pixels(renderer_backend* backend, u32* out_width, u32* out_height, u8* out_pixels);
@@ -4,7 +4,9 @@
 #include "core/logger.h"
 
 #include "vulkan_command_buffer.h"
+#include "vulkan_deletion_queue.h"
 #include "vulkan_device.h"
+#include "vulkan_memory.h"
 #include "vulkan_utils.h"
 
 b8 vulkan_buffer_create(
@@ -13,6 +15,7 @@ b8 vulkan_buffer_create(
     VkBufferUsageFlagBits usage,
     u32 memory_property_flags,
     b8 bind_on_create,
+    b8 persistently_mapped,
     vulkan_buffer* out_buffer) {
     kzero_memory(out_buffer, sizeof(vulkan_buffer));
     out_buffer->total_size = size;
@@ -25,27 +28,28 @@ b8 vulkan_buffer_create(
     buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     VK_CHECK(vkCreateBuffer(context->device.logical_device, &buffer_info, context->allocator, &out_buffer->handle));
 
-    VkMemoryRequirements requirements;
-    vkGetBufferMemoryRequirements(context->device.logical_device, out_buffer->handle, &requirements);
-    out_buffer->memory_index = context->find_memory_index(requirements.memoryTypeBits, out_buffer->memory_property_flags);
-    if (out_buffer->memory_index == -1) {
-        KERROR("Unable to create vulkan buffer because the required memory type index was not found");
+    out_buffer->memory_index = -1;
+    if (!vulkan_memory_allocate_for_buffer(context, out_buffer->handle, out_buffer->memory_property_flags, &out_buffer->allocation)) {
+        KERROR("Unable to create vulkan buffer because the required memory allocation failed.");
+        vulkan_buffer_destroy(context, out_buffer);
         return false;
     }
-
-    VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    allocate_info.allocationSize = requirements.size;
-    allocate_info.memoryTypeIndex = (u32)out_buffer->memory_index;
-
-    VkResult result = vkAllocateMemory(
-        context->device.logical_device,
-        &allocate_info,
-        context->allocator,
-        &out_buffer->memory);
-
-    if (result != VK_SUCCESS) {
-        KERROR("Unable to create vulkan buffer because the required memeory allocation failed. Error: %i", result);
-        return false;
+    out_buffer->memory_index = (i32)out_buffer->allocation.memory_type_index;
+    VkMemoryPropertyFlags type_flags = context->device.memory.memoryTypes[out_buffer->memory_index].propertyFlags;
+    out_buffer->is_coherent = (type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+    if (persistently_mapped) {
+        if (!(type_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+            KERROR("vulkan_buffer_create - a persistently mapped buffer requires host visible memory.");
+            vulkan_buffer_destroy(context, out_buffer);
+            return false;
+        }
+        out_buffer->mapped = vulkan_memory_map(context, &out_buffer->allocation);
+        if (!out_buffer->mapped) {
+            KERROR("vulkan_buffer_create - failed to map buffer memory.");
+            vulkan_buffer_destroy(context, out_buffer);
+            return false;
+        }
     }
 
     if (bind_on_create) {
@@ -56,10 +60,11 @@ b8 vulkan_buffer_create(
 }
 
 void vulkan_buffer_destroy(vulkan_context* context, vulkan_buffer* buffer) {
-    if (buffer->memory) {
-        vkFreeMemory(context->device.logical_device, buffer->memory, context->allocator);
-        buffer->memory = NULL;
+    if (buffer->mapped) {
+        vulkan_memory_unmap(context, &buffer->allocation);
+        buffer->mapped = 0;
     }
+    vulkan_memory_free(context, &buffer->allocation);
 
     if (buffer->handle) {
         vkDestroyBuffer(context->device.logical_device, buffer->handle, context->allocator);
@@ -79,61 +84,97 @@ b8 vulkan_buffer_resize(vulkan_context* context, u64 new_size, vulkan_buffer* bu
     VkBuffer new_buffer;
     VK_CHECK(vkCreateBuffer(context->device.logical_device, &buffer_info, context->allocator, &new_buffer));
 
-    VkMemoryRequirements requirements;
-    vkGetBufferMemoryRequirements(context->device.logical_device, new_buffer, &requirements);
-
-    VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    allocate_info.allocationSize = requirements.size;
-    allocate_info.memoryTypeIndex = (u32)buffer->memory_index;
-
-    VkDeviceMemory new_memory;
-    VkResult result = vkAllocateMemory(context->device.logical_device, &allocate_info, context->allocator, &new_memory);
-    if (result != VK_SUCCESS) {
-        KERROR("Unable to resize vulkan buffer because the required memory allocation failed. Error: %i", result);
+    vulkan_memory_allocation new_allocation;
+    if (!vulkan_memory_allocate_for_buffer(context, new_buffer, buffer->memory_property_flags, &new_allocation)) {
+        KERROR("Unable to resize vulkan buffer because the required memory allocation failed.");
+        vkDestroyBuffer(context->device.logical_device, new_buffer, context->allocator);
         return false;
     }
 
-    VK_CHECK(vkBindBufferMemory(context->device.logical_device, new_buffer, new_memory, 0));
+    VK_CHECK(vkBindBufferMemory(context->device.logical_device, new_buffer, new_allocation.memory, new_allocation.offset));
 
     vulkan_buffer_copy_to(context, pool, 0, queue, buffer->handle, 0, new_buffer, 0, buffer->total_size);
 
-    vkDeviceWaitIdle(context->device.logical_device);
-
-    if (buffer->memory) {
-        vkFreeMemory(context->device.logical_device, buffer->memory, context->allocator);
-        buffer->memory = 0;
-    }
-    if (buffer->handle) {
-        vkDestroyBuffer(context->device.logical_device, buffer->handle, context->allocator);
-        buffer->handle = 0;
-    }
+    // The copy and any in-flight frames still read the old buffer. Queuing it also drops its mapping.
+    b8 persistently_mapped = buffer->mapped != 0;
+    vulkan_deletion_queue_push_buffer(context, buffer);
 
     buffer->total_size = new_size;
-    buffer->memory = new_memory;
+    buffer->allocation = new_allocation;
     buffer->handle = new_buffer;
+    if (persistently_mapped) {
+        buffer->mapped = vulkan_memory_map(context, &buffer->allocation);
+    }
 
     return true;
 }
 
 void vulkan_buffer_bind(vulkan_context* context, vulkan_buffer* buffer, u64 offset) {
-    VK_CHECK(vkBindBufferMemory(context->device.logical_device, buffer->handle, buffer->memory, offset));
+    // offset is relative to the buffer's own allocation, which may sit anywhere in a shared block.
+    VK_CHECK(vkBindBufferMemory(context->device.logical_device, buffer->handle, buffer->allocation.memory, buffer->allocation.offset + offset));
 }
 
 void* vulkan_buffer_lock_memory(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size, u32 flags) {
-    void* data;
-    VK_CHECK(vkMapMemory(context->device.logical_device, buffer->memory, offset, size, flags, &data));
-    return data;
+    u8* data = buffer->mapped ? buffer->mapped : vulkan_memory_map(context, &buffer->allocation);
+    buffer->is_locked = true;
+    return data + offset;
 }
 
 void vulkan_buffer_unlock_memory(vulkan_context* context, vulkan_buffer* buffer) {
-    vkUnmapMemory(context->device.logical_device, buffer->memory);
+    if (!buffer->mapped) {
+        vulkan_memory_unmap(context, &buffer->allocation);
+    }
+    buffer->is_locked = false;
+}
+
+// Builds a range covering [offset, offset + size) within the buffer, widened to nonCoherentAtomSize.
+// Allocations from non-coherent memory are atom aligned, so this never reaches into a neighbour.
+static VkMappedMemoryRange mapped_range(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size) {
+    u64 atom = context->device.properties.limits.nonCoherentAtomSize;
+    u64 start = buffer->allocation.offset + offset;
+    u64 end = start + size;
+    u64 allocation_end = buffer->allocation.offset + buffer->allocation.size;
+
+    start &= ~(atom - 1);
+    end = (end + atom - 1) & ~(atom - 1);
+    if (end > allocation_end) {
+        end = allocation_end;
+    }
+
+    VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE};
+    range.memory = buffer->allocation.memory;
+    range.offset = start;
+    range.size = end - start;
+    return range;
+}
+
+void vulkan_buffer_flush(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size) {
+    if (buffer->is_coherent) {
+        return;
+    }
+    VkMappedMemoryRange range = mapped_range(context, buffer, offset, size);
+    VK_CHECK(vkFlushMappedMemoryRanges(context->device.logical_device, 1, &range));
+}
+
+void vulkan_buffer_invalidate(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size) {
+    if (buffer->is_coherent) {
+        return;
+    }
+    VkMappedMemoryRange range = mapped_range(context, buffer, offset, size);
+    VK_CHECK(vkInvalidateMappedMemoryRanges(context->device.logical_device, 1, &range));
 }
 
 void vulkan_buffer_load_data(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size, u32 flags, const void* data) {
-    void* data_ptr;
-    VK_CHECK(vkMapMemory(context->device.logical_device, buffer->memory, offset, size, flags, &data_ptr));
-    kcopy_memory(data_ptr, data, size);
-    vkUnmapMemory(context->device.logical_device, buffer->memory);
+    if (buffer->mapped) {
+        kcopy_memory((u8*)buffer->mapped + offset, data, size);
+        vulkan_buffer_flush(context, buffer, offset, size);
+        return;
+    }
+
+    u8* data_ptr = vulkan_memory_map(context, &buffer->allocation);
+    kcopy_memory(data_ptr + offset, data, size);
+    vulkan_buffer_flush(context, buffer, offset, size);
+    vulkan_memory_unmap(context, &buffer->allocation);
 }
 
 void vulkan_buffer_copy_to(
@@ -146,10 +187,15 @@ void vulkan_buffer_copy_to(
     VkBuffer dest,
     u64 dest_offset,
     u64 size) {
-    vkQueueWaitIdle(queue);
     vulkan_command_buffer temp_command_buffer;
     vulkan_command_buffer_allocate_and_begin_single_use(context, pool, &temp_command_buffer);
 
+    // Order the copy after earlier work on the queue which may touch either buffer, instead of idling the queue.
+    VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(temp_command_buffer.handle, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, 0, 0, 0);
+
     VkBufferCopy copy_region;
     copy_region.srcOffset = source_offset;
     copy_region.dstOffset = dest_offset;
@@ -157,5 +203,5 @@ void vulkan_buffer_copy_to(
 
     vkCmdCopyBuffer(temp_command_buffer.handle, source, dest, 1, &copy_region);
 
-    vulkan_command_buffer_end_single_use(context, pool, &temp_command_buffer, queue);
+    vulkan_command_buffer_end_single_use(context, pool, &temp_command_buffer, queue, fence);
 }
\ No newline at end of file
@@ -8,6 +8,7 @@ b8 vulkan_buffer_create(
     VkBufferUsageFlagBits usage,
     u32 memory_property_flags,
     b8 bind_on_create,
+    b8 persistently_mapped,
     vulkan_buffer* out_buffer);
 
 void vulkan_buffer_destroy(vulkan_context* context, vulkan_buffer* buffer);
@@ -20,6 +21,12 @@ void* vulkan_buffer_lock_memory(vulkan_context* context, vulkan_buffer* buffer,
 
 void vulkan_buffer_unlock_memory(vulkan_context* context, vulkan_buffer* buffer);
 
+// Makes host writes to [offset, offset + size) visible to the device. Does nothing for coherent memory.
+void vulkan_buffer_flush(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size);
+
+// Makes device writes to [offset, offset + size) visible to the host. Does nothing for coherent memory.
+void vulkan_buffer_invalidate(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size);
+
 void vulkan_buffer_load_data(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size, u32 flags, const void* data);
 
 void vulkan_buffer_copy_to(vulkan_context* context, VkCommandPool pool, VkFence fence, VkQueue queue, VkBuffer source, u64 source_offset, VkBuffer dest, u64 dest_offset, u64 size);
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "core/kmemory.h"
 
+#include "vulkan_deletion_queue.h"
+
 void vulkan_command_buffer_allocate(
     vulkan_context* context,
     VkCommandPool pool,
@@ -56,6 +58,22 @@ void vulkan_command_buffer_begin(
     command_buffer->state = COMMAND_BUFFER_STATE_RECORDING;
 }
 
+void vulkan_command_buffer_begin_secondary(
+    vulkan_command_buffer* command_buffer,
+    VkRenderPass renderpass,
+    VkFramebuffer framebuffer) {
+    VkCommandBufferInheritanceInfo inheritance_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+    inheritance_info.renderPass = renderpass;
+    inheritance_info.subpass = 0;
+    inheritance_info.framebuffer = framebuffer;
+
+    VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance_info;
+    VK_CHECK(vkBeginCommandBuffer(command_buffer->handle, &begin_info));
+    command_buffer->state = COMMAND_BUFFER_STATE_RECORDING;
+}
+
 // TODO: validate state is valid for transitions in the following functions
 
 void vulkan_command_buffer_end(vulkan_command_buffer* command_buffer) {
@@ -84,15 +102,15 @@ void vulkan_command_buffer_end_single_use(
     vulkan_context* context,
     VkCommandPool pool,
     vulkan_command_buffer* command_buffer,
-    VkQueue queue) {
+    VkQueue queue,
+    VkFence fence) {
     vulkan_command_buffer_end(command_buffer);
 
     VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
     submit_info.commandBufferCount = 1;
     submit_info.pCommandBuffers = &command_buffer->handle;
-    VK_CHECK(vkQueueSubmit(queue, 1, &submit_info, 0));
-
-    VK_CHECK(vkQueueWaitIdle(queue));
+    VK_CHECK(vkQueueSubmit(queue, 1, &submit_info, fence));
 
-    vulkan_command_buffer_free(context, pool, command_buffer);
+    // Can't be freed until it has executed, which the frame submitted after it will tell us.
+    vulkan_deletion_queue_push_command_buffer(context, pool, command_buffer);
 }
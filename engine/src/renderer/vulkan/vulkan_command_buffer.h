@@ -19,6 +19,12 @@ void vulkan_command_buffer_begin(
     b8 is_renderpass_continue,
     b8 is_simultaneous_use);
 
+// Begins a secondary command buffer which continues subpass 0 of renderpass.
+void vulkan_command_buffer_begin_secondary(
+    vulkan_command_buffer* command_buffer,
+    VkRenderPass renderpass,
+    VkFramebuffer framebuffer);
+
 void vulkan_command_buffer_end(vulkan_command_buffer* command_buffer);
 
 void vulkan_command_buffer_update_submitted(vulkan_command_buffer* command_buffer);
@@ -31,8 +37,11 @@ void vulkan_command_buffer_allocate_and_begin_single_use(
     VkCommandPool pool,
     vulkan_command_buffer* out_command_buffer);
 
+// Submits without waiting. The command buffer is freed once the frame being recorded has
+// finished, which only covers work on the graphics queue.
 void vulkan_command_buffer_end_single_use(
     vulkan_context* context,
     VkCommandPool pool,
     vulkan_command_buffer* command_buffer,
-    VkQueue queue);
+    VkQueue queue,
+    VkFence fence);
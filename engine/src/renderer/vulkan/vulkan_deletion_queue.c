@@ -0,0 +1,117 @@
+#include "vulkan_deletion_queue.h"
+
+#include "containers/darray.h"
+#include "core/kmemory.h"
+
+#include "vulkan_memory.h"
+
+static void push(vulkan_context* context, vulkan_deletion* deletion) {
+    deletion->frame_number = context->frame_number;
+    darray_push(context->deletion_queue, *deletion);
+}
+
+static void destroy_entry(vulkan_context* context, vulkan_deletion* deletion) {
+    VkDevice device = context->device.logical_device;
+    switch (deletion->type) {
+        case VULKAN_DELETION_TYPE_BUFFER:
+            vkDestroyBuffer(device, deletion->buffer, context->allocator);
+            vulkan_memory_free(context, &deletion->allocation);
+            break;
+        case VULKAN_DELETION_TYPE_IMAGE:
+            if (deletion->view) {
+                vkDestroyImageView(device, deletion->view, context->allocator);
+            }
+            vkDestroyImage(device, deletion->image, context->allocator);
+            vulkan_memory_free(context, &deletion->allocation);
+            break;
+        case VULKAN_DELETION_TYPE_SAMPLER:
+            vkDestroySampler(device, deletion->sampler, context->allocator);
+            break;
+        case VULKAN_DELETION_TYPE_COMMAND_BUFFER:
+            vkFreeCommandBuffers(device, deletion->pool, 1, &deletion->command_buffer);
+            break;
+        case VULKAN_DELETION_TYPE_SWAPCHAIN:
+            vkDestroySwapchainKHR(device, deletion->swapchain, context->allocator);
+            break;
+    }
+}
+
+void vulkan_deletion_queue_create(vulkan_context* context) {
+    context->deletion_queue = darray_create(vulkan_deletion);
+}
+
+void vulkan_deletion_queue_destroy(vulkan_context* context) {
+    vulkan_deletion_queue_process(context, UINT64_MAX);
+    darray_destroy(context->deletion_queue);
+    context->deletion_queue = 0;
+}
+
+void vulkan_deletion_queue_push_buffer(vulkan_context* context, vulkan_buffer* buffer) {
+    if (buffer->mapped) {
+        vulkan_memory_unmap(context, &buffer->allocation);
+        buffer->mapped = 0;
+    }
+
+    vulkan_deletion deletion = {};
+    deletion.type = VULKAN_DELETION_TYPE_BUFFER;
+    deletion.buffer = buffer->handle;
+    deletion.allocation = buffer->allocation;
+    push(context, &deletion);
+
+    buffer->handle = 0;
+    kzero_memory(&buffer->allocation, sizeof(vulkan_memory_allocation));
+}
+
+void vulkan_deletion_queue_push_image(vulkan_context* context, vulkan_image* image) {
+    vulkan_deletion deletion = {};
+    deletion.type = VULKAN_DELETION_TYPE_IMAGE;
+    deletion.image = image->handle;
+    deletion.view = image->view;
+    deletion.allocation = image->allocation;
+    push(context, &deletion);
+
+    kzero_memory(image, sizeof(vulkan_image));
+}
+
+void vulkan_deletion_queue_push_sampler(vulkan_context* context, VkSampler sampler) {
+    vulkan_deletion deletion = {};
+    deletion.type = VULKAN_DELETION_TYPE_SAMPLER;
+    deletion.sampler = sampler;
+    push(context, &deletion);
+}
+
+void vulkan_deletion_queue_push_command_buffer(vulkan_context* context, VkCommandPool pool, vulkan_command_buffer* command_buffer) {
+    vulkan_deletion deletion = {};
+    deletion.type = VULKAN_DELETION_TYPE_COMMAND_BUFFER;
+    deletion.pool = pool;
+    deletion.command_buffer = command_buffer->handle;
+    push(context, &deletion);
+
+    command_buffer->handle = 0;
+    command_buffer->state = COMMAND_BUFFER_STATE_STATE_NOT_ALLOCATED;
+}
+
+void vulkan_deletion_queue_push_swapchain(vulkan_context* context, VkSwapchainKHR swapchain) {
+    vulkan_deletion deletion = {};
+    deletion.type = VULKAN_DELETION_TYPE_SWAPCHAIN;
+    deletion.swapchain = swapchain;
+    push(context, &deletion);
+}
+
+void vulkan_deletion_queue_process(vulkan_context* context, u64 completed_frame_number) {
+    // Entries are pushed in frame order, so everything ready is at the front.
+    u64 count = darray_length(context->deletion_queue);
+    u64 ready = 0;
+    while (ready < count && context->deletion_queue[ready].frame_number <= completed_frame_number) {
+        destroy_entry(context, &context->deletion_queue[ready]);
+        ready++;
+    }
+    if (ready == 0) {
+        return;
+    }
+
+    for (u64 i = ready; i < count; ++i) {
+        context->deletion_queue[i - ready] = context->deletion_queue[i];
+    }
+    darray_length_set(context->deletion_queue, count - ready);
+}
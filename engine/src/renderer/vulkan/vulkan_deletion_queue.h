@@ -0,0 +1,25 @@
+#pragma once
+
+#include "vulkan_types.inl"
+
+// Resources pushed here are destroyed once every frame up to and including the one
+// currently being recorded has finished, rather than stalling the device to destroy them now.
+void vulkan_deletion_queue_create(vulkan_context* context);
+
+// Destroys everything still queued. The device must be idle.
+void vulkan_deletion_queue_destroy(vulkan_context* context);
+
+void vulkan_deletion_queue_push_buffer(vulkan_context* context, vulkan_buffer* buffer);
+
+void vulkan_deletion_queue_push_image(vulkan_context* context, vulkan_image* image);
+
+void vulkan_deletion_queue_push_sampler(vulkan_context* context, VkSampler sampler);
+
+void vulkan_deletion_queue_push_command_buffer(vulkan_context* context, VkCommandPool pool, vulkan_command_buffer* command_buffer);
+
+// For a swapchain retired by a recreate. Presents may still be queued against its images, and
+// only a later frame's fence signalling shows that they have finished.
+void vulkan_deletion_queue_push_swapchain(vulkan_context* context, VkSwapchainKHR swapchain);
+
+// Destroys everything released during or before completed_frame_number.
+void vulkan_deletion_queue_process(vulkan_context* context, u64 completed_frame_number);
@@ -6,6 +6,10 @@
 #include "core/kstring.h"
 #include "core/logger.h"
 
+#include "vulkan_pipeline_cache.h"
+
+#define VULKAN_PIPELINE_CACHE_PATH "./pipeline_cache.bin"
+
 typedef struct vulkan_physical_device_requirements {
     b8 graphics;
     b8 present;
@@ -90,10 +94,10 @@ b8 vulkan_device_create(vulkan_context* context) {
     device_create_info.queueCreateInfoCount = index_count;
     device_create_info.pQueueCreateInfos = queue_create_infos;
     device_create_info.pEnabledFeatures = &device_features;
-    device_create_info.enabledExtensionCount = 1;
-
+    // Offscreen rendering never creates a swapchain.
     const char* extension_names = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
-    device_create_info.ppEnabledExtensionNames = &extension_names;
+    device_create_info.enabledExtensionCount = context->offscreen ? 0 : 1;
+    device_create_info.ppEnabledExtensionNames = context->offscreen ? NULL : &extension_names;
 
     // Deprecated and ignored, so pass nothing
     device_create_info.enabledLayerCount = 0;
@@ -135,6 +139,20 @@ b8 vulkan_device_create(vulkan_context* context) {
 
     KINFO("Graphics command pool created");
 
+    pool_create_info.queueFamilyIndex = context->device.transfer_queue_index;
+    VK_CHECK(vkCreateCommandPool(
+        context->device.logical_device,
+        &pool_create_info,
+        context->allocator,
+        &context->device.transfer_command_pool));
+
+    KINFO("Transfer command pool created");
+
+    if (!vulkan_pipeline_cache_create(context, VULKAN_PIPELINE_CACHE_PATH)) {
+        // Pipelines still build without one, just more slowly.
+        KWARN("Continuing without a pipeline cache");
+    }
+
     return true;
 }
 
@@ -143,11 +161,18 @@ void vulkan_device_destroy(vulkan_context* context) {
     context->device.graphics_queue = 0;
     context->device.transfer_queue = 0;
 
+    KINFO("Saving pipeline cache");
+    vulkan_pipeline_cache_destroy(context, VULKAN_PIPELINE_CACHE_PATH);
+
     KINFO("Destroying command pools");
     vkDestroyCommandPool(
         context->device.logical_device,
         context->device.graphics_command_pool,
         context->allocator);
+    vkDestroyCommandPool(
+        context->device.logical_device,
+        context->device.transfer_command_pool,
+        context->allocator);
 
     KINFO("Destroying logical device");
     if (context->device.logical_device) {
@@ -287,14 +312,16 @@ b8 select_physical_device(vulkan_context* context) {
 
         vulkan_physical_device_requirements requirements = {};
         requirements.graphics = true;
-        requirements.present = true;
+        requirements.present = !context->offscreen;
         requirements.transfer = true;
         // NOTE: Enable this if compute will be required
         // requirements.compute = TRUE;
         requirements.sampler_anisotropy = true;
         requirements.discrete_gpu = true;
         requirements.device_extension_names = darray_create(const char*);
-        darray_push(requirements.device_extension_names, &VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        if (!context->offscreen) {
+            darray_push(requirements.device_extension_names, &VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        }
 
         vulkan_physical_device_queue_family_info queue_info = {};
         b8 result = physical_device_meets_requirements(
@@ -348,7 +375,8 @@ b8 select_physical_device(vulkan_context* context) {
 
             context->device.physical_device = physical_devices[i];
             context->device.graphics_queue_index = queue_info.graphics_family_index;
-            context->device.present_queue_index = queue_info.present_family_index;
+            // Nothing is presented offscreen, so the present queue is just an alias for graphics.
+            context->device.present_queue_index = context->offscreen ? queue_info.graphics_family_index : queue_info.present_family_index;
             context->device.transfer_queue_index = queue_info.transfer_family_index;
 
             context->device.properties = properties;
@@ -416,10 +444,12 @@ b8 physical_device_meets_requirements(
             }
         }
 
-        VkBool32 supports_present = VK_FALSE;
-        VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &supports_present));
-        if (supports_present) {
-            out_queue_info->present_family_index = i;
+        if (surface) {
+            VkBool32 supports_present = VK_FALSE;
+            VK_CHECK(vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &supports_present));
+            if (supports_present) {
+                out_queue_info->present_family_index = i;
+            }
         }
     }
     // Print out some info about the device
@@ -442,8 +472,10 @@ b8 physical_device_meets_requirements(
         KTRACE("Transfer family index: %i", out_queue_info->transfer_family_index);
     }
 
-    vulkan_device_query_swapchain_support(device, surface, out_swapchain_support);
-    if (out_swapchain_support->format_count < 1 || out_swapchain_support->present_mode_count < 1) {
+    if (requirements->present) {
+        vulkan_device_query_swapchain_support(device, surface, out_swapchain_support);
+    }
+    if (requirements->present && (out_swapchain_support->format_count < 1 || out_swapchain_support->present_mode_count < 1)) {
         if (out_swapchain_support->formats) {
             kfree(out_swapchain_support->formats, sizeof(VkSurfaceFormatKHR) * out_swapchain_support->format_count, MEMORY_TAG_RENDERER);
         }
@@ -483,8 +515,8 @@ b8 physical_device_meets_requirements(
                     kfree(available_extensions, sizeof(VkExtensionProperties) * available_extension_count, MEMORY_TAG_RENDERER);
                     return false;
                 }
-                kfree(available_extensions, sizeof(VkExtensionProperties) * available_extension_count, MEMORY_TAG_RENDERER);
             }
+            kfree(available_extensions, sizeof(VkExtensionProperties) * available_extension_count, MEMORY_TAG_RENDERER);
         }
         if (requirements->sampler_anisotropy && !features->samplerAnisotropy) {
             KINFO("Required sampler anisotropy not supported. Skipping device.");
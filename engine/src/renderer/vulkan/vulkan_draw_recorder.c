@@ -0,0 +1,237 @@
+#include "vulkan_draw_recorder.h"
+
+#include "containers/darray.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "systems/job_system.h"
+
+#include "shaders/vulkan_object_shader.h"
+#include "vulkan_buffer.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_utils.h"
+
+// Everything one worker needs to record its slice of the draw list. Nothing here is shared
+// with another chunk, so chunks can be recorded on separate threads.
+typedef struct record_chunk {
+    vulkan_context* context;
+    vulkan_command_buffer* command_buffer;
+    VkFramebuffer framebuffer;
+    const geometry_render_data* draws;
+    u32 draw_count;
+    const vulkan_instanced_draw* instanced_draws;
+    u32 instanced_draw_count;
+} record_chunk;
+
+static void record_chunk_run(void* params) {
+    record_chunk* chunk = params;
+    vulkan_context* context = chunk->context;
+    vulkan_command_buffer* command_buffer = chunk->command_buffer;
+
+    vulkan_command_buffer_begin_secondary(command_buffer, context->main_renderpass.handle, chunk->framebuffer);
+
+    // Dynamic state isn't inherited from the primary.
+    VkViewport viewport;
+    viewport.x = 0.0f;
+    viewport.y = (f32)context->framebuffer_height;
+    viewport.width = (f32)context->framebuffer_width;
+    // Negate here so the view port is consistent with OpenGL's
+    viewport.height = -(f32)context->framebuffer_height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor;
+    scissor.offset.x = 0;
+    scissor.offset.y = 0;
+    scissor.extent.width = context->framebuffer_width;
+    scissor.extent.height = context->framebuffer_height;
+
+    vkCmdSetViewport(command_buffer->handle, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer->handle, 0, 1, &scissor);
+
+    // TODO: temporary test code
+    VkDeviceSize offsets[1] = {0};
+    vkCmdBindVertexBuffers(command_buffer->handle, 0, 1, &context->object_vertex_buffer.handle, (VkDeviceSize*)offsets);
+    vkCmdBindIndexBuffer(command_buffer->handle, context->object_index_buffer.handle, 0, VK_INDEX_TYPE_UINT32);
+
+    if (chunk->draw_count > 0) {
+        vulkan_object_shader_use(context, &context->object_shader, command_buffer);
+        for (u32 i = 0; i < chunk->draw_count; ++i) {
+            vulkan_object_shader_update_object(context, &context->object_shader, command_buffer, chunk->draws[i]);
+            vkCmdDrawIndexed(command_buffer->handle, 6, 1, 0, 0, 0);
+        }
+    }
+
+    if (chunk->instanced_draw_count > 0) {
+        vulkan_object_shader_use_instanced(context, &context->object_shader, command_buffer);
+        // Every frame's instances share the buffer; first_instance already points into this frame's region.
+        vkCmdBindVertexBuffers(command_buffer->handle, 1, 1, &context->instance_buffer.handle, (VkDeviceSize*)offsets);
+        for (u32 i = 0; i < chunk->instanced_draw_count; ++i) {
+            const vulkan_instanced_draw* draw = &chunk->instanced_draws[i];
+            vulkan_object_shader_update_instanced(context, &context->object_shader, command_buffer, draw);
+            vkCmdDrawIndexed(command_buffer->handle, 6, draw->instance_count, 0, 0, draw->first_instance);
+        }
+    }
+    // TODO: end temporary test code
+
+    vulkan_command_buffer_end(command_buffer);
+}
+
+b8 vulkan_draw_recorder_create(vulkan_context* context) {
+    // A chunk per thread which can run jobs.
+    context->record_worker_count = job_system_thread_count();
+    if (context->record_worker_count > VULKAN_MAX_RECORD_WORKERS) {
+        context->record_worker_count = VULKAN_MAX_RECORD_WORKERS;
+    }
+
+    VkCommandPoolCreateInfo pool_create_info = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    pool_create_info.queueFamilyIndex = context->device.graphics_queue_index;
+    pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    for (u32 w = 0; w < context->record_worker_count; ++w) {
+        vulkan_record_worker* worker = &context->record_workers[w];
+        for (u32 f = 0; f < VULKAN_MAX_FRAMES_IN_FLIGHT; ++f) {
+            VkResult result = vkCreateCommandPool(context->device.logical_device, &pool_create_info, context->allocator, &worker->pools[f]);
+            if (!vulkan_result_is_success(result)) {
+                KERROR("vulkan_draw_recorder_create - command pool creation failed: %s", vulkan_result_string(result, true));
+                return false;
+            }
+            vulkan_command_buffer_allocate(context, worker->pools[f], false, &worker->command_buffers[f]);
+        }
+    }
+
+    u32 device_local_bits = context->device.supports_device_local_host_visible ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : 0;
+    if (!vulkan_buffer_create(
+            context,
+            sizeof(render_instance_data) * VULKAN_MAX_INSTANCES_PER_FRAME * VULKAN_MAX_FRAMES_IN_FLIGHT,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | device_local_bits,
+            true,
+            true,
+            &context->instance_buffer)) {
+        KERROR("vulkan_draw_recorder_create - instance buffer creation failed.");
+        return false;
+    }
+    context->instance_count = 0;
+
+    context->draw_list = darray_create(geometry_render_data);
+    context->instanced_draw_list = darray_create(vulkan_instanced_draw);
+    return true;
+}
+
+void vulkan_draw_recorder_destroy(vulkan_context* context) {
+    for (u32 w = 0; w < context->record_worker_count; ++w) {
+        vulkan_record_worker* worker = &context->record_workers[w];
+        for (u32 f = 0; f < VULKAN_MAX_FRAMES_IN_FLIGHT; ++f) {
+            if (worker->pools[f]) {
+                // Frees the pool's command buffers along with it.
+                vkDestroyCommandPool(context->device.logical_device, worker->pools[f], context->allocator);
+                worker->pools[f] = 0;
+            }
+            kzero_memory(&worker->command_buffers[f], sizeof(vulkan_command_buffer));
+        }
+    }
+    context->record_worker_count = 0;
+
+    vulkan_buffer_destroy(context, &context->instance_buffer);
+
+    if (context->draw_list) {
+        darray_destroy(context->draw_list);
+        context->draw_list = 0;
+    }
+    if (context->instanced_draw_list) {
+        darray_destroy(context->instanced_draw_list);
+        context->instanced_draw_list = 0;
+    }
+}
+
+void vulkan_draw_recorder_begin_frame(vulkan_context* context) {
+    u32 frame = context->current_frame;
+    for (u32 w = 0; w < context->record_worker_count; ++w) {
+        vulkan_record_worker* worker = &context->record_workers[w];
+        VK_CHECK(vkResetCommandPool(context->device.logical_device, worker->pools[frame], 0));
+        vulkan_command_buffer_reset(&worker->command_buffers[frame]);
+    }
+    darray_clear(context->draw_list);
+    darray_clear(context->instanced_draw_list);
+    context->instance_count = 0;
+}
+
+void vulkan_draw_recorder_push(vulkan_context* context, const geometry_render_data* data) {
+    // Descriptor and uniform writes happen here, on the submitting thread, so the recording jobs only record.
+    vulkan_object_shader_prepare_object(context, &context->object_shader, data->object_id, data->textures);
+    darray_push(context->draw_list, *data);
+}
+
+void vulkan_draw_recorder_push_instanced(vulkan_context* context, const instanced_render_data* data) {
+    u32 count = data->instance_count;
+    if (context->instance_count + count > VULKAN_MAX_INSTANCES_PER_FRAME) {
+        KWARN("vulkan_draw_recorder_push_instanced - instance buffer full, dropping %u instances.", context->instance_count + count - VULKAN_MAX_INSTANCES_PER_FRAME);
+        count = VULKAN_MAX_INSTANCES_PER_FRAME - context->instance_count;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    // The frame's fence has been waited on, so nothing is still reading its region.
+    u32 first_instance = context->current_frame * VULKAN_MAX_INSTANCES_PER_FRAME + context->instance_count;
+    u64 offset = (u64)first_instance * sizeof(render_instance_data);
+    u64 size = (u64)count * sizeof(render_instance_data);
+    kcopy_memory((u8*)context->instance_buffer.mapped + offset, data->instances, size);
+    vulkan_buffer_flush(context, &context->instance_buffer, offset, size);
+    context->instance_count += count;
+
+    vulkan_object_shader_prepare_object(context, &context->object_shader, data->object_id, data->textures);
+
+    vulkan_instanced_draw draw;
+    draw.object_id = data->object_id;
+    kcopy_memory(draw.textures, data->textures, sizeof(draw.textures));
+    draw.first_instance = first_instance;
+    draw.instance_count = count;
+    darray_push(context->instanced_draw_list, draw);
+}
+
+void vulkan_draw_recorder_execute(vulkan_context* context, vulkan_command_buffer* primary, VkFramebuffer framebuffer) {
+    u32 draw_count = (u32)darray_length(context->draw_list);
+    u32 instanced_draw_count = (u32)darray_length(context->instanced_draw_list);
+    if (draw_count == 0 && instanced_draw_count == 0) {
+        return;
+    }
+
+    u32 chunk_count = (draw_count + VULKAN_MIN_DRAWS_PER_WORKER - 1) / VULKAN_MIN_DRAWS_PER_WORKER;
+    if (chunk_count > context->record_worker_count) {
+        chunk_count = context->record_worker_count;
+    }
+    if (chunk_count == 0) {
+        chunk_count = 1;
+    }
+    u32 per_chunk = (draw_count + chunk_count - 1) / chunk_count;
+
+    record_chunk chunks[VULKAN_MAX_RECORD_WORKERS];
+    VkCommandBuffer handles[VULKAN_MAX_RECORD_WORKERS];
+    job_info jobs[VULKAN_MAX_RECORD_WORKERS];
+    job_counter recorded = {};
+    u32 first = 0;
+    for (u32 i = 0; i < chunk_count; ++i) {
+        u32 count = draw_count - first < per_chunk ? draw_count - first : per_chunk;
+        chunks[i].context = context;
+        chunks[i].command_buffer = &context->record_workers[i].command_buffers[context->current_frame];
+        chunks[i].framebuffer = framebuffer;
+        chunks[i].draws = context->draw_list + first;
+        chunks[i].draw_count = count;
+        // Batched draws are few and cheap to record, so they aren't worth splitting.
+        chunks[i].instanced_draws = i == 0 ? context->instanced_draw_list : 0;
+        chunks[i].instanced_draw_count = i == 0 ? instanced_draw_count : 0;
+        handles[i] = chunks[i].command_buffer->handle;
+        jobs[i] = job_create(record_chunk_run, &chunks[i], JOB_PRIORITY_HIGH, &recorded);
+        first += count;
+    }
+
+    // Each chunk only touches its own pool and command buffer, so they can record on any thread.
+    // Host allocations the driver makes while recording go through context->allocator, which is
+    // safe to call from several threads at once (see vulkan_allocator.h).
+    // This thread records too while it waits.
+    job_system_submit(jobs, chunk_count);
+    job_system_wait(&recorded);
+
+    vkCmdExecuteCommands(primary->handle, chunk_count, handles);
+}
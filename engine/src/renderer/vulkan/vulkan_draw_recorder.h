@@ -0,0 +1,21 @@
+#pragma once
+
+#include "vulkan_types.inl"
+
+// Draws are queued over the frame, then split into chunks which are each recorded into a
+// secondary command buffer and executed from the primary inside the main renderpass.
+b8 vulkan_draw_recorder_create(vulkan_context* context);
+
+void vulkan_draw_recorder_destroy(vulkan_context* context);
+
+// Recycles the current frame's secondaries. Call once its in-flight fence has been waited on.
+void vulkan_draw_recorder_begin_frame(vulkan_context* context);
+
+void vulkan_draw_recorder_push(vulkan_context* context, const geometry_render_data* data);
+
+// Copies the instances into this frame's region of the instance buffer and queues one draw for them.
+void vulkan_draw_recorder_push_instanced(vulkan_context* context, const instanced_render_data* data);
+
+// Records the queued draws and executes them into primary, which must be inside the main
+// renderpass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+void vulkan_draw_recorder_execute(vulkan_context* context, vulkan_command_buffer* primary, VkFramebuffer framebuffer);
@@ -4,6 +4,7 @@
 #include "core/logger.h"
 
 #include "vulkan_device.h"
+#include "vulkan_memory.h"
 
 void vulkan_image_create(
     vulkan_context* context,
@@ -37,23 +38,12 @@ void vulkan_image_create(
 
     VK_CHECK(vkCreateImage(context->device.logical_device, &image_create_info, context->allocator, &out_image->handle));
 
-    VkMemoryRequirements memory_requirements;
-    vkGetImageMemoryRequirements(context->device.logical_device, out_image->handle, &memory_requirements);
-
-    i32 memory_type = context->find_memory_index(memory_requirements.memoryTypeBits, memory_flags);
-    if (memory_flags == -1) {
-        KERROR("Require memory type not found. Image not valid");
+    if (!vulkan_memory_allocate_for_image(context, out_image->handle, tiling, memory_flags, &out_image->allocation)) {
+        KERROR("Required memory for image could not be allocated. Image not valid");
+        return;
     }
 
-    VkMemoryAllocateInfo memory_allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO};
-    memory_allocate_info.allocationSize = memory_requirements.size;
-    memory_allocate_info.memoryTypeIndex = memory_type;
-    memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-
-    VK_CHECK(vkAllocateMemory(context->device.logical_device, &memory_allocate_info, context->allocator, &out_image->memory));
-
-    // TODO: configurable memory offset
-    VK_CHECK(vkBindImageMemory(context->device.logical_device, out_image->handle, out_image->memory, 0));
+    VK_CHECK(vkBindImageMemory(context->device.logical_device, out_image->handle, out_image->allocation.memory, out_image->allocation.offset));
 
     if (create_view) {
         out_image->view = NULL;
@@ -135,10 +125,11 @@ void vulkan_image_copy_from_buffer(
     vulkan_context* context,
     vulkan_image* image,
     VkBuffer buffer,
+    u64 buffer_offset,
     vulkan_command_buffer* command_buffer) {
     VkBufferImageCopy region;
     kzero_memory(&region, sizeof(VkBufferImageCopy));
-    region.bufferOffset = 0;
+    region.bufferOffset = buffer_offset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
 
@@ -165,10 +156,7 @@ void vulkan_image_destroy(vulkan_context* context, vulkan_image* image) {
         vkDestroyImageView(context->device.logical_device, image->view, context->allocator);
         image->view = NULL;
     }
-    if (image->memory) {
-        vkFreeMemory(context->device.logical_device, image->memory, context->allocator);
-        image->memory = NULL;
-    }
+    vulkan_memory_free(context, &image->allocation);
     if (image->handle) {
         vkDestroyImage(context->device.logical_device, image->handle, context->allocator);
         image->handle = NULL;
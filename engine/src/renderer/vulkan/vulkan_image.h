@@ -33,6 +33,7 @@ void vulkan_image_copy_from_buffer(
     vulkan_context* context,
     vulkan_image* image,
     VkBuffer buffer,
+    u64 buffer_offset,
     vulkan_command_buffer* command_buffer);
 
 void vulkan_image_destroy(vulkan_context* context, vulkan_image* image);
@@ -0,0 +1,397 @@
+#include "vulkan_memory.h"
+
+#include "containers/darray.h"
+#include "core/logger.h"
+
+#include "vulkan_utils.h"
+
+#define VULKAN_MEMORY_MAX_BLOCK_SIZE (64 * 1024 * 1024)
+
+// Anything at least this fraction of a block gets its own allocation rather than fragmenting a block.
+#define VULKAN_MEMORY_DEDICATED_DIVISOR 2
+
+static u64 align_up(u64 value, u64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void range_insert(vulkan_memory_block* block, u64 index, vulkan_memory_range range) {
+    // Grow by one, then shift everything from index onward up a slot.
+    darray_push(block->free_ranges, range);
+    u64 length = darray_length(block->free_ranges);
+    for (u64 i = length - 1; i > index; --i) {
+        block->free_ranges[i] = block->free_ranges[i - 1];
+    }
+    block->free_ranges[index] = range;
+}
+
+static void range_remove(vulkan_memory_block* block, u64 index) {
+    u64 length = darray_length(block->free_ranges);
+    for (u64 i = index; i < length - 1; ++i) {
+        block->free_ranges[i] = block->free_ranges[i + 1];
+    }
+    darray_length_set(block->free_ranges, length - 1);
+}
+
+// First fit over the free ranges. Alignment padding in front of the allocation is left in the free list.
+static b8 block_allocate(vulkan_memory_block* block, u64 size, u64 alignment, u64* out_offset) {
+    u64 count = darray_length(block->free_ranges);
+    for (u64 i = 0; i < count; ++i) {
+        vulkan_memory_range range = block->free_ranges[i];
+        u64 offset = align_up(range.offset, alignment);
+        u64 range_end = range.offset + range.size;
+        if (offset + size > range_end) {
+            continue;
+        }
+
+        vulkan_memory_range before = {range.offset, offset - range.offset};
+        vulkan_memory_range after = {offset + size, range_end - (offset + size)};
+        if (before.size && after.size) {
+            block->free_ranges[i] = before;
+            range_insert(block, i + 1, after);
+        } else if (before.size) {
+            block->free_ranges[i] = before;
+        } else if (after.size) {
+            block->free_ranges[i] = after;
+        } else {
+            range_remove(block, i);
+        }
+
+        block->used += size;
+        block->allocation_count++;
+        *out_offset = offset;
+        return true;
+    }
+    return false;
+}
+
+static void block_free(vulkan_memory_block* block, u64 offset, u64 size) {
+    u64 count = darray_length(block->free_ranges);
+    u64 index = 0;
+    while (index < count && block->free_ranges[index].offset < offset) {
+        index++;
+    }
+
+    b8 merge_prev = index > 0 && block->free_ranges[index - 1].offset + block->free_ranges[index - 1].size == offset;
+    b8 merge_next = index < count && offset + size == block->free_ranges[index].offset;
+    if (merge_prev && merge_next) {
+        block->free_ranges[index - 1].size += size + block->free_ranges[index].size;
+        range_remove(block, index);
+    } else if (merge_prev) {
+        block->free_ranges[index - 1].size += size;
+    } else if (merge_next) {
+        block->free_ranges[index].offset = offset;
+        block->free_ranges[index].size += size;
+    } else {
+        vulkan_memory_range range = {offset, size};
+        range_insert(block, index, range);
+    }
+
+    block->used -= size;
+    block->allocation_count--;
+}
+
+static void block_release(vulkan_context* context, vulkan_memory_allocator* allocator, vulkan_memory_block* block) {
+    if (block->mapped) {
+        vkUnmapMemory(context->device.logical_device, block->memory);
+        block->mapped = 0;
+        block->map_count = 0;
+    }
+    vkFreeMemory(context->device.logical_device, block->memory, context->allocator);
+    block->memory = 0;
+    darray_destroy(block->free_ranges);
+    block->free_ranges = 0;
+
+    allocator->block_bytes -= block->size;
+    allocator->block_count--;
+}
+
+static b8 allocate_dedicated(
+    vulkan_context* context,
+    VkMemoryRequirements* requirements,
+    u32 memory_type_index,
+    VkBuffer buffer,
+    VkImage image,
+    vulkan_memory_allocation* out_allocation) {
+    VkMemoryDedicatedAllocateInfo dedicated_info = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO};
+    dedicated_info.buffer = buffer;
+    dedicated_info.image = image;
+
+    VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocate_info.pNext = &dedicated_info;
+    allocate_info.allocationSize = requirements->size;
+    allocate_info.memoryTypeIndex = memory_type_index;
+
+    VkResult result = vkAllocateMemory(context->device.logical_device, &allocate_info, context->allocator, &out_allocation->memory);
+    if (result != VK_SUCCESS) {
+        KERROR("Dedicated device memory allocation of %llu bytes failed. Error: %s", requirements->size, vulkan_result_string(result, true));
+        return false;
+    }
+
+    out_allocation->offset = 0;
+    out_allocation->size = requirements->size;
+    out_allocation->memory_type_index = memory_type_index;
+    out_allocation->pool = 0;
+    out_allocation->block_index = -1;
+
+    context->memory_allocator.dedicated_bytes += requirements->size;
+    context->memory_allocator.dedicated_count++;
+    return true;
+}
+
+static b8 allocate(
+    vulkan_context* context,
+    VkMemoryRequirements* requirements,
+    b8 dedicated,
+    vulkan_memory_pool_type pool_type,
+    u32 memory_property_flags,
+    VkBuffer buffer,
+    VkImage image,
+    vulkan_memory_allocation* out_allocation) {
+    kzero_memory(out_allocation, sizeof(vulkan_memory_allocation));
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+
+    i32 memory_type_index = context->find_memory_index(requirements->memoryTypeBits, memory_property_flags);
+    if (memory_type_index == -1) {
+        KERROR("Unable to allocate device memory because the required memory type index was not found");
+        return false;
+    }
+
+    // Host visible, non-coherent ranges are flushed/invalidated in whole atoms. Keeping allocations atom
+    // aligned and sized stops that from touching a neighbouring allocation in the same block.
+    VkMemoryRequirements adjusted = *requirements;
+    requirements = &adjusted;
+    VkMemoryPropertyFlags type_flags = context->device.memory.memoryTypes[memory_type_index].propertyFlags;
+    if ((type_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        u64 atom = context->device.properties.limits.nonCoherentAtomSize;
+        if (adjusted.alignment < atom) {
+            adjusted.alignment = atom;
+        }
+        adjusted.size = align_up(adjusted.size, atom);
+    }
+
+    u64 block_size = allocator->block_sizes[memory_type_index];
+    if (dedicated || requirements->size >= block_size / VULKAN_MEMORY_DEDICATED_DIVISOR) {
+        return allocate_dedicated(context, requirements, memory_type_index, buffer, image, out_allocation);
+    }
+
+    vulkan_memory_pool* pool = &allocator->pools[memory_type_index][pool_type];
+    u64 block_count = darray_length(pool->blocks);
+    i32 free_slot = -1;
+    u64 offset = 0;
+    i32 block_index = -1;
+    for (u64 i = 0; i < block_count; ++i) {
+        vulkan_memory_block* block = &pool->blocks[i];
+        if (!block->memory) {
+            if (free_slot == -1) {
+                free_slot = (i32)i;
+            }
+            continue;
+        }
+        if (block->size - block->used >= requirements->size && block_allocate(block, requirements->size, requirements->alignment, &offset)) {
+            block_index = (i32)i;
+            break;
+        }
+    }
+
+    if (block_index == -1) {
+        vulkan_memory_block new_block = {};
+        VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        allocate_info.allocationSize = block_size;
+        allocate_info.memoryTypeIndex = (u32)memory_type_index;
+        VkResult result = vkAllocateMemory(context->device.logical_device, &allocate_info, context->allocator, &new_block.memory);
+        if (result != VK_SUCCESS) {
+            // The heap may still fit the resource on its own even if a whole block doesn't.
+            KWARN("Unable to allocate a %llu byte device memory block (%s). Trying a dedicated allocation.", block_size, vulkan_result_string(result, true));
+            return allocate_dedicated(context, requirements, memory_type_index, buffer, image, out_allocation);
+        }
+        new_block.size = block_size;
+        new_block.free_ranges = darray_create(vulkan_memory_range);
+        vulkan_memory_range whole = {0, block_size};
+        darray_push(new_block.free_ranges, whole);
+
+        if (free_slot != -1) {
+            pool->blocks[free_slot] = new_block;
+            block_index = free_slot;
+        } else {
+            darray_push(pool->blocks, new_block);
+            block_index = (i32)block_count;
+        }
+        allocator->block_bytes += block_size;
+        allocator->block_count++;
+
+        block_allocate(&pool->blocks[block_index], requirements->size, requirements->alignment, &offset);
+    }
+
+    out_allocation->memory = pool->blocks[block_index].memory;
+    out_allocation->offset = offset;
+    out_allocation->size = requirements->size;
+    out_allocation->memory_type_index = (u32)memory_type_index;
+    out_allocation->pool = (u8)pool_type;
+    out_allocation->block_index = block_index;
+
+    allocator->suballocated_bytes += requirements->size;
+    allocator->suballocation_count++;
+    return true;
+}
+
+b8 vulkan_memory_allocator_create(vulkan_context* context, vulkan_memory_allocator* out_allocator) {
+    kzero_memory(out_allocator, sizeof(vulkan_memory_allocator));
+
+    VkPhysicalDeviceMemoryProperties* properties = &context->device.memory;
+    for (u32 i = 0; i < properties->memoryTypeCount; ++i) {
+        // Small heaps (e.g. the 256mb host visible device local heap) shouldn't be eaten by a couple of blocks.
+        u64 heap_size = properties->memoryHeaps[properties->memoryTypes[i].heapIndex].size;
+        u64 block_size = heap_size / 8;
+        out_allocator->block_sizes[i] = block_size < VULKAN_MEMORY_MAX_BLOCK_SIZE ? block_size : VULKAN_MEMORY_MAX_BLOCK_SIZE;
+
+        for (u32 p = 0; p < VULKAN_MEMORY_POOL_TYPE_COUNT; ++p) {
+            out_allocator->pools[i][p].blocks = darray_create(vulkan_memory_block);
+        }
+    }
+
+    return true;
+}
+
+void vulkan_memory_allocator_destroy(vulkan_context* context, vulkan_memory_allocator* allocator) {
+    for (u32 i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+        for (u32 p = 0; p < VULKAN_MEMORY_POOL_TYPE_COUNT; ++p) {
+            vulkan_memory_pool* pool = &allocator->pools[i][p];
+            if (!pool->blocks) {
+                continue;
+            }
+            u64 block_count = darray_length(pool->blocks);
+            for (u64 b = 0; b < block_count; ++b) {
+                vulkan_memory_block* block = &pool->blocks[b];
+                if (!block->memory) {
+                    continue;
+                }
+                if (block->allocation_count) {
+                    KWARN("Device memory block still has %u live allocations (%llu bytes) at shutdown.", block->allocation_count, block->used);
+                }
+                block_release(context, allocator, block);
+            }
+            darray_destroy(pool->blocks);
+            pool->blocks = 0;
+        }
+    }
+
+    if (allocator->dedicated_count) {
+        KWARN("%llu dedicated device memory allocations were not freed.", allocator->dedicated_count);
+    }
+}
+
+b8 vulkan_memory_allocate_for_buffer(
+    vulkan_context* context,
+    VkBuffer buffer,
+    u32 memory_property_flags,
+    vulkan_memory_allocation* out_allocation) {
+    VkMemoryDedicatedRequirements dedicated_requirements = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS};
+    VkMemoryRequirements2 requirements = {VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+    requirements.pNext = &dedicated_requirements;
+    VkBufferMemoryRequirementsInfo2 info = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2};
+    info.buffer = buffer;
+    vkGetBufferMemoryRequirements2(context->device.logical_device, &info, &requirements);
+
+    b8 dedicated = dedicated_requirements.prefersDedicatedAllocation || dedicated_requirements.requiresDedicatedAllocation;
+    return allocate(context, &requirements.memoryRequirements, dedicated, VULKAN_MEMORY_POOL_LINEAR, memory_property_flags, buffer, 0, out_allocation);
+}
+
+b8 vulkan_memory_allocate_for_image(
+    vulkan_context* context,
+    VkImage image,
+    VkImageTiling tiling,
+    u32 memory_property_flags,
+    vulkan_memory_allocation* out_allocation) {
+    VkMemoryDedicatedRequirements dedicated_requirements = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS};
+    VkMemoryRequirements2 requirements = {VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+    requirements.pNext = &dedicated_requirements;
+    VkImageMemoryRequirementsInfo2 info = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2};
+    info.image = image;
+    vkGetImageMemoryRequirements2(context->device.logical_device, &info, &requirements);
+
+    b8 dedicated = dedicated_requirements.prefersDedicatedAllocation || dedicated_requirements.requiresDedicatedAllocation;
+    vulkan_memory_pool_type pool_type = tiling == VK_IMAGE_TILING_LINEAR ? VULKAN_MEMORY_POOL_LINEAR : VULKAN_MEMORY_POOL_OPTIMAL;
+    return allocate(context, &requirements.memoryRequirements, dedicated, pool_type, memory_property_flags, 0, image, out_allocation);
+}
+
+void vulkan_memory_free(vulkan_context* context, vulkan_memory_allocation* allocation) {
+    if (!allocation->memory) {
+        return;
+    }
+    vulkan_memory_allocator* allocator = &context->memory_allocator;
+
+    if (allocation->block_index == -1) {
+        vkFreeMemory(context->device.logical_device, allocation->memory, context->allocator);
+        allocator->dedicated_bytes -= allocation->size;
+        allocator->dedicated_count--;
+    } else {
+        vulkan_memory_pool* pool = &allocator->pools[allocation->memory_type_index][allocation->pool];
+        vulkan_memory_block* block = &pool->blocks[allocation->block_index];
+        block_free(block, allocation->offset, allocation->size);
+        allocator->suballocated_bytes -= allocation->size;
+        allocator->suballocation_count--;
+
+        // Hand empty blocks back to the driver, but keep one around per pool to avoid thrashing.
+        if (block->allocation_count == 0) {
+            u64 block_count = darray_length(pool->blocks);
+            u32 live_blocks = 0;
+            for (u64 i = 0; i < block_count; ++i) {
+                if (pool->blocks[i].memory) {
+                    live_blocks++;
+                }
+            }
+            if (live_blocks > 1) {
+                block_release(context, allocator, block);
+            }
+        }
+    }
+
+    kzero_memory(allocation, sizeof(vulkan_memory_allocation));
+}
+
+void* vulkan_memory_map(vulkan_context* context, vulkan_memory_allocation* allocation) {
+    void* data = 0;
+    if (allocation->block_index == -1) {
+        VK_CHECK(vkMapMemory(context->device.logical_device, allocation->memory, 0, VK_WHOLE_SIZE, 0, &data));
+        return data;
+    }
+
+    vulkan_memory_block* block = &context->memory_allocator.pools[allocation->memory_type_index][allocation->pool].blocks[allocation->block_index];
+    if (block->map_count == 0) {
+        VK_CHECK(vkMapMemory(context->device.logical_device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped));
+    }
+    block->map_count++;
+    return (u8*)block->mapped + allocation->offset;
+}
+
+void vulkan_memory_unmap(vulkan_context* context, vulkan_memory_allocation* allocation) {
+    if (allocation->block_index == -1) {
+        vkUnmapMemory(context->device.logical_device, allocation->memory);
+        return;
+    }
+
+    vulkan_memory_block* block = &context->memory_allocator.pools[allocation->memory_type_index][allocation->pool].blocks[allocation->block_index];
+    if (block->map_count == 0) {
+        KWARN("vulkan_memory_unmap called on an allocation which isn't mapped.");
+        return;
+    }
+    block->map_count--;
+    if (block->map_count == 0) {
+        vkUnmapMemory(context->device.logical_device, block->memory);
+        block->mapped = 0;
+    }
+}
+
+u32 vulkan_memory_report_usage(void* user_data, memory_usage_entry* out_entries, u32 max_entries) {
+    vulkan_memory_allocator* allocator = user_data;
+    memory_usage_entry entries[3] = {
+        {"Blocks", allocator->block_bytes, allocator->block_count},
+        {"Sub-allocated", allocator->suballocated_bytes, allocator->suballocation_count},
+        {"Dedicated", allocator->dedicated_bytes, allocator->dedicated_count}};
+
+    u32 count = max_entries < 3 ? max_entries : 3;
+    for (u32 i = 0; i < count; ++i) {
+        out_entries[i] = entries[i];
+    }
+    return count;
+}
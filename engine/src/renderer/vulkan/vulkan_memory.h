@@ -0,0 +1,34 @@
+#pragma once
+
+#include "core/kmemory.h"
+#include "vulkan_types.inl"
+
+// Sub-allocates device memory out of large per-memory-type blocks instead of calling
+// vkAllocateMemory for every resource. Must be created after the logical device.
+b8 vulkan_memory_allocator_create(vulkan_context* context, vulkan_memory_allocator* out_allocator);
+
+void vulkan_memory_allocator_destroy(vulkan_context* context, vulkan_memory_allocator* allocator);
+
+b8 vulkan_memory_allocate_for_buffer(
+    vulkan_context* context,
+    VkBuffer buffer,
+    u32 memory_property_flags,
+    vulkan_memory_allocation* out_allocation);
+
+b8 vulkan_memory_allocate_for_image(
+    vulkan_context* context,
+    VkImage image,
+    VkImageTiling tiling,
+    u32 memory_property_flags,
+    vulkan_memory_allocation* out_allocation);
+
+void vulkan_memory_free(vulkan_context* context, vulkan_memory_allocation* allocation);
+
+// Returns a host pointer to the start of the allocation. Blocks are mapped once and shared
+// between their allocations, so every map must be paired with an unmap.
+void* vulkan_memory_map(vulkan_context* context, vulkan_memory_allocation* allocation);
+
+void vulkan_memory_unmap(vulkan_context* context, vulkan_memory_allocation* allocation);
+
+// A memory usage reporter (see memory_register_usage_reporter) for a vulkan_memory_allocator.
+u32 vulkan_memory_report_usage(void* user_data, memory_usage_entry* out_entries, u32 max_entries);
@@ -3,7 +3,7 @@
 #include "core/kmemory.h"
 #include "core/logger.h"
 
-#include "math/math_types.h"
+#include "platform/platform.h"
 #include "vulkan_utils.h"
 
 #define DYNAMIC_STATE_COUNT 3
@@ -11,6 +11,8 @@
 b8 vulkan_graphics_pipeline_create(
     vulkan_context* context,
     vulkan_renderpass* renderpass,
+    u32 binding_count,
+    VkVertexInputBindingDescription* bindings,
     u32 attribute_count,
     VkVertexInputAttributeDescription* attributes,
     u32 descriptor_set_layout_count,
@@ -82,14 +84,9 @@ b8 vulkan_graphics_pipeline_create(
     dynamic_state_create_info.dynamicStateCount = DYNAMIC_STATE_COUNT;
     dynamic_state_create_info.pDynamicStates = dynamic_states;
 
-    VkVertexInputBindingDescription binding_description;
-    binding_description.binding = 0;
-    binding_description.stride = sizeof(vertex_3d);
-    binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
     VkPipelineVertexInputStateCreateInfo vertex_input_info = {VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-    vertex_input_info.vertexBindingDescriptionCount = 1;
-    vertex_input_info.pVertexBindingDescriptions = &binding_description;
+    vertex_input_info.vertexBindingDescriptionCount = binding_count;
+    vertex_input_info.pVertexBindingDescriptions = bindings;
     vertex_input_info.vertexAttributeDescriptionCount = attribute_count;
     vertex_input_info.pVertexAttributeDescriptions = attributes;
 
@@ -138,16 +135,18 @@ b8 vulkan_graphics_pipeline_create(
     pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
     pipeline_create_info.basePipelineIndex = -1;
 
+    f64 start_time = platform_get_absolute_time();
     VkResult result = vkCreateGraphicsPipelines(
         context->device.logical_device,
-        VK_NULL_HANDLE,
+        context->device.pipeline_cache,
         1,
         &pipeline_create_info,
         context->allocator,
         &out_pipeline->handle);
+    f64 elapsed_ms = (platform_get_absolute_time() - start_time) * 1000.0;
 
     if (vulkan_result_is_success(result)) {
-        KDEBUG("Graphics pipeline created!");
+        KINFO("Graphics pipeline created in %.3f ms (pipeline cache %s).", elapsed_ms, context->device.pipeline_cache_seeded ? "warm" : "cold");
         return true;
     }
 
@@ -0,0 +1,131 @@
+#include "vulkan_pipeline_cache.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#include "platform/filesystem.h"
+#include "vulkan_utils.h"
+
+// Layout of VkPipelineCacheHeaderVersionOne, read field by field since the blob has no alignment guarantees.
+#define HEADER_SIZE_OFFSET 0
+#define HEADER_VERSION_OFFSET 4
+#define HEADER_VENDOR_ID_OFFSET 8
+#define HEADER_DEVICE_ID_OFFSET 12
+#define HEADER_UUID_OFFSET 16
+#define HEADER_MIN_SIZE (HEADER_UUID_OFFSET + VK_UUID_SIZE)
+
+static u32 read_u32(const u8* data, u64 offset) {
+    u32 value;
+    kcopy_memory(&value, data + offset, sizeof(u32));
+    return value;
+}
+
+// The driver rejects foreign data itself, but not always gracefully, so anything that
+// wasn't produced by this exact device is dropped before it gets there.
+static b8 header_is_valid(vulkan_context* context, const u8* data, u64 size) {
+    if (size < HEADER_MIN_SIZE) {
+        KWARN("Pipeline cache file is too small (%llu bytes) to hold a header.", size);
+        return false;
+    }
+
+    const VkPhysicalDeviceProperties* properties = &context->device.properties;
+    u32 header_size = read_u32(data, HEADER_SIZE_OFFSET);
+    u32 header_version = read_u32(data, HEADER_VERSION_OFFSET);
+    if (header_size < HEADER_MIN_SIZE || header_size > size || header_version != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+        KWARN("Pipeline cache file has an unrecognised header (size %u, version %u).", header_size, header_version);
+        return false;
+    }
+    if (read_u32(data, HEADER_VENDOR_ID_OFFSET) != properties->vendorID || read_u32(data, HEADER_DEVICE_ID_OFFSET) != properties->deviceID) {
+        KINFO("Pipeline cache file belongs to a different device.");
+        return false;
+    }
+    for (u32 i = 0; i < VK_UUID_SIZE; ++i) {
+        if (data[HEADER_UUID_OFFSET + i] != properties->pipelineCacheUUID[i]) {
+            KINFO("Pipeline cache file was written by a different driver version.");
+            return false;
+        }
+    }
+    return true;
+}
+
+b8 vulkan_pipeline_cache_create(vulkan_context* context, const char* path) {
+    u8* data = 0;
+    u64 size = 0;
+    if (filesystem_exists(path)) {
+        file_handle handle;
+        if (filesystem_open(path, FILE_MODE_READ, true, &handle)) {
+            if (!filesystem_read_all(&handle, &data, &size) || !header_is_valid(context, data, size)) {
+                // Only still set when the whole file was read, so size is what was allocated.
+                if (data) {
+                    kfree(data, size, MEMORY_TAG_STRING);
+                }
+                data = 0;
+                size = 0;
+            }
+            filesystem_close(&handle);
+        }
+    }
+
+    VkPipelineCacheCreateInfo create_info = {VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    create_info.initialDataSize = size;
+    create_info.pInitialData = data;
+    VkResult result = vkCreatePipelineCache(context->device.logical_device, &create_info, context->allocator, &context->device.pipeline_cache);
+    if (result != VK_SUCCESS && data) {
+        // Retry empty rather than going without a cache.
+        KWARN("Pipeline cache rejected the data in '%s': %s", path, vulkan_result_string(result, true));
+        create_info.initialDataSize = 0;
+        create_info.pInitialData = 0;
+        kfree(data, size, MEMORY_TAG_STRING);
+        data = 0;
+        size = 0;
+        result = vkCreatePipelineCache(context->device.logical_device, &create_info, context->allocator, &context->device.pipeline_cache);
+    }
+    if (data) {
+        kfree(data, size, MEMORY_TAG_STRING);
+    }
+
+    if (result != VK_SUCCESS) {
+        KERROR("vkCreatePipelineCache failed with %s.", vulkan_result_string(result, true));
+        context->device.pipeline_cache = 0;
+        return false;
+    }
+
+    context->device.pipeline_cache_seeded = size > 0;
+    if (size > 0) {
+        KINFO("Pipeline cache seeded with %llu bytes from '%s'.", size, path);
+    } else {
+        KINFO("Pipeline cache created empty.");
+    }
+    return true;
+}
+
+void vulkan_pipeline_cache_destroy(vulkan_context* context, const char* path) {
+    VkDevice device = context->device.logical_device;
+    if (!context->device.pipeline_cache) {
+        return;
+    }
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, context->device.pipeline_cache, &size, 0) == VK_SUCCESS && size > 0) {
+        // The second call can shrink size, so keep what was actually allocated for the free.
+        size_t allocated_size = size;
+        void* data = kallocate_uninit(allocated_size, MEMORY_TAG_RENDERER);
+        if (vkGetPipelineCacheData(device, context->device.pipeline_cache, &size, data) == VK_SUCCESS) {
+            file_handle handle;
+            if (filesystem_open(path, FILE_MODE_WRITE, true, &handle)) {
+                u64 written = 0;
+                if (filesystem_write(&handle, size, data, &written)) {
+                    KINFO("Pipeline cache saved %llu bytes to '%s'.", (u64)size, path);
+                } else {
+                    KWARN("Pipeline cache write to '%s' was incomplete.", path);
+                }
+                filesystem_close(&handle);
+            }
+        }
+        kfree(data, allocated_size, MEMORY_TAG_RENDERER);
+    }
+
+    vkDestroyPipelineCache(device, context->device.pipeline_cache, context->allocator);
+    context->device.pipeline_cache = 0;
+    context->device.pipeline_cache_seeded = false;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "vulkan_types.inl"
+
+// Creates context->device.pipeline_cache, seeded from the file at path when it exists and was
+// written by the same driver and device. A missing or stale file just gives an empty cache.
+b8 vulkan_pipeline_cache_create(vulkan_context* context, const char* path);
+
+// Writes the cache contents back to path, then destroys it.
+void vulkan_pipeline_cache_destroy(vulkan_context* context, const char* path);
@@ -35,7 +35,8 @@ void vulkan_renderpass_create(
     color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // Offscreen frames are left ready to be copied out by vulkan_read_pixels.
+    color_attachment.finalLayout = context->offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
     color_attachment.flags = 0;
 
     attachment_descriptions[0] = color_attachment;
@@ -112,7 +113,8 @@ void vulkan_renderpass_destroy(vulkan_context* context, vulkan_renderpass* rende
 void vulkan_renderpass_begin(
     vulkan_command_buffer* command_buffer,
     vulkan_renderpass* renderpass,
-    VkFramebuffer frame_buffer) {
+    VkFramebuffer frame_buffer,
+    VkSubpassContents contents) {
     VkRenderPassBeginInfo begin_info = {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
     begin_info.renderPass = renderpass->handle;
     begin_info.framebuffer = frame_buffer;
@@ -133,7 +135,7 @@ void vulkan_renderpass_begin(
     begin_info.clearValueCount = 2;
     begin_info.pClearValues = clear_values;
 
-    vkCmdBeginRenderPass(command_buffer->handle, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(command_buffer->handle, &begin_info, contents);
     command_buffer->state = COMMAND_BUFFER_STATE_IN_RENDER_PASS;
 }
 
@@ -15,9 +15,11 @@ void vulkan_renderpass_create(
 
 void vulkan_renderpass_destroy(vulkan_context* context, vulkan_renderpass* renderpass);
 
+// With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, the pass may only be filled through vkCmdExecuteCommands.
 void vulkan_renderpass_begin(
     vulkan_command_buffer* command_buffer,
     vulkan_renderpass* renderpass,
-    VkFramebuffer frame_buffer);
+    VkFramebuffer frame_buffer,
+    VkSubpassContents contents);
 
 void vulkan_renderpass_end(vulkan_command_buffer* command_buffer, vulkan_renderpass* renderpass);
\ No newline at end of file
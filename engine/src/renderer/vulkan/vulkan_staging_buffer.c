@@ -0,0 +1,120 @@
+#include "vulkan_staging_buffer.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#include "vulkan_buffer.h"
+#include "vulkan_fence.h"
+
+static void pop_submission(vulkan_staging_buffer* staging) {
+    staging->tail = staging->submissions[staging->submission_first].end;
+    staging->submission_first = (staging->submission_first + 1) % VULKAN_STAGING_MAX_SUBMISSIONS;
+    staging->submission_count--;
+}
+
+static b8 wait_oldest(vulkan_context* context, vulkan_staging_buffer* staging) {
+    if (!vulkan_fence_wait(context, &staging->submissions[staging->submission_first].fence, UINT64_MAX)) {
+        return false;
+    }
+    pop_submission(staging);
+    return true;
+}
+
+b8 vulkan_staging_buffer_create(vulkan_context* context, u64 size, vulkan_staging_buffer* out_staging) {
+    kzero_memory(out_staging, sizeof(vulkan_staging_buffer));
+    out_staging->size = size;
+
+    u64 copy_alignment = context->device.properties.limits.optimalBufferCopyOffsetAlignment;
+    out_staging->alignment = copy_alignment > 16 ? copy_alignment : 16;
+
+    if (!vulkan_buffer_create(
+            context,
+            size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            true,
+            true,
+            &out_staging->buffer)) {
+        KERROR("Failed to create staging buffer.");
+        return false;
+    }
+    out_staging->mapped = out_staging->buffer.mapped;
+
+    for (u32 i = 0; i < VULKAN_STAGING_MAX_SUBMISSIONS; ++i) {
+        vulkan_fence_create(context, false, &out_staging->submissions[i].fence);
+    }
+
+    return true;
+}
+
+void vulkan_staging_buffer_destroy(vulkan_context* context, vulkan_staging_buffer* staging) {
+    while (staging->submission_count) {
+        if (!wait_oldest(context, staging)) {
+            break;
+        }
+    }
+    for (u32 i = 0; i < VULKAN_STAGING_MAX_SUBMISSIONS; ++i) {
+        vulkan_fence_destroy(context, &staging->submissions[i].fence);
+    }
+
+    vulkan_buffer_destroy(context, &staging->buffer);
+    kzero_memory(staging, sizeof(vulkan_staging_buffer));
+}
+
+void* vulkan_staging_buffer_allocate(vulkan_context* context, vulkan_staging_buffer* staging, u64 size, u64* out_offset) {
+    if (size > staging->size) {
+        KERROR("vulkan_staging_buffer_allocate - %llu bytes requested, but the staging buffer only holds %llu.", size, staging->size);
+        return 0;
+    }
+
+    u64 start = (staging->head + staging->alignment - 1) & ~(staging->alignment - 1);
+    // Allocations never straddle the end of the buffer, skip ahead to the start instead.
+    if ((start % staging->size) + size > staging->size) {
+        start += staging->size - (start % staging->size);
+    }
+
+    vulkan_staging_buffer_reclaim(context, staging);
+    while (start + size - staging->tail > staging->size) {
+        if (staging->submission_count == 0) {
+            KERROR("vulkan_staging_buffer_allocate - staging buffer is full of data which hasn't been submitted.");
+            return 0;
+        }
+        if (!wait_oldest(context, staging)) {
+            return 0;
+        }
+    }
+
+    staging->head = start + size;
+    *out_offset = start % staging->size;
+    return staging->mapped + *out_offset;
+}
+
+VkFence vulkan_staging_buffer_submit(vulkan_context* context, vulkan_staging_buffer* staging) {
+    if (staging->head == staging->batch_start) {
+        return 0;
+    }
+    if (staging->submission_count == VULKAN_STAGING_MAX_SUBMISSIONS) {
+        wait_oldest(context, staging);
+    }
+
+    vulkan_staging_submission* submission = &staging->submissions[(staging->submission_first + staging->submission_count) % VULKAN_STAGING_MAX_SUBMISSIONS];
+    vulkan_fence_reset(context, &submission->fence);
+    submission->end = staging->head;
+    staging->submission_count++;
+    staging->batch_start = staging->head;
+
+    return submission->fence.handle;
+}
+
+void vulkan_staging_buffer_reclaim(vulkan_context* context, vulkan_staging_buffer* staging) {
+    while (staging->submission_count) {
+        vulkan_fence* fence = &staging->submissions[staging->submission_first].fence;
+        if (!fence->is_signaled) {
+            if (vkGetFenceStatus(context->device.logical_device, fence->handle) != VK_SUCCESS) {
+                break;
+            }
+            fence->is_signaled = true;
+        }
+        pop_submission(staging);
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "vulkan_types.inl"
+
+b8 vulkan_staging_buffer_create(vulkan_context* context, u64 size, vulkan_staging_buffer* out_staging);
+
+// Waits for any outstanding uploads before releasing the buffer.
+void vulkan_staging_buffer_destroy(vulkan_context* context, vulkan_staging_buffer* staging);
+
+// Returns a mapped pointer to size bytes of staging space, writing its offset within staging->buffer to out_offset.
+// Blocks on the oldest submission if the ring is full. Returns 0 if the request can never fit.
+void* vulkan_staging_buffer_allocate(vulkan_context* context, vulkan_staging_buffer* staging, u64 size, u64* out_offset);
+
+// Closes off everything allocated since the last call. The returned fence must be
+// signaled by the queue submission which reads that space.
+VkFence vulkan_staging_buffer_submit(vulkan_context* context, vulkan_staging_buffer* staging);
+
+// Releases space from submissions which have completed. Never blocks.
+void vulkan_staging_buffer_reclaim(vulkan_context* context, vulkan_staging_buffer* staging);
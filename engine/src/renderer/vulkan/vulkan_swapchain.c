@@ -3,18 +3,53 @@
 #include "core/kmemory.h"
 #include "core/logger.h"
 
+#include "vulkan_deletion_queue.h"
 #include "vulkan_device.h"
 #include "vulkan_image.h"
 
-void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* swapchain);
+void create(vulkan_context* context, u32 width, u32 height, VkSwapchainKHR old_swapchain, vulkan_swapchain* swapchain);
 void destroy(vulkan_context* context, vulkan_swapchain* swapchain);
+void destroy_views(vulkan_context* context, vulkan_swapchain* swapchain);
+static void create_offscreen_images(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* swapchain);
+static void create_depth_attachment(vulkan_context* context, VkExtent2D swapchain_extent, vulkan_swapchain* swapchain);
+
+static VkPresentModeKHR select_present_mode(vulkan_context* context) {
+    VkPresentModeKHR requested;
+    switch (context->config.present_mode) {
+        case RENDERER_PRESENT_MODE_FIFO_RELAXED:
+            requested = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+            break;
+        case RENDERER_PRESENT_MODE_MAILBOX:
+            requested = VK_PRESENT_MODE_MAILBOX_KHR;
+            break;
+        case RENDERER_PRESENT_MODE_IMMEDIATE:
+            requested = VK_PRESENT_MODE_IMMEDIATE_KHR;
+            break;
+        default:
+        case RENDERER_PRESENT_MODE_FIFO:
+            requested = VK_PRESENT_MODE_FIFO_KHR;
+            break;
+    }
+
+    for (u32 i = 0; i < context->device.swapchain_support.present_mode_count; i++) {
+        if (context->device.swapchain_support.present_modes[i] == requested) {
+            return requested;
+        }
+    }
+
+    // FIFO support is required by the spec.
+    KWARN("Requested present mode %u is not supported by the surface, falling back to FIFO", context->config.present_mode);
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
 
 void vulkan_swapchain_create(
     vulkan_context* context,
     u32 width,
     u32 height,
     vulkan_swapchain* out_swapchain) {
-    create(context, width, height, out_swapchain);
+    // Only changed from here on by the backend, which owns the per-frame sync objects.
+    out_swapchain->max_frames_in_flight = context->config.frames_in_flight;
+    create(context, width, height, 0, out_swapchain);
 }
 
 void vulkan_swapchain_recreate(
@@ -22,8 +57,15 @@ void vulkan_swapchain_recreate(
     u32 width,
     u32 height,
     vulkan_swapchain* swapchain) {
-    destroy(context, swapchain);
-    create(context, width, height, swapchain);
+    // The caller has waited on every frame which rendered to the old images, so their views can go now.
+    // Presents may still be queued against the old swapchain though, so it is handed to the new one
+    // to retire and only destroyed once the frame being recorded now has finished on the gpu.
+    destroy_views(context, swapchain);
+    VkSwapchainKHR old_swapchain = swapchain->handle;
+    create(context, width, height, old_swapchain, swapchain);
+    if (old_swapchain) {
+        vulkan_deletion_queue_push_swapchain(context, old_swapchain);
+    }
 }
 
 void vulkan_swapchain_destroy(
@@ -39,6 +81,13 @@ b8 vulkan_swapchain_acquire_next_image_index(
     VkSemaphore image_available_semaphore,
     VkFence fence,
     u32* out_image_index) {
+    // Offscreen images are only used by their own frame slot, whose fence has already been waited on.
+    // Nothing is signaled, so the submit mustn't wait on image_available_semaphore.
+    if (context->offscreen) {
+        *out_image_index = context->current_frame;
+        return true;
+    }
+
     VkResult result = vkAcquireNextImageKHR(
         context->device.logical_device,
         swapchain->handle,
@@ -48,7 +97,8 @@ b8 vulkan_swapchain_acquire_next_image_index(
         out_image_index);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        vulkan_swapchain_recreate(context, context->framebuffer_width, context->framebuffer_height, swapchain);
+        // Nothing was signaled. The backend recreates the swapchain and tries again.
+        swapchain->out_of_date = true;
         return false;
     } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         KFATAL("Failed to acquire swapchain image!");
@@ -65,6 +115,11 @@ void vulkan_swapchain_present(
     VkQueue present_queue,
     VkSemaphore render_complete_semaphore,
     u32 present_image_index) {
+    if (context->offscreen) {
+        context->current_frame = (context->current_frame + 1) % swapchain->max_frames_in_flight;
+        return;
+    }
+
     VkPresentInfoKHR present_info = {VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
     present_info.waitSemaphoreCount = 1;
     present_info.pWaitSemaphores = &render_complete_semaphore;
@@ -75,16 +130,23 @@ void vulkan_swapchain_present(
 
     VkResult result = vkQueuePresentKHR(present_queue, &present_info);
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-        vulkan_swapchain_recreate(context, context->framebuffer_width, context->framebuffer_height, swapchain);
+        // Recreated by the backend at the start of the next frame.
+        swapchain->out_of_date = true;
     } else if (result != VK_SUCCESS) {
         KFATAL("Failed to acquire swapchain image!");
     }
     context->current_frame = (context->current_frame + 1) % swapchain->max_frames_in_flight;
 }
 
-void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* swapchain) {
+void create(vulkan_context* context, u32 width, u32 height, VkSwapchainKHR old_swapchain, vulkan_swapchain* swapchain) {
     VkExtent2D swapchain_extent = {width, height};
 
+    if (context->offscreen) {
+        create_offscreen_images(context, width, height, swapchain);
+        create_depth_attachment(context, swapchain_extent, swapchain);
+        return;
+    }
+
     b8 found = false;
     for (u32 i = 0; i < context->device.swapchain_support.format_count; i++) {
         VkSurfaceFormatKHR format = context->device.swapchain_support.formats[i];
@@ -100,20 +162,13 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
         swapchain->image_format = context->device.swapchain_support.formats[0];
     }
 
-    VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
-    for (u32 i = 0; i < context->device.swapchain_support.present_mode_count; i++) {
-        VkPresentModeKHR mode = context->device.swapchain_support.present_modes[i];
-        if (mode == VK_PRESENT_MODE_MAILBOX_KHR) {
-            present_mode = mode;
-            break;
-        }
-    }
-
     vulkan_device_query_swapchain_support(
         context->device.physical_device,
         context->surface,
         &context->device.swapchain_support);
 
+    VkPresentModeKHR present_mode = select_present_mode(context);
+
     if (context->device.swapchain_support.capabilities.currentExtent.width != UINT32_MAX) {
         swapchain_extent = context->device.swapchain_support.capabilities.currentExtent;
     }
@@ -123,11 +178,15 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
     swapchain_extent.width = KCLAMP(swapchain_extent.width, min.width, max.width);
     swapchain_extent.height = KCLAMP(swapchain_extent.height, min.height, max.height);
 
+    // Frames in flight are bounded by the fences, not the image count, but an image per frame plus
+    // the one being displayed avoids stalling on acquire.
     u32 image_count = context->device.swapchain_support.capabilities.minImageCount + 1;
+    if (image_count < (u32)swapchain->max_frames_in_flight + 1) {
+        image_count = swapchain->max_frames_in_flight + 1;
+    }
     if (context->device.swapchain_support.capabilities.maxImageCount > 0 && image_count > context->device.swapchain_support.capabilities.maxImageCount) {
         image_count = context->device.swapchain_support.capabilities.maxImageCount;
     }
-    swapchain->max_frames_in_flight = image_count - 1;
 
     VkSwapchainCreateInfoKHR swapchain_create_info = {VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
     swapchain_create_info.surface = context->surface;
@@ -154,16 +213,24 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
     swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapchain_create_info.presentMode = present_mode;
     swapchain_create_info.clipped = VK_TRUE;
-    swapchain_create_info.oldSwapchain = NULL;
+    swapchain_create_info.oldSwapchain = old_swapchain;
 
     swapchain_create_info.imageExtent.height = height;
     swapchain_create_info.imageExtent.width = width;
     VK_CHECK(vkCreateSwapchainKHR(context->device.logical_device, &swapchain_create_info, context->allocator, &swapchain->handle));
 
     context->current_frame = 0;
-    swapchain->image_count = 0;
+    swapchain->out_of_date = false;
 
+    // The driver may hand back a different number of images than last time, e.g. after a present mode change.
+    u32 old_image_count = swapchain->image_count;
     VK_CHECK(vkGetSwapchainImagesKHR(context->device.logical_device, swapchain->handle, &swapchain->image_count, NULL));
+    if (swapchain->images && swapchain->image_count != old_image_count) {
+        kfree(swapchain->images, sizeof(VkImage) * old_image_count, MEMORY_TAG_RENDERER);
+        kfree(swapchain->views, sizeof(VkImageView) * old_image_count, MEMORY_TAG_RENDERER);
+        swapchain->images = 0;
+        swapchain->views = 0;
+    }
     if (!swapchain->images) {
         swapchain->images = (VkImage*)kallocate(sizeof(VkImage) * swapchain->image_count, MEMORY_TAG_RENDERER);
     }
@@ -186,11 +253,70 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
         VK_CHECK(vkCreateImageView(context->device.logical_device, &view_info, context->allocator, &swapchain->views[i]));
     }
 
+    create_depth_attachment(context, swapchain_extent, swapchain);
+}
+
+static void create_offscreen_images(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* swapchain) {
+    // Matches what vulkan_read_pixels hands back, so no swizzle is needed.
+    swapchain->image_format.format = VK_FORMAT_R8G8B8A8_UNORM;
+    swapchain->image_format.colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+    swapchain->handle = 0;
+
+    context->current_frame = 0;
+    swapchain->out_of_date = false;
+
+    // Nothing holds on to an image for display, so one per frame in flight is enough.
+    u32 old_image_count = swapchain->image_count;
+    swapchain->image_count = swapchain->max_frames_in_flight;
+    if (swapchain->images && swapchain->image_count != old_image_count) {
+        kfree(swapchain->images, sizeof(VkImage) * old_image_count, MEMORY_TAG_RENDERER);
+        kfree(swapchain->views, sizeof(VkImageView) * old_image_count, MEMORY_TAG_RENDERER);
+        kfree(swapchain->color_attachments, sizeof(vulkan_image) * old_image_count, MEMORY_TAG_RENDERER);
+        swapchain->images = 0;
+        swapchain->views = 0;
+        swapchain->color_attachments = 0;
+    }
+    if (!swapchain->images) {
+        swapchain->images = (VkImage*)kallocate(sizeof(VkImage) * swapchain->image_count, MEMORY_TAG_RENDERER);
+        swapchain->views = (VkImageView*)kallocate(sizeof(VkImageView) * swapchain->image_count, MEMORY_TAG_RENDERER);
+        swapchain->color_attachments = (vulkan_image*)kallocate(sizeof(vulkan_image) * swapchain->image_count, MEMORY_TAG_RENDERER);
+    }
+
+    for (u32 i = 0; i < swapchain->image_count; i++) {
+        vulkan_image_create(
+            context,
+            VK_IMAGE_TYPE_2D,
+            width,
+            height,
+            swapchain->image_format.format,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            true,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            &swapchain->color_attachments[i]);
+        swapchain->images[i] = swapchain->color_attachments[i].handle;
+        swapchain->views[i] = swapchain->color_attachments[i].view;
+    }
+}
+
+static void create_depth_attachment(vulkan_context* context, VkExtent2D swapchain_extent, vulkan_swapchain* swapchain) {
     if (!vulkan_device_detect_depth_format(&context->device)) {
         context->device.depth_format = VK_FORMAT_UNDEFINED;
         KFATAL("Failed to find supported depth format");
     }
 
+    // The depth buffer doesn't belong to the swapchain, so it survives a recreate at the same size.
+    vulkan_image* depth = &swapchain->depth_attachment;
+    if (depth->handle) {
+        if (depth->width == swapchain_extent.width && depth->height == swapchain_extent.height && swapchain->depth_format == context->device.depth_format) {
+            KINFO("Swapchain recreated successfully, depth attachment reused");
+            return;
+        }
+        vulkan_image_destroy(context, depth);
+    }
+    swapchain->depth_format = context->device.depth_format;
+
     vulkan_image_create(
         context,
         VK_IMAGE_TYPE_2D,
@@ -207,13 +333,41 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
     KINFO("Swapchain created successfully");
 }
 
+void destroy_views(vulkan_context* context, vulkan_swapchain* swapchain) {
+    // Offscreen images are owned by the swapchain, so they go along with their views.
+    if (swapchain->color_attachments) {
+        for (u32 i = 0; i < swapchain->image_count; i++) {
+            vulkan_image_destroy(context, &swapchain->color_attachments[i]);
+            swapchain->images[i] = 0;
+            swapchain->views[i] = 0;
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < swapchain->image_count; i++) {
+        vkDestroyImageView(context->device.logical_device, swapchain->views[i], context->allocator);
+        swapchain->views[i] = 0;
+    }
+}
+
 void destroy(vulkan_context* context, vulkan_swapchain* swapchain) {
     vkDeviceWaitIdle(context->device.logical_device);
     vulkan_image_destroy(context, &swapchain->depth_attachment);
 
-    for (u32 i = 0; i < swapchain->image_count; i++) {
-        vkDestroyImageView(context->device.logical_device, swapchain->views[i], context->allocator);
+    destroy_views(context, swapchain);
+
+    if (swapchain->handle) {
+        vkDestroySwapchainKHR(context->device.logical_device, swapchain->handle, context->allocator);
+        swapchain->handle = 0;
     }
 
-    vkDestroySwapchainKHR(context->device.logical_device, swapchain->handle, context->allocator);
+    kfree(swapchain->images, sizeof(VkImage) * swapchain->image_count, MEMORY_TAG_RENDERER);
+    kfree(swapchain->views, sizeof(VkImageView) * swapchain->image_count, MEMORY_TAG_RENDERER);
+    swapchain->images = 0;
+    swapchain->views = 0;
+    if (swapchain->color_attachments) {
+        kfree(swapchain->color_attachments, sizeof(vulkan_image) * swapchain->image_count, MEMORY_TAG_RENDERER);
+        swapchain->color_attachments = 0;
+    }
+    swapchain->image_count = 0;
 }
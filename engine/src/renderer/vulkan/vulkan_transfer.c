@@ -0,0 +1,229 @@
+#include "vulkan_transfer.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#include "vulkan_buffer.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_fence.h"
+#include "vulkan_image.h"
+#include "vulkan_staging_buffer.h"
+
+static b8 begin_batch(vulkan_context* context, vulkan_transfer* transfer) {
+    if (transfer->recording) {
+        return true;
+    }
+
+    // The batch's command buffers may still be in flight from the last time around the ring.
+    vulkan_transfer_batch* batch = &transfer->batches[transfer->current];
+    if (!vulkan_fence_wait(context, &batch->fence, UINT64_MAX)) {
+        KERROR("Failed waiting on a previous transfer batch.");
+        return false;
+    }
+    vulkan_fence_reset(context, &batch->fence);
+
+    vulkan_command_buffer_begin(&batch->transfer_command_buffer, true, false, false);
+    if (transfer->ownership_transfer) {
+        vulkan_command_buffer_begin(&batch->acquire_command_buffer, true, false, false);
+    }
+    transfer->recording = true;
+    return true;
+}
+
+// Gets staging space for an upload, flushing what's been recorded so far if the ring is full of it.
+static void* staging_allocate(vulkan_context* context, vulkan_transfer* transfer, u64 size, u64* out_offset) {
+    void* memory = vulkan_staging_buffer_allocate(context, &context->staging_buffer, size, out_offset);
+    if (!memory && transfer->recording && size <= context->staging_buffer.size) {
+        vulkan_transfer_flush(context, transfer);
+        memory = vulkan_staging_buffer_allocate(context, &context->staging_buffer, size, out_offset);
+    }
+    return memory;
+}
+
+b8 vulkan_transfer_create(vulkan_context* context, vulkan_transfer* out_transfer) {
+    kzero_memory(out_transfer, sizeof(vulkan_transfer));
+    out_transfer->ownership_transfer = context->device.transfer_queue_index != context->device.graphics_queue_index;
+
+    for (u32 i = 0; i < VULKAN_TRANSFER_MAX_BATCHES; ++i) {
+        vulkan_transfer_batch* batch = &out_transfer->batches[i];
+        vulkan_command_buffer_allocate(context, context->device.transfer_command_pool, true, &batch->transfer_command_buffer);
+        vulkan_command_buffer_allocate(context, context->device.graphics_command_pool, true, &batch->acquire_command_buffer);
+
+        VkSemaphoreCreateInfo semaphore_create_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        VK_CHECK(vkCreateSemaphore(context->device.logical_device, &semaphore_create_info, context->allocator, &batch->semaphore));
+
+        // Signaled so the first use of each batch doesn't wait.
+        vulkan_fence_create(context, true, &batch->fence);
+    }
+
+    return true;
+}
+
+void vulkan_transfer_destroy(vulkan_context* context, vulkan_transfer* transfer) {
+    if (transfer->recording) {
+        vulkan_transfer_flush(context, transfer);
+    }
+
+    for (u32 i = 0; i < VULKAN_TRANSFER_MAX_BATCHES; ++i) {
+        vulkan_transfer_batch* batch = &transfer->batches[i];
+        vulkan_fence_wait(context, &batch->fence, UINT64_MAX);
+        vulkan_fence_destroy(context, &batch->fence);
+
+        if (batch->semaphore) {
+            vkDestroySemaphore(context->device.logical_device, batch->semaphore, context->allocator);
+            batch->semaphore = 0;
+        }
+        vulkan_command_buffer_free(context, context->device.transfer_command_pool, &batch->transfer_command_buffer);
+        vulkan_command_buffer_free(context, context->device.graphics_command_pool, &batch->acquire_command_buffer);
+    }
+}
+
+b8 vulkan_transfer_upload_buffer(
+    vulkan_context* context,
+    vulkan_transfer* transfer,
+    vulkan_buffer* dest,
+    u64 offset,
+    u64 size,
+    const void* data,
+    VkPipelineStageFlags dest_stage,
+    VkAccessFlags dest_access) {
+    u64 staging_offset;
+    void* staging_memory = staging_allocate(context, transfer, size, &staging_offset);
+    if (!staging_memory) {
+        KERROR("vulkan_transfer_upload_buffer - unable to get %llu bytes of staging space.", size);
+        return false;
+    }
+    kcopy_memory(staging_memory, data, size);
+    vulkan_buffer_flush(context, &context->staging_buffer.buffer, staging_offset, size);
+
+    if (!begin_batch(context, transfer)) {
+        return false;
+    }
+    vulkan_transfer_batch* batch = &transfer->batches[transfer->current];
+
+    VkBufferCopy copy_region;
+    copy_region.srcOffset = staging_offset;
+    copy_region.dstOffset = offset;
+    copy_region.size = size;
+    vkCmdCopyBuffer(batch->transfer_command_buffer.handle, context->staging_buffer.buffer.handle, dest->handle, 1, &copy_region);
+
+    VkBufferMemoryBarrier barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = dest_access;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = dest->handle;
+    barrier.offset = offset;
+    barrier.size = size;
+
+    if (!transfer->ownership_transfer) {
+        vkCmdPipelineBarrier(batch->transfer_command_buffer.handle, VK_PIPELINE_STAGE_TRANSFER_BIT, dest_stage, 0, 0, 0, 1, &barrier, 0, 0);
+        return true;
+    }
+
+    // Release on the transfer queue, then acquire the same range on the graphics queue.
+    barrier.srcQueueFamilyIndex = context->device.transfer_queue_index;
+    barrier.dstQueueFamilyIndex = context->device.graphics_queue_index;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(batch->transfer_command_buffer.handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, 0, 1, &barrier, 0, 0);
+
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = dest_access;
+    vkCmdPipelineBarrier(batch->acquire_command_buffer.handle, VULKAN_TRANSFER_CONSUMER_STAGES, dest_stage, 0, 0, 0, 1, &barrier, 0, 0);
+    return true;
+}
+
+b8 vulkan_transfer_upload_image(
+    vulkan_context* context,
+    vulkan_transfer* transfer,
+    vulkan_image* image,
+    u64 size,
+    const void* pixels) {
+    u64 staging_offset;
+    void* staging_memory = staging_allocate(context, transfer, size, &staging_offset);
+    if (!staging_memory) {
+        KERROR("vulkan_transfer_upload_image - unable to get %llu bytes of staging space.", size);
+        return false;
+    }
+    kcopy_memory(staging_memory, pixels, size);
+    vulkan_buffer_flush(context, &context->staging_buffer.buffer, staging_offset, size);
+
+    if (!begin_batch(context, transfer)) {
+        return false;
+    }
+    vulkan_transfer_batch* batch = &transfer->batches[transfer->current];
+    VkCommandBuffer command_buffer = batch->transfer_command_buffer.handle;
+
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image->handle;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+
+    vulkan_image_copy_from_buffer(context, image, context->staging_buffer.buffer.handle, staging_offset, &batch->transfer_command_buffer);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    if (!transfer->ownership_transfer) {
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+        return true;
+    }
+
+    // The layout transition happens once, as part of the release/acquire pair.
+    barrier.srcQueueFamilyIndex = context->device.transfer_queue_index;
+    barrier.dstQueueFamilyIndex = context->device.graphics_queue_index;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(batch->acquire_command_buffer.handle, VULKAN_TRANSFER_CONSUMER_STAGES, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+    return true;
+}
+
+void vulkan_transfer_flush(vulkan_context* context, vulkan_transfer* transfer) {
+    if (!transfer->recording) {
+        return;
+    }
+    vulkan_transfer_batch* batch = &transfer->batches[transfer->current];
+
+    vulkan_command_buffer_end(&batch->transfer_command_buffer);
+    VkSubmitInfo transfer_submit = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    transfer_submit.commandBufferCount = 1;
+    transfer_submit.pCommandBuffers = &batch->transfer_command_buffer.handle;
+    transfer_submit.signalSemaphoreCount = 1;
+    transfer_submit.pSignalSemaphores = &batch->semaphore;
+    // The staging space read by the copies is released once this fence signals.
+    VkFence staging_fence = vulkan_staging_buffer_submit(context, &context->staging_buffer);
+    VK_CHECK(vkQueueSubmit(context->device.transfer_queue, 1, &transfer_submit, staging_fence));
+    vulkan_command_buffer_update_submitted(&batch->transfer_command_buffer);
+
+    // Everything submitted to the graphics queue after this is ordered behind the uploads. With a shared
+    // queue family there is nothing to acquire, so this only waits on the semaphore and signals the fence.
+    VkPipelineStageFlags wait_stages = VULKAN_TRANSFER_CONSUMER_STAGES;
+    VkSubmitInfo acquire_submit = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    acquire_submit.waitSemaphoreCount = 1;
+    acquire_submit.pWaitSemaphores = &batch->semaphore;
+    acquire_submit.pWaitDstStageMask = &wait_stages;
+    if (transfer->ownership_transfer) {
+        vulkan_command_buffer_end(&batch->acquire_command_buffer);
+        acquire_submit.commandBufferCount = 1;
+        acquire_submit.pCommandBuffers = &batch->acquire_command_buffer.handle;
+    }
+    VK_CHECK(vkQueueSubmit(context->device.graphics_queue, 1, &acquire_submit, batch->fence.handle));
+
+    transfer->current = (transfer->current + 1) % VULKAN_TRANSFER_MAX_BATCHES;
+    transfer->recording = false;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "vulkan_types.inl"
+
+// Records uploads on the transfer queue without blocking the caller. Uploads are batched until
+// vulkan_transfer_flush, and the graphics queue waits on the batch before anything it submits later.
+b8 vulkan_transfer_create(vulkan_context* context, vulkan_transfer* out_transfer);
+
+void vulkan_transfer_destroy(vulkan_context* context, vulkan_transfer* transfer);
+
+// Copies size bytes of data into dest at offset. dest_stage/dest_access describe how the graphics queue reads it.
+b8 vulkan_transfer_upload_buffer(
+    vulkan_context* context,
+    vulkan_transfer* transfer,
+    vulkan_buffer* dest,
+    u64 offset,
+    u64 size,
+    const void* data,
+    VkPipelineStageFlags dest_stage,
+    VkAccessFlags dest_access);
+
+// Copies pixels into the first mip level of image, leaving it in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+b8 vulkan_transfer_upload_image(
+    vulkan_context* context,
+    vulkan_transfer* transfer,
+    vulkan_image* image,
+    u64 size,
+    const void* pixels);
+
+// Submits everything recorded since the last flush. Does nothing if there is nothing to submit.
+void vulkan_transfer_flush(vulkan_context* context, vulkan_transfer* transfer);
@@ -3,6 +3,7 @@
 #include "core/asserts.h"
 
 #include "defines.h"
+#include "memory/pool_allocator.h"
 #include "renderer/renderer_types.inl"
 #include <vulkan/vulkan.h>
 
@@ -11,14 +12,70 @@
         KASSERT(expr == VK_SUCCESS); \
     }
 
+// A range of device memory handed out by the vulkan_memory_allocator.
+typedef struct vulkan_memory_allocation {
+    VkDeviceMemory memory;
+    u64 offset;
+    u64 size;
+    u32 memory_type_index;
+    // The pool and block this range was carved from. block_index is -1 for dedicated allocations.
+    u8 pool;
+    i32 block_index;
+} vulkan_memory_allocation;
+
+typedef struct vulkan_memory_range {
+    u64 offset;
+    u64 size;
+} vulkan_memory_range;
+
+typedef struct vulkan_memory_block {
+    VkDeviceMemory memory;
+    u64 size;
+    u64 used;
+    u32 allocation_count;
+    // darray of free ranges, sorted by offset.
+    vulkan_memory_range* free_ranges;
+    void* mapped;
+    u32 map_count;
+} vulkan_memory_block;
+
+// Linear resources (buffers, linear images) and optimal-tiled images never share a block,
+// which keeps bufferImageGranularity from having to be considered between neighbours.
+typedef enum vulkan_memory_pool_type {
+    VULKAN_MEMORY_POOL_LINEAR = 0,
+    VULKAN_MEMORY_POOL_OPTIMAL = 1,
+    VULKAN_MEMORY_POOL_TYPE_COUNT
+} vulkan_memory_pool_type;
+
+typedef struct vulkan_memory_pool {
+    // darray of blocks. Released blocks keep their slot with a null memory handle so indices stay stable.
+    vulkan_memory_block* blocks;
+} vulkan_memory_pool;
+
+typedef struct vulkan_memory_allocator {
+    vulkan_memory_pool pools[VK_MAX_MEMORY_TYPES][VULKAN_MEMORY_POOL_TYPE_COUNT];
+    u64 block_sizes[VK_MAX_MEMORY_TYPES];
+
+    u64 block_bytes;
+    u64 block_count;
+    u64 suballocated_bytes;
+    u64 suballocation_count;
+    u64 dedicated_bytes;
+    u64 dedicated_count;
+} vulkan_memory_allocator;
+
 typedef struct vulkan_buffer {
     u64 total_size;
     VkBuffer handle;
     VkBufferUsageFlagBits usage;
     b8 is_locked;
-    VkDeviceMemory memory;
+    vulkan_memory_allocation allocation;
     i32 memory_index;
     u32 memory_property_flags;
+    // Set for persistently mapped buffers; valid for the buffer's lifetime.
+    void* mapped;
+    // False when writes through mapped need vulkan_buffer_flush to become visible to the device.
+    b8 is_coherent;
 } vulkan_buffer;
 
 typedef struct vulkan_swapchain_support_info {
@@ -45,6 +102,11 @@ typedef struct vulkan_device {
     VkQueue transfer_queue;
 
     VkCommandPool graphics_command_pool;
+    VkCommandPool transfer_command_pool;
+
+    VkPipelineCache pipeline_cache;
+    // True when the cache started out with data from a previous run.
+    b8 pipeline_cache_seeded;
 
     VkPhysicalDeviceProperties properties;
     VkPhysicalDeviceFeatures features;
@@ -55,7 +117,7 @@ typedef struct vulkan_device {
 
 typedef struct vulkan_image {
     VkImage handle;
-    VkDeviceMemory memory;
+    vulkan_memory_allocation allocation;
     VkImageView view;
     u32 width;
     u32 height;
@@ -94,8 +156,15 @@ typedef struct vulkan_swapchain {
     VkImageView* views;
 
     vulkan_image depth_attachment;
+    VkFormat depth_format;
 
     vulkan_framebuffer* framebuffers;
+
+    // Offscreen only. Owns the colour images which images and views point into, one per frame in flight.
+    vulkan_image* color_attachments;
+
+    // Set when acquire or present reports the surface has changed.
+    b8 out_of_date;
 } vulkan_swapchain;
 
 typedef enum vulkan_command_buffer_state {
@@ -130,15 +199,19 @@ typedef struct vulkan_pipeline {
 
 // vertex, shader
 #define OBJECT_SHADER_STAGE_COUNT 2
+// Upper bound used to size per-frame arrays and buffer regions. Matches RENDERER_MAX_FRAMES_IN_FLIGHT.
+#define VULKAN_MAX_FRAMES_IN_FLIGHT 3
+
 typedef struct vulkan_descriptor_state {
-    // One descriptor set per frame - max 3 for triple buffering
-    u32 generations[3];
+    // One per frame in flight.
+    u32 generations[VULKAN_MAX_FRAMES_IN_FLIGHT];
 } vulkan_descriptor_state;
 
-#define VULKAN_DESCRIPTORS_PER_OBJECT 2
+// Per object descriptors, in set 2. The object uniform lives in a single dynamic descriptor in set 1.
+#define VULKAN_DESCRIPTORS_PER_OBJECT 1
 typedef struct vulkan_object_shader_object_state {
-    // One descriptor set per frame - max 3 for triple buffering
-    VkDescriptorSet descriptor_sets[3];
+    // One descriptor set per frame in flight.
+    VkDescriptorSet descriptor_sets[VULKAN_MAX_FRAMES_IN_FLIGHT];
     vulkan_descriptor_state descriptor_states[VULKAN_DESCRIPTORS_PER_OBJECT];
 } vulkan_object_shader_object_state;
 
@@ -148,28 +221,152 @@ typedef struct vulkan_object_shader {
 
     VkDescriptorPool global_descriptor_pool;
 
-    // One descriptor set per frame - max 3 for triple buffering
-    VkDescriptorSet global_descriptor_sets[3];
+    // One descriptor set per frame in flight.
+    VkDescriptorSet global_descriptor_sets[VULKAN_MAX_FRAMES_IN_FLIGHT];
     VkDescriptorSetLayout global_descriptor_set_layout;
 
     global_uniform_object global_ubo;
 
+    // Persistently mapped. Holds one global_uniform_object per frame in flight.
     vulkan_buffer global_uniform_buffer;
+    // Size of each frame's slot, padded out to minUniformBufferOffsetAlignment.
+    u64 global_uniform_stride;
 
     VkDescriptorPool object_descriptor_pool;
     VkDescriptorSetLayout object_descriptor_set_layout;
+
+    // Holds one object_uniform_object per object per frame in flight, bound with a dynamic offset.
+    VkDescriptorSetLayout object_uniform_descriptor_set_layout;
+    VkDescriptorSet object_uniform_descriptor_set;
     vulkan_buffer object_uniform_buffer;
+    // Size of each object's slot, padded out to minUniformBufferOffsetAlignment.
+    u64 object_uniform_stride;
     u32 object_uniform_buffer_index;
 
     // TODO: make dynamic
     vulkan_object_shader_object_state object_states[MAX_VULKAN_OBJECT_COUNT];
 
+    // Advanced once per frame to animate the test diffuse colour.
+    f32 diffuse_accumulator;
+
     texture* default_diffuse;
 
     vulkan_pipeline pipeline;
+
+    // Same layouts and fragment stage, but the model matrix comes from an instance rate vertex binding.
+    vulkan_shader_stage instanced_vertex_stage;
+    vulkan_pipeline instanced_pipeline;
 } vulkan_object_shader;
 
+// One entry per VkSystemAllocationScope.
+#define VULKAN_ALLOCATION_SCOPE_COUNT 5
+typedef struct vulkan_allocator_stats {
+    // Host memory the driver has allocated through our callbacks.
+    u64 allocated[VULKAN_ALLOCATION_SCOPE_COUNT];
+    u64 counts[VULKAN_ALLOCATION_SCOPE_COUNT];
+    // Memory the driver allocated itself and only notified us about.
+    u64 internal_allocated[VULKAN_ALLOCATION_SCOPE_COUNT];
+} vulkan_allocator_stats;
+
+#define VULKAN_STAGING_MAX_SUBMISSIONS 16
+
+// A batch of staging space handed to the gpu, free to reuse once fence signals.
+typedef struct vulkan_staging_submission {
+    vulkan_fence fence;
+    u64 end;
+} vulkan_staging_submission;
+
+// Persistently mapped ring of host visible memory that all uploads copy through.
+// head and tail only ever increase; the position within the buffer is taken modulo size.
+typedef struct vulkan_staging_buffer {
+    vulkan_buffer buffer;
+    u8* mapped;
+    u64 size;
+    u64 head;
+    u64 tail;
+    // Start of the space allocated since the last submission.
+    u64 batch_start;
+    u64 alignment;
+
+    vulkan_staging_submission submissions[VULKAN_STAGING_MAX_SUBMISSIONS];
+    u32 submission_first;
+    u32 submission_count;
+} vulkan_staging_buffer;
+
+typedef enum vulkan_deletion_type {
+    VULKAN_DELETION_TYPE_BUFFER,
+    VULKAN_DELETION_TYPE_IMAGE,
+    VULKAN_DELETION_TYPE_SAMPLER,
+    VULKAN_DELETION_TYPE_COMMAND_BUFFER,
+    VULKAN_DELETION_TYPE_SWAPCHAIN
+} vulkan_deletion_type;
+
+// A resource released while the gpu may still be using it. Only the handles for type are set.
+typedef struct vulkan_deletion {
+    vulkan_deletion_type type;
+    // The last frame which may still reference the resource.
+    u64 frame_number;
+    VkBuffer buffer;
+    VkImage image;
+    VkImageView view;
+    VkSampler sampler;
+    VkCommandPool pool;
+    VkCommandBuffer command_buffer;
+    VkSwapchainKHR swapchain;
+    vulkan_memory_allocation allocation;
+} vulkan_deletion;
+
+#define VULKAN_TRANSFER_MAX_BATCHES 4
+
+// Graphics stages which may consume uploaded data, and so wait on the transfer queue.
+#define VULKAN_TRANSFER_CONSUMER_STAGES (VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+
+// Uploads recorded between two flushes. The copies run on the transfer queue, which signals
+// semaphore; the graphics queue waits on it, acquires ownership and then signals fence.
+typedef struct vulkan_transfer_batch {
+    vulkan_command_buffer transfer_command_buffer;
+    vulkan_command_buffer acquire_command_buffer;
+    VkSemaphore semaphore;
+    vulkan_fence fence;
+} vulkan_transfer_batch;
+
+typedef struct vulkan_transfer {
+    vulkan_transfer_batch batches[VULKAN_TRANSFER_MAX_BATCHES];
+    u32 current;
+    b8 recording;
+    // True when the transfer queue is in a different family, so ownership has to be handed to the graphics queue.
+    b8 ownership_transfer;
+} vulkan_transfer;
+
+// Upper bound on the secondary command buffers recorded side by side each frame.
+#define VULKAN_MAX_RECORD_WORKERS 8
+// Below this many draws per worker, splitting costs more than it saves.
+#define VULKAN_MIN_DRAWS_PER_WORKER 64
+
+typedef struct vulkan_record_worker {
+    // One pool per frame in flight, reset wholesale once that frame's fence has signaled.
+    // Pools are externally synchronized, so each recording thread needs its own.
+    VkCommandPool pools[VULKAN_MAX_FRAMES_IN_FLIGHT];
+    vulkan_command_buffer command_buffers[VULKAN_MAX_FRAMES_IN_FLIGHT];
+} vulkan_record_worker;
+
+// Instances beyond this in a single frame are dropped.
+#define VULKAN_MAX_INSTANCES_PER_FRAME 65536
+
+// A batched draw queued for the frame. Its instances already sit in the instance buffer.
+typedef struct vulkan_instanced_draw {
+    u32 object_id;
+    texture* textures[16];
+    u32 first_instance;
+    u32 instance_count;
+} vulkan_instanced_draw;
+
 typedef struct vulkan_context {
+    // Owned by the frontend. Read when the swapchain is (re)created.
+    renderer_config config;
+    // Set when config has changed since the swapchain was last created.
+    b8 config_changed;
+
     f32 frame_delta_time;
     u32 framebuffer_width;
     u32 framebuffer_height;
@@ -178,13 +375,19 @@ typedef struct vulkan_context {
     u64 framebuffer_size_last_generation;
 
     VkInstance instance;
+    // Points at allocation_callbacks, or is 0 to let the driver manage host memory itself.
     VkAllocationCallbacks* allocator;
+    VkAllocationCallbacks allocation_callbacks;
+    vulkan_allocator_stats allocator_stats;
     VkSurfaceKHR surface;
+    // Renders into images owned by the swapchain instead of presenting to a surface. Fixed at initialize.
+    b8 offscreen;
 #if defined(_DEBUG)
     VkDebugUtilsMessengerEXT debug_messenger;
 #endif
 
     vulkan_device device;
+    vulkan_memory_allocator memory_allocator;
 
     vulkan_swapchain swapchain;
     vulkan_renderpass main_renderpass;
@@ -192,8 +395,22 @@ typedef struct vulkan_context {
     vulkan_buffer object_vertex_buffer;
     vulkan_buffer object_index_buffer;
 
+    vulkan_staging_buffer staging_buffer;
+    vulkan_transfer transfer;
+
     vulkan_command_buffer* graphics_command_buffers;
 
+    vulkan_record_worker record_workers[VULKAN_MAX_RECORD_WORKERS];
+    u32 record_worker_count;
+    // darray of draws submitted this frame, recorded into secondaries at end_frame.
+    geometry_render_data* draw_list;
+    // darray of batched draws submitted this frame.
+    vulkan_instanced_draw* instanced_draw_list;
+    // Persistently mapped. Holds VULKAN_MAX_INSTANCES_PER_FRAME render_instance_data per frame in flight.
+    vulkan_buffer instance_buffer;
+    // Instances written into the current frame's region so far.
+    u32 instance_count;
+
     VkSemaphore* image_available_semaphores;
     VkSemaphore* queue_complete_semaphores;
 
@@ -202,8 +419,22 @@ typedef struct vulkan_context {
     // Holds pointers to fences which exist and are owned elsewhere
     vulkan_fence** images_in_flight;
 
+    // The frame being recorded. Starts at 1 and increases with every submitted frame.
+    u64 frame_number;
+    // The newest frame known to have finished on the gpu.
+    u64 completed_frame_number;
+    // The frame last submitted with each in-flight fence, or 0.
+    u64* in_flight_frame_numbers;
+
+    // darray of resources waiting on the frames which may use them to finish.
+    vulkan_deletion* deletion_queue;
+
     u32 image_index;
     u32 current_frame;
+    // The image the last submitted frame rendered into, or -1 if there isn't one since the swapchain was created.
+    i32 last_rendered_image_index;
+    // Host visible destination for vulkan_read_pixels. Grown on demand.
+    vulkan_buffer readback_buffer;
 
     b8 recreating_swapchain;
 
@@ -212,6 +443,9 @@ typedef struct vulkan_context {
 
     vulkan_object_shader object_shader;
 
+    // Backing storage for vulkan_texture_data, one element per texture.
+    pool_allocator texture_data_pool;
+
     i32 (*find_memory_index)(u32 type_filter, u32 property_flags);
 } vulkan_context;
 
@@ -0,0 +1,326 @@
+#include "job_system.h"
+
+#include "core/kmemory.h"
+#include "core/ksemaphore.h"
+#include "core/kstring.h"
+#include "core/kthread.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+// Jobs per deque, a power of 2. A deque only fills up when its thread submits faster than
+// everyone else can take, so overflow runs inline rather than growing.
+#define JOB_DEQUE_CAPACITY 1024
+#define JOB_MAX_THREADS 64
+// Failed searches for work before a worker sleeps, or a waiting thread starts yielding.
+#define JOB_SPIN_COUNT 64
+
+// Fields are atomic because a thief may read a slot while the owner reuses it. The thief's
+// compare exchange on top fails in that case, so the torn job is never run.
+typedef struct job_slot {
+    katomic_ptr entry_point;
+    katomic_ptr params;
+    katomic_ptr counter;
+} job_slot;
+
+// Chase-Lev deque: the owner pushes and pops at bottom, thieves take from top. top and bottom
+// are kept on separate cache lines since thieves and the owner each hammer their own.
+typedef struct job_deque {
+    katomic_i64 top;
+    u8 padding_0[56];
+    katomic_i64 bottom;
+    u8 padding_1[56];
+    job_slot slots[JOB_DEQUE_CAPACITY];
+} job_deque;
+
+typedef struct job_thread {
+    job_deque deques[JOB_PRIORITY_COUNT];
+    // Unused for the initializing thread at index 0.
+    kthread thread;
+    u32 index;
+} job_thread;
+
+typedef struct job_system_state {
+    katomic_u32 running;
+    // Workers which have announced they are about to sleep on wake.
+    katomic_u32 sleeping;
+    ksemaphore wake;
+    u32 thread_count;
+    job_thread* threads;
+} job_system_state;
+
+static job_system_state* state_ptr;
+
+// The calling thread's index into threads, or -1 if it has no deques.
+static _Thread_local i32 thread_index = -1;
+// xorshift state for picking steal victims.
+static _Thread_local u32 random_state;
+
+static u32 next_random() {
+    if (random_state == 0) {
+        random_state = (u32)kthread_current_id() * 2654435761u | 1;
+    }
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static b8 deque_push(job_deque* deque, const job_info* job) {
+    i64 bottom = katomic_load(&deque->bottom, KATOMIC_RELAXED);
+    i64 top = katomic_load(&deque->top, KATOMIC_ACQUIRE);
+    if (bottom - top >= JOB_DEQUE_CAPACITY) {
+        return false;
+    }
+
+    job_slot* slot = &deque->slots[bottom & (JOB_DEQUE_CAPACITY - 1)];
+    katomic_store(&slot->entry_point, (void*)job->entry_point, KATOMIC_RELAXED);
+    katomic_store(&slot->params, job->params, KATOMIC_RELAXED);
+    katomic_store(&slot->counter, (void*)job->counter, KATOMIC_RELAXED);
+    // Publishes the slot to thieves, which load bottom with acquire.
+    katomic_store(&deque->bottom, bottom + 1, KATOMIC_RELEASE);
+    return true;
+}
+
+static void slot_read(job_slot* slot, job_info* out_job) {
+    out_job->entry_point = (pfn_job_entry)katomic_load(&slot->entry_point, KATOMIC_RELAXED);
+    out_job->params = katomic_load(&slot->params, KATOMIC_RELAXED);
+    out_job->counter = katomic_load(&slot->counter, KATOMIC_RELAXED);
+}
+
+// Owner only.
+static b8 deque_pop(job_deque* deque, job_info* out_job) {
+    i64 bottom = katomic_load(&deque->bottom, KATOMIC_RELAXED) - 1;
+    katomic_store(&deque->bottom, bottom, KATOMIC_RELAXED);
+    katomic_thread_fence(KATOMIC_SEQ_CST);
+    i64 top = katomic_load(&deque->top, KATOMIC_RELAXED);
+
+    if (top > bottom) {
+        // Empty.
+        katomic_store(&deque->bottom, bottom + 1, KATOMIC_RELAXED);
+        return false;
+    }
+
+    slot_read(&deque->slots[bottom & (JOB_DEQUE_CAPACITY - 1)], out_job);
+    if (top != bottom) {
+        return true;
+    }
+
+    // The last job, which a thief may be taking at the same time.
+    b8 taken = katomic_compare_exchange_strong(&deque->top, &top, top + 1, KATOMIC_SEQ_CST, KATOMIC_RELAXED);
+    katomic_store(&deque->bottom, bottom + 1, KATOMIC_RELAXED);
+    return taken;
+}
+
+// Any thread. Fails if the deque is empty or another thread got there first.
+static b8 deque_steal(job_deque* deque, job_info* out_job) {
+    i64 top = katomic_load(&deque->top, KATOMIC_ACQUIRE);
+    katomic_thread_fence(KATOMIC_SEQ_CST);
+    i64 bottom = katomic_load(&deque->bottom, KATOMIC_ACQUIRE);
+    if (top >= bottom) {
+        return false;
+    }
+
+    slot_read(&deque->slots[top & (JOB_DEQUE_CAPACITY - 1)], out_job);
+    return katomic_compare_exchange_strong(&deque->top, &top, top + 1, KATOMIC_SEQ_CST, KATOMIC_RELAXED);
+}
+
+// Takes the highest priority job available, preferring the calling thread's own deques.
+static b8 find_job(job_info* out_job) {
+    u32 count = state_ptr->thread_count;
+    for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+        if (thread_index >= 0 && deque_pop(&state_ptr->threads[thread_index].deques[p], out_job)) {
+            out_job->priority = p;
+            return true;
+        }
+
+        // Start from a random victim so thieves spread out rather than piling onto one thread.
+        u32 start = next_random() % count;
+        for (u32 i = 0; i < count; ++i) {
+            u32 victim = (start + i) % count;
+            if ((i32)victim == thread_index) {
+                continue;
+            }
+            if (deque_steal(&state_ptr->threads[victim].deques[p], out_job)) {
+                out_job->priority = p;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void run_job(const job_info* job) {
+    job->entry_point(job->params);
+    if (job->counter) {
+        // Releases the job's writes to whoever sees the counter reach zero.
+        katomic_fetch_sub(&job->counter->remaining, 1, KATOMIC_RELEASE);
+    }
+}
+
+static u32 worker_run(void* params) {
+    job_thread* self = params;
+    thread_index = self->index;
+
+    job_info job;
+    u32 idle_spins = 0;
+    while (katomic_load(&state_ptr->running, KATOMIC_ACQUIRE)) {
+        if (find_job(&job)) {
+            run_job(&job);
+            idle_spins = 0;
+            continue;
+        }
+
+        if (++idle_spins < JOB_SPIN_COUNT) {
+            katomic_pause();
+            continue;
+        }
+
+        // Announce the sleep before looking one last time. A submit either sees this worker as
+        // sleeping and signals, or its job is found here.
+        katomic_fetch_add(&state_ptr->sleeping, 1, KATOMIC_SEQ_CST);
+        if (find_job(&job)) {
+            katomic_fetch_sub(&state_ptr->sleeping, 1, KATOMIC_SEQ_CST);
+            run_job(&job);
+        } else {
+            ksemaphore_wait(&state_ptr->wake);
+            katomic_fetch_sub(&state_ptr->sleeping, 1, KATOMIC_SEQ_CST);
+        }
+        idle_spins = 0;
+    }
+
+    thread_index = -1;
+    return 0;
+}
+
+b8 job_system_initialize(u64* memory_requirement, void* state, job_system_config config) {
+    u32 processor_count = platform_get_processor_count();
+    u32 worker_count = config.worker_count;
+    if (worker_count == 0) {
+        worker_count = processor_count > 1 ? processor_count - 1 : 1;
+    }
+    if (worker_count > JOB_MAX_THREADS - 1) {
+        worker_count = JOB_MAX_THREADS - 1;
+    }
+
+    *memory_requirement = sizeof(job_system_state) + sizeof(job_thread) * (worker_count + 1);
+    if (state == 0) {
+        return true;
+    }
+
+    kzero_memory(state, *memory_requirement);
+    state_ptr = state;
+    state_ptr->thread_count = worker_count + 1;
+    state_ptr->threads = (job_thread*)((u8*)state + sizeof(job_system_state));
+    for (u32 i = 0; i < state_ptr->thread_count; ++i) {
+        job_thread* thread = &state_ptr->threads[i];
+        thread->index = i;
+        for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+            katomic_init(&thread->deques[p].top, 0);
+            katomic_init(&thread->deques[p].bottom, 0);
+        }
+    }
+    katomic_init(&state_ptr->running, 1);
+    katomic_init(&state_ptr->sleeping, 0);
+    if (!ksemaphore_create(0, &state_ptr->wake)) {
+        KERROR("job_system_initialize - failed to create the worker wake semaphore.");
+        state_ptr = 0;
+        return false;
+    }
+
+    thread_index = 0;
+
+    for (u32 i = 1; i < state_ptr->thread_count; ++i) {
+        job_thread* thread = &state_ptr->threads[i];
+        if (!kthread_create(worker_run, thread, &thread->thread)) {
+            KERROR("job_system_initialize - failed to start worker thread %u.", i);
+            // Only the threads started so far need stopping.
+            state_ptr->thread_count = i;
+            job_system_shutdown(state);
+            return false;
+        }
+
+        char name[16];
+        string_format(name, "kohi_job_%u", i);
+        kthread_set_name(&thread->thread, name);
+        if (config.pin_workers) {
+            kthread_set_affinity(&thread->thread, i % processor_count);
+        }
+    }
+
+    KINFO("Job system started with %u worker threads.", worker_count);
+    return true;
+}
+
+void job_system_shutdown(void* state) {
+    if (!state_ptr) {
+        return;
+    }
+
+    katomic_store(&state_ptr->running, 0, KATOMIC_RELEASE);
+    // Every worker is either spinning, and will see running, or will take one of these.
+    ksemaphore_signal(&state_ptr->wake, state_ptr->thread_count - 1);
+    for (u32 i = 1; i < state_ptr->thread_count; ++i) {
+        kthread_join(&state_ptr->threads[i].thread, 0);
+    }
+
+    ksemaphore_destroy(&state_ptr->wake);
+    thread_index = -1;
+    state_ptr = 0;
+}
+
+job_info job_create(pfn_job_entry entry_point, void* params, job_priority priority, job_counter* counter) {
+    job_info job;
+    job.entry_point = entry_point;
+    job.params = params;
+    job.priority = priority;
+    job.counter = counter;
+    return job;
+}
+
+void job_system_submit(const job_info* jobs, u32 count) {
+    u32 queued = 0;
+    for (u32 i = 0; i < count; ++i) {
+        const job_info* job = &jobs[i];
+        // Counted before it's visible, or a fast thief could take the counter below zero.
+        if (job->counter) {
+            katomic_fetch_add(&job->counter->remaining, 1, KATOMIC_RELAXED);
+        }
+
+        if (state_ptr && thread_index >= 0 && deque_push(&state_ptr->threads[thread_index].deques[job->priority], job)) {
+            queued++;
+        } else {
+            run_job(job);
+        }
+    }
+
+    if (queued == 0) {
+        return;
+    }
+
+    // Pairs with a worker announcing it is about to sleep.
+    katomic_thread_fence(KATOMIC_SEQ_CST);
+    u32 sleeping = katomic_load(&state_ptr->sleeping, KATOMIC_RELAXED);
+    if (sleeping > 0) {
+        ksemaphore_signal(&state_ptr->wake, queued < sleeping ? queued : sleeping);
+    }
+}
+
+void job_system_wait(job_counter* counter) {
+    job_info job;
+    u32 idle_spins = 0;
+    while (katomic_load(&counter->remaining, KATOMIC_ACQUIRE) > 0) {
+        if (state_ptr && find_job(&job)) {
+            run_job(&job);
+            idle_spins = 0;
+        } else if (++idle_spins < JOB_SPIN_COUNT) {
+            katomic_pause();
+        } else {
+            // The last jobs are running elsewhere. Don't starve them of a core.
+            kthread_yield();
+        }
+    }
+}
+
+u32 job_system_thread_count() {
+    return state_ptr ? state_ptr->thread_count : 1;
+}
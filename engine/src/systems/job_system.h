@@ -0,0 +1,69 @@
+#pragma once
+
+#include "defines.h"
+
+#include "core/katomic.h"
+
+/**
+ * @brief Runs small units of work across one worker thread per core. Every thread has its own
+ * Chase-Lev deque per priority: it pushes and pops at one end without locking, and idle threads
+ * steal from the other. The thread which initialized the system also runs jobs, but only while
+ * waiting on a counter.
+ */
+
+typedef enum job_priority {
+    // Needed this frame, e.g. culling and command recording.
+    JOB_PRIORITY_HIGH,
+    JOB_PRIORITY_NORMAL,
+    // Background work such as asset loading and texture decoding.
+    JOB_PRIORITY_LOW,
+    JOB_PRIORITY_COUNT
+} job_priority;
+
+typedef void (*pfn_job_entry)(void* params);
+
+// Counts the jobs submitted with it which haven't finished yet. Zero it before the first use.
+typedef struct job_counter {
+    katomic_u32 remaining;
+} job_counter;
+
+typedef struct job_info {
+    pfn_job_entry entry_point;
+    // Not copied, so it must stay valid until the job has run.
+    void* params;
+    job_priority priority;
+    // Optional. Incremented on submit and decremented once the job has run.
+    job_counter* counter;
+} job_info;
+
+typedef struct job_system_config {
+    // Worker threads to start. 0 starts one per logical processor, less one for the main thread.
+    u32 worker_count;
+    // Pins each worker to its own logical processor, leaving processor 0 to the main thread.
+    b8 pin_workers;
+} job_system_config;
+
+/**
+ * @brief Initializes the job system. Call once with state set to 0 to obtain the memory
+ * requirement, then again with a block of at least that size. The calling thread becomes the one
+ * allowed to submit and wait from outside of jobs.
+ */
+KAPI b8 job_system_initialize(u64* memory_requirement, void* state, job_system_config config);
+
+// Stops and joins the workers. Jobs which haven't started are dropped, so wait on counters first.
+KAPI void job_system_shutdown(void* state);
+
+KAPI job_info job_create(pfn_job_entry entry_point, void* params, job_priority priority, job_counter* counter);
+
+/**
+ * @brief Queues jobs on the calling thread's deques, from where any idle thread can take them.
+ * Only the initializing thread and jobs have deques. From any other thread, when the job system
+ * isn't running, or when the deque is full, jobs run straight away on the calling thread instead.
+ */
+KAPI void job_system_submit(const job_info* jobs, u32 count);
+
+// Runs queued jobs on the calling thread until every job submitted with counter has finished.
+KAPI void job_system_wait(job_counter* counter);
+
+// Worker threads plus the initializing thread, or 1 if the job system isn't running.
+KAPI u32 job_system_thread_count();
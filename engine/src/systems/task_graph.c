@@ -0,0 +1,415 @@
+#include "task_graph.h"
+
+#include "containers/darray.h"
+#include "core/katomic.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+#include "systems/job_system.h"
+
+typedef struct task_graph_state task_graph_state;
+
+typedef struct graph_task {
+    char* name;
+    pfn_task_run run;
+    void* user_data;
+    // darrays of resource ids, as declared.
+    u32* reads;
+    u32* writes;
+
+    // darrays of task ids, rebuilt whenever a task is added.
+    u32* dependencies;
+    u32* dependents;
+
+    task_graph_state* graph;
+    // Dependencies which haven't finished yet in this execution.
+    katomic_u32 pending;
+    // Set when a dependency failed or was itself skipped.
+    katomic_u32 skipped;
+    f64 start_time;
+    f64 end_time;
+
+    // Longest chain of dependencies ending with this task, and the task before it on that chain.
+    f64 path_time;
+    u32 path_previous;
+} graph_task;
+
+struct task_graph_state {
+    // darray of names, indexed by resource id.
+    char** resources;
+    // darray of graph_task*, indexed by task id. Pointers so job params stay put as it grows.
+    graph_task** tasks;
+    // darray of task ids with no dependencies.
+    u32* roots;
+    b8 dirty;
+    b8 executing;
+
+    job_counter counter;
+    katomic_u32 failed;
+
+    // darray of task ids, first to last.
+    u32* critical_path;
+    f64 critical_path_time;
+};
+
+static void task_job(void* params);
+
+static void free_string(char* str) {
+    kfree(str, string_length(str) + 1, MEMORY_TAG_STRING);
+}
+
+static b8 contains(u32* ids, u32 id) {
+    u64 length = darray_length(ids);
+    for (u64 i = 0; i < length; ++i) {
+        if (ids[i] == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void add_edge(task_graph_state* graph, u32 from, u32 to) {
+    if (from == INVALID_ID || from == to) {
+        return;
+    }
+    graph_task* task = graph->tasks[to];
+    if (contains(task->dependencies, from)) {
+        return;
+    }
+    darray_push(task->dependencies, from);
+    darray_push(graph->tasks[from]->dependents, to);
+}
+
+// Walks the tasks in declaration order, tracking who last wrote each resource and who has read
+// it since.
+static void compile(task_graph_state* graph) {
+    u64 task_count = darray_length(graph->tasks);
+    u64 resource_count = darray_length(graph->resources);
+
+    // A darray created empty never grows.
+    u64 capacity = resource_count > 0 ? resource_count : 1;
+    u32* last_writers = darray_reserve(u32, capacity);
+    u32** readers = darray_reserve(u32*, capacity);
+    for (u64 r = 0; r < resource_count; ++r) {
+        darray_push(last_writers, INVALID_ID);
+        u32* resource_readers = darray_create(u32);
+        darray_push(readers, resource_readers);
+    }
+
+    for (u64 t = 0; t < task_count; ++t) {
+        darray_clear(graph->tasks[t]->dependencies);
+        darray_clear(graph->tasks[t]->dependents);
+    }
+    darray_clear(graph->roots);
+
+    for (u32 t = 0; t < task_count; ++t) {
+        graph_task* task = graph->tasks[t];
+
+        u64 write_count = darray_length(task->writes);
+        for (u64 w = 0; w < write_count; ++w) {
+            u32 resource = task->writes[w];
+            add_edge(graph, last_writers[resource], t);
+            u64 reader_count = darray_length(readers[resource]);
+            for (u64 i = 0; i < reader_count; ++i) {
+                add_edge(graph, readers[resource][i], t);
+            }
+        }
+
+        u64 read_count = darray_length(task->reads);
+        for (u64 r = 0; r < read_count; ++r) {
+            u32 resource = task->reads[r];
+            if (contains(task->writes, resource)) {
+                continue;
+            }
+            add_edge(graph, last_writers[resource], t);
+            if (!contains(readers[resource], t)) {
+                darray_push(readers[resource], t);
+            }
+        }
+
+        for (u64 w = 0; w < write_count; ++w) {
+            u32 resource = task->writes[w];
+            last_writers[resource] = t;
+            darray_clear(readers[resource]);
+        }
+
+        if (darray_length(task->dependencies) == 0) {
+            darray_push(graph->roots, t);
+        }
+    }
+
+    for (u64 r = 0; r < resource_count; ++r) {
+        darray_destroy(readers[r]);
+    }
+    darray_destroy(readers);
+    darray_destroy(last_writers);
+    graph->dirty = false;
+}
+
+static void submit_task(graph_task* task) {
+    job_info job = job_create(task_job, task, JOB_PRIORITY_HIGH, &task->graph->counter);
+    job_system_submit(&job, 1);
+}
+
+static void task_job(void* params) {
+    graph_task* task = params;
+    task_graph_state* graph = task->graph;
+
+    b8 succeeded = false;
+    if (!katomic_load(&task->skipped, KATOMIC_RELAXED)) {
+        task->start_time = platform_get_absolute_time();
+        succeeded = task->run(task->user_data);
+        task->end_time = platform_get_absolute_time();
+        if (!succeeded) {
+            KERROR("Task '%s' failed. Skipping the tasks which depend on it.", task->name);
+            katomic_store(&graph->failed, 1, KATOMIC_RELAXED);
+        }
+    }
+
+    u64 dependent_count = darray_length(task->dependents);
+    for (u64 i = 0; i < dependent_count; ++i) {
+        graph_task* dependent = graph->tasks[task->dependents[i]];
+        if (!succeeded) {
+            katomic_store(&dependent->skipped, 1, KATOMIC_RELAXED);
+        }
+        // Whoever finishes last submits it, having acquired the other dependencies' writes.
+        if (katomic_fetch_sub(&dependent->pending, 1, KATOMIC_ACQ_REL) == 1) {
+            submit_task(dependent);
+        }
+    }
+}
+
+// Tasks are in declaration order, which is also an order where dependencies come first.
+static void update_critical_path(task_graph_state* graph) {
+    u32 task_count = darray_length(graph->tasks);
+    u32 last = INVALID_ID;
+    f64 longest = 0;
+    for (u32 t = 0; t < task_count; ++t) {
+        graph_task* task = graph->tasks[t];
+        task->path_time = 0;
+        task->path_previous = INVALID_ID;
+        u64 dependency_count = darray_length(task->dependencies);
+        for (u64 i = 0; i < dependency_count; ++i) {
+            graph_task* dependency = graph->tasks[task->dependencies[i]];
+            if (task->path_previous == INVALID_ID || dependency->path_time > task->path_time) {
+                task->path_time = dependency->path_time;
+                task->path_previous = task->dependencies[i];
+            }
+        }
+        task->path_time += task->end_time - task->start_time;
+        if (last == INVALID_ID || task->path_time > longest) {
+            longest = task->path_time;
+            last = t;
+        }
+    }
+
+    darray_clear(graph->critical_path);
+    for (u32 t = last; t != INVALID_ID; t = graph->tasks[t]->path_previous) {
+        darray_push(graph->critical_path, t);
+    }
+    // Collected back to front.
+    u64 length = darray_length(graph->critical_path);
+    for (u64 i = 0; i < length / 2; ++i) {
+        u32 swap = graph->critical_path[i];
+        graph->critical_path[i] = graph->critical_path[length - 1 - i];
+        graph->critical_path[length - 1 - i] = swap;
+    }
+    graph->critical_path_time = longest;
+}
+
+b8 task_graph_create(task_graph* out_graph) {
+    if (!out_graph) {
+        return false;
+    }
+
+    task_graph_state* graph = kallocate(sizeof(task_graph_state), MEMORY_TAG_JOB);
+    graph->resources = darray_create(char*);
+    graph->tasks = darray_create(graph_task*);
+    graph->roots = darray_create(u32);
+    graph->critical_path = darray_create(u32);
+    katomic_init(&graph->counter.remaining, 0);
+    katomic_init(&graph->failed, 0);
+    out_graph->internal_data = graph;
+    return true;
+}
+
+void task_graph_destroy(task_graph* graph) {
+    if (!graph || !graph->internal_data) {
+        return;
+    }
+
+    task_graph_state* state = graph->internal_data;
+    u64 task_count = darray_length(state->tasks);
+    for (u64 t = 0; t < task_count; ++t) {
+        graph_task* task = state->tasks[t];
+        free_string(task->name);
+        darray_destroy(task->reads);
+        darray_destroy(task->writes);
+        darray_destroy(task->dependencies);
+        darray_destroy(task->dependents);
+        kfree(task, sizeof(graph_task), MEMORY_TAG_JOB);
+    }
+    u64 resource_count = darray_length(state->resources);
+    for (u64 r = 0; r < resource_count; ++r) {
+        free_string(state->resources[r]);
+    }
+    darray_destroy(state->tasks);
+    darray_destroy(state->resources);
+    darray_destroy(state->roots);
+    darray_destroy(state->critical_path);
+    kfree(state, sizeof(task_graph_state), MEMORY_TAG_JOB);
+    graph->internal_data = 0;
+}
+
+u32 task_graph_resource(task_graph* graph, const char* name) {
+    if (!graph || !graph->internal_data || !name) {
+        return INVALID_ID;
+    }
+
+    task_graph_state* state = graph->internal_data;
+    u32 resource_count = darray_length(state->resources);
+    for (u32 r = 0; r < resource_count; ++r) {
+        if (string_equal(state->resources[r], name)) {
+            return r;
+        }
+    }
+    char* copy = string_duplicate(name);
+    darray_push(state->resources, copy);
+    return resource_count;
+}
+
+b8 task_graph_add_task(task_graph* graph, const task_desc* desc, u32* out_task_id) {
+    if (!graph || !graph->internal_data || !desc || !desc->run) {
+        KERROR("task_graph_add_task requires a graph and a task with a run function.");
+        return false;
+    }
+
+    task_graph_state* state = graph->internal_data;
+    if (state->executing) {
+        KERROR("task_graph_add_task - tasks can't be added while the graph is executing.");
+        return false;
+    }
+
+    u32 resource_count = darray_length(state->resources);
+    for (u32 i = 0; i < desc->read_count; ++i) {
+        if (desc->reads[i] >= resource_count) {
+            KERROR("task_graph_add_task - task '%s' reads unknown resource %u.", desc->name ? desc->name : "", desc->reads[i]);
+            return false;
+        }
+    }
+    for (u32 i = 0; i < desc->write_count; ++i) {
+        if (desc->writes[i] >= resource_count) {
+            KERROR("task_graph_add_task - task '%s' writes unknown resource %u.", desc->name ? desc->name : "", desc->writes[i]);
+            return false;
+        }
+    }
+
+    graph_task* task = kallocate(sizeof(graph_task), MEMORY_TAG_JOB);
+    task->name = string_duplicate(desc->name ? desc->name : "");
+    task->run = desc->run;
+    task->user_data = desc->user_data;
+    task->reads = darray_reserve(u32, desc->read_count > 0 ? desc->read_count : 1);
+    for (u32 i = 0; i < desc->read_count; ++i) {
+        darray_push(task->reads, desc->reads[i]);
+    }
+    task->writes = darray_reserve(u32, desc->write_count > 0 ? desc->write_count : 1);
+    for (u32 i = 0; i < desc->write_count; ++i) {
+        darray_push(task->writes, desc->writes[i]);
+    }
+    task->dependencies = darray_create(u32);
+    task->dependents = darray_create(u32);
+    task->graph = state;
+    katomic_init(&task->pending, 0);
+    katomic_init(&task->skipped, 0);
+    task->path_previous = INVALID_ID;
+
+    if (out_task_id) {
+        *out_task_id = darray_length(state->tasks);
+    }
+    darray_push(state->tasks, task);
+    state->dirty = true;
+    return true;
+}
+
+b8 task_graph_execute(task_graph* graph) {
+    if (!graph || !graph->internal_data) {
+        return false;
+    }
+
+    task_graph_state* state = graph->internal_data;
+    if (state->dirty) {
+        compile(state);
+    }
+
+    u64 task_count = darray_length(state->tasks);
+    if (task_count == 0) {
+        return true;
+    }
+
+    state->executing = true;
+    for (u64 t = 0; t < task_count; ++t) {
+        graph_task* task = state->tasks[t];
+        katomic_store(&task->pending, darray_length(task->dependencies), KATOMIC_RELAXED);
+        katomic_store(&task->skipped, 0, KATOMIC_RELAXED);
+        task->start_time = 0;
+        task->end_time = 0;
+    }
+    katomic_store(&state->failed, 0, KATOMIC_RELAXED);
+
+    // Dependents are submitted before the job which unblocked them finishes, so the counter only
+    // reaches zero once every task has run or been skipped.
+    u64 root_count = darray_length(state->roots);
+    for (u64 i = 0; i < root_count; ++i) {
+        submit_task(state->tasks[state->roots[i]]);
+    }
+    job_system_wait(&state->counter);
+    state->executing = false;
+
+    update_critical_path(state);
+    return katomic_load(&state->failed, KATOMIC_RELAXED) == 0;
+}
+
+f64 task_graph_critical_path(task_graph* graph, u32* out_count, u32* out_task_ids) {
+    if (!graph || !graph->internal_data) {
+        if (out_count) {
+            *out_count = 0;
+        }
+        return 0;
+    }
+
+    task_graph_state* state = graph->internal_data;
+    u32 length = darray_length(state->critical_path);
+    if (out_count) {
+        *out_count = length;
+    }
+    if (out_task_ids) {
+        kcopy_memory(out_task_ids, state->critical_path, sizeof(u32) * length);
+    }
+    return state->critical_path_time;
+}
+
+f64 task_graph_task_time(task_graph* graph, u32 task_id) {
+    if (!graph || !graph->internal_data) {
+        return 0;
+    }
+
+    task_graph_state* state = graph->internal_data;
+    if (task_id >= darray_length(state->tasks)) {
+        return 0;
+    }
+    graph_task* task = state->tasks[task_id];
+    return task->end_time - task->start_time;
+}
+
+const char* task_graph_task_name(task_graph* graph, u32 task_id) {
+    if (!graph || !graph->internal_data) {
+        return 0;
+    }
+
+    task_graph_state* state = graph->internal_data;
+    if (task_id >= darray_length(state->tasks)) {
+        return 0;
+    }
+    return state->tasks[task_id]->name;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A set of tasks declared once and run every frame on the job system. Each task names the
+ * resources it reads and writes. A task runs after the last earlier task that writes anything it
+ * touches, and a writer also runs after the earlier readers of what it writes. Everything else
+ * runs in parallel. Declaration order decides who goes first, so the graph can never cycle.
+ */
+
+// Returns false to report a failure. Tasks which depend on it are skipped for that execution.
+typedef b8 (*pfn_task_run)(void* user_data);
+
+typedef struct task_desc {
+    // Copied. Used for logging and for reading back the critical path.
+    const char* name;
+    pfn_task_run run;
+    // Not copied, so it must stay valid for as long as the task is in the graph.
+    void* user_data;
+    // Resource ids from task_graph_resource. Listing one in both is the same as only writing it.
+    u32 read_count;
+    const u32* reads;
+    u32 write_count;
+    const u32* writes;
+} task_desc;
+
+typedef struct task_graph {
+    void* internal_data;
+} task_graph;
+
+KAPI b8 task_graph_create(task_graph* out_graph);
+
+KAPI void task_graph_destroy(task_graph* graph);
+
+// Gets the id of the named resource, adding it the first time it is asked for.
+KAPI u32 task_graph_resource(task_graph* graph, const char* name);
+
+// Adds a task after every task added so far. Not allowed while the graph is executing.
+KAPI b8 task_graph_add_task(task_graph* graph, const task_desc* desc, u32* out_task_id);
+
+/**
+ * @brief Runs every task once and returns when all have finished, helping out with jobs while it
+ * waits. Returns false if any task failed.
+ */
+KAPI b8 task_graph_execute(task_graph* graph);
+
+/**
+ * @brief The chain of dependent tasks which took longest in the last execution, i.e. the shortest
+ * the graph could have taken with unlimited threads. Call with out_task_ids set to 0 to get the
+ * task count, then again with room for that many ids. Returns the total time of the chain in
+ * seconds.
+ */
+KAPI f64 task_graph_critical_path(task_graph* graph, u32* out_count, u32* out_task_ids);
+
+// Seconds the task ran for in the last execution. 0 if it was skipped.
+KAPI f64 task_graph_task_time(task_graph* graph, u32 task_id);
+
+KAPI const char* task_graph_task_name(task_graph* graph, u32 task_id);
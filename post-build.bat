@@ -10,6 +10,10 @@ echo "assets/shaders/Builtin.ObjectShader.vert.glsl -> bin/assets/shaders/Builti
 %VULKAN_SDK%\bin\glslc.exe -fshader-stage=vert assets/shaders/Builtin.ObjectShader.vert.glsl -o bin/assets/shaders/Builtin.ObjectShader.vert.spv
 IF %ERRORLEVEL% NEQ 0 (echo Error: failed to compile vertex shader code:%ERRORLEVEL% && exit)
 
+echo "assets/shaders/Builtin.ObjectShaderInstanced.vert.glsl -> bin/assets/shaders/Builtin.ObjectShaderInstanced.vert.spv"
+%VULKAN_SDK%\bin\glslc.exe -fshader-stage=vert assets/shaders/Builtin.ObjectShaderInstanced.vert.glsl -o bin/assets/shaders/Builtin.ObjectShaderInstanced.vert.spv
+IF %ERRORLEVEL% NEQ 0 (echo Error: failed to compile vertex shader code:%ERRORLEVEL% && exit)
+
 echo "assets/shaders/Builtin.ObjectShader.frag.glsl -> bin/assets/shaders/Builtin.ObjectShader.frag.spv"
 %VULKAN_SDK%\bin\glslc.exe -fshader-stage=frag assets/shaders/Builtin.ObjectShader.frag.glsl -o bin/assets/shaders/Builtin.ObjectShader.frag.spv
 IF %ERRORLEVEL% NEQ 0 (echo Error: failed to compile fragment shader code:%ERRORLEVEL% && exit)
@@ -0,0 +1,32 @@
+#!/bin/bash
+
+# Run from root directory
+
+# glslc from the SDK if one is set, otherwise from the PATH.
+GLSLC=glslc
+if [ -n "$VULKAN_SDK" ]
+then
+GLSLC=$VULKAN_SDK/bin/glslc
+fi
+
+mkdir -p bin/assets/shaders
+
+echo "Compiling shaders..."
+
+for SHADER in assets/shaders/*.glsl
+do
+    NAME=$(basename "$SHADER" .glsl)
+    STAGE=${NAME##*.}
+    echo "$SHADER -> bin/assets/shaders/$NAME.spv"
+    $GLSLC -fshader-stage=$STAGE "$SHADER" -o "bin/assets/shaders/$NAME.spv"
+    ERRORLEVEL=$?
+    if [ $ERRORLEVEL -ne 0 ]
+    then
+    echo "Error: failed to compile $STAGE shader code:"$ERRORLEVEL && exit $ERRORLEVEL
+    fi
+done
+
+echo "Copying assets..."
+cp -R assets bin
+
+echo "Done"
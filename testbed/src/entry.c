@@ -8,11 +8,15 @@ b8 create_game(game* out_game) {
     out_game->app_config.start_width = 1280;
     out_game->app_config.start_height = 720;
     out_game->app_config.name = "Kohi Testbed";
+    out_game->app_config.memory_budget = 512 * 1024 * 1024;  // 512 mb
+    out_game->app_config.renderer.frames_in_flight = 2;
+    out_game->app_config.renderer.present_mode = RENDERER_PRESENT_MODE_MAILBOX;
 
     out_game->initialize = game_initialize;
     out_game->update = game_update;
     out_game->render = game_render;
     out_game->on_resize = game_on_resize;
+    out_game->shutdown = game_shutdown;
 
     out_game->state = kallocate(sizeof(game_state), MEMORY_TAG_GAME);
     out_game->application_state = NULL;
@@ -46,6 +46,63 @@ void camera_yaw(game_state* state, f32 amount) {
     state->camera_view_dirty = true;
 }
 
+// Laid out in a square grid facing the camera.
+#define BENCHMARK_QUAD_ROWS 100
+#define BENCHMARK_QUAD_COUNT (BENCHMARK_QUAD_ROWS * BENCHMARK_QUAD_ROWS)
+
+void benchmark_create_quads(game_state* state) {
+    state->benchmark_quads = kallocate(sizeof(render_instance_data) * BENCHMARK_QUAD_COUNT, MEMORY_TAG_GAME);
+    f32 spacing = 0.2f;
+    f32 half_extent = (BENCHMARK_QUAD_ROWS - 1) * spacing * 0.5f;
+    mat4 scale = mat4_scale((vec3){0.15f, 0.15f, 1.0f});
+    for (u32 row = 0; row < BENCHMARK_QUAD_ROWS; ++row) {
+        for (u32 col = 0; col < BENCHMARK_QUAD_ROWS; ++col) {
+            render_instance_data* quad = &state->benchmark_quads[row * BENCHMARK_QUAD_ROWS + col];
+            kzero_memory(quad, sizeof(render_instance_data));
+            vec3 position = {col * spacing - half_extent, row * spacing - half_extent, 0};
+            quad->model = mat4_mul(scale, mat4_translation(position));
+            quad->material_index = 0;
+        }
+    }
+}
+
+void benchmark_destroy_quads(game_state* state) {
+    if (state->benchmark_quads) {
+        kfree(state->benchmark_quads, sizeof(render_instance_data) * BENCHMARK_QUAD_COUNT, MEMORY_TAG_GAME);
+        state->benchmark_quads = 0;
+    }
+}
+
+void benchmark_update(game_state* state, f32 delta_time) {
+    if (input_is_key_up('B') && input_was_key_down('B')) {
+        state->benchmark = (state->benchmark + 1) % BENCHMARK_MODE_COUNT;
+        state->benchmark_time = 0;
+        state->benchmark_frames = 0;
+        if (state->benchmark == BENCHMARK_MODE_OFF) {
+            KDEBUG("Benchmark off");
+        } else {
+            KDEBUG("Benchmark: %u quads, %s", BENCHMARK_QUAD_COUNT, state->benchmark == BENCHMARK_MODE_BATCHED ? "batched" : "unbatched");
+        }
+    }
+
+    if (state->benchmark == BENCHMARK_MODE_OFF) {
+        return;
+    }
+
+    renderer_submit_quads(BENCHMARK_QUAD_COUNT, state->benchmark_quads, state->benchmark == BENCHMARK_MODE_BATCHED);
+
+    state->benchmark_time += delta_time;
+    state->benchmark_frames++;
+    if (state->benchmark_time >= 1.0) {
+        KDEBUG("%s: %.3f ms/frame over %u frames",
+               state->benchmark == BENCHMARK_MODE_BATCHED ? "Batched" : "Unbatched",
+               (state->benchmark_time * 1000.0) / state->benchmark_frames,
+               state->benchmark_frames);
+        state->benchmark_time = 0;
+        state->benchmark_frames = 0;
+    }
+}
+
 b8 game_initialize(game* game_inst) {
     KDEBUG("game_initialize() called");
 
@@ -57,9 +114,17 @@ b8 game_initialize(game* game_inst) {
     state->view = mat4_inverse(state->view);
     state->camera_view_dirty = true;
 
+    state->benchmark = BENCHMARK_MODE_OFF;
+    benchmark_create_quads(state);
+
     return true;
 }
 
+void game_shutdown(game* game_inst) {
+    KDEBUG("game_shutdown() called");
+    benchmark_destroy_quads((game_state*)game_inst->state);
+}
+
 b8 game_update(game* game_inst, f32 delta_time) {
     static u64 alloc_count = 0;
     u64 prev_alloc_count = alloc_count;
@@ -67,7 +132,12 @@ b8 game_update(game* game_inst, f32 delta_time) {
     b8 key_up = input_is_key_up('M');
     b8 key_down = input_was_button_down('M');
     if (input_is_key_up('M') && input_was_key_down('M')) {
+        memory_frame_stats frame_stats = get_memory_frame_stats();
         KDEBUG("Allocations: %llu (%llu this frame)", alloc_count, alloc_count - prev_alloc_count);
+        KDEBUG("Last frame: %llu allocations (%llu bytes), %llu frees (%llu bytes)", frame_stats.alloc_count, frame_stats.allocated, frame_stats.free_count, frame_stats.freed);
+#if KMEMORY_TRACKING
+        memory_tracking_dump_top_sites(5);
+#endif
     }
 
     if (input_is_key_up('T') && input_was_key_down('T')) {
@@ -76,8 +146,24 @@ b8 game_update(game* game_inst, f32 delta_time) {
         event_fire(EVENT_CODE_DEBUG0, game_inst, context);
     }
 
+    if (input_is_key_up('P') && input_was_key_down('P')) {
+        renderer_config config = renderer_get_config();
+        renderer_present_mode next = (config.present_mode + 1) % (RENDERER_PRESENT_MODE_IMMEDIATE + 1);
+        KDEBUG("Switching present mode to %u", next);
+        renderer_set_present_mode(next);
+    }
+
+    if (input_is_key_up('F') && input_was_key_down('F')) {
+        renderer_config config = renderer_get_config();
+        u8 next = config.frames_in_flight % RENDERER_MAX_FRAMES_IN_FLIGHT + 1;
+        KDEBUG("Switching to %u frames in flight", next);
+        renderer_set_frames_in_flight(next);
+    }
+
     game_state* state = (game_state*)game_inst->state;
 
+    benchmark_update(state, delta_time);
+
     // HACK: Temporary controls for camera
     if (input_is_key_down(KEY_UP)) {
         camera_pitch(state, 10000.0f * delta_time);
@@ -3,6 +3,16 @@
 #include <defines.h>
 #include <game_types.h>
 #include <math/math_types.h>
+#include <renderer/renderer_types.inl>
+
+typedef enum benchmark_mode {
+    BENCHMARK_MODE_OFF,
+    // All quads in one instanced draw.
+    BENCHMARK_MODE_BATCHED,
+    // One draw per quad, for comparison.
+    BENCHMARK_MODE_UNBATCHED,
+    BENCHMARK_MODE_COUNT
+} benchmark_mode;
 
 typedef struct game_state {
     f32 delta_time;
@@ -10,6 +20,11 @@ typedef struct game_state {
     vec3 camera_position;
     vec3 camera_euler;
     b8 camera_view_dirty;
+
+    benchmark_mode benchmark;
+    render_instance_data* benchmark_quads;
+    f64 benchmark_time;
+    u32 benchmark_frames;
 } game_state;
 
 b8 game_initialize(game* game_inst);
@@ -19,3 +34,5 @@ b8 game_update(game* game_inst, f32 delta_time);
 b8 game_render(game* game_inst, f32 delta_time);
 
 void game_on_resize(game* game_inst, u32 width, u32 height);
+
+void game_shutdown(game* game_inst);
@@ -0,0 +1,155 @@
+#include "threading_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/katomic.h>
+#include <core/kcondvar.h>
+#include <core/kmutex.h>
+#include <core/ksemaphore.h>
+#include <core/kthread.h>
+#include <platform/platform.h>
+
+#define TEST_THREAD_COUNT 4
+#define TEST_INCREMENTS 100000
+
+typedef struct counter_state {
+    kmutex mutex;
+    u64 locked_count;
+    katomic_u64 atomic_count;
+} counter_state;
+
+typedef struct signal_state {
+    kmutex mutex;
+    kcondvar condvar;
+    ksemaphore semaphore;
+    b8 ready;
+} signal_state;
+
+static u32 return_param(void* params) {
+    return (u32)(u64)params * 2;
+}
+
+static u32 increment_counters(void* params) {
+    counter_state* state = params;
+    for (u32 i = 0; i < TEST_INCREMENTS; ++i) {
+        kmutex_lock(&state->mutex);
+        state->locked_count++;
+        kmutex_unlock(&state->mutex);
+        katomic_fetch_add(&state->atomic_count, 1, KATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+static u32 signal_semaphore(void* params) {
+    signal_state* state = params;
+    for (u32 i = 0; i < TEST_INCREMENTS; ++i) {
+        ksemaphore_signal(&state->semaphore, 1);
+    }
+    return 0;
+}
+
+static u32 signal_condvar(void* params) {
+    signal_state* state = params;
+    kmutex_lock(&state->mutex);
+    state->ready = true;
+    kcondvar_signal(&state->condvar);
+    kmutex_unlock(&state->mutex);
+    return 0;
+}
+
+u8 threads_return_results() {
+    expect_to_be_true((platform_get_processor_count() >= 1));
+
+    kthread threads[TEST_THREAD_COUNT];
+    for (u64 i = 0; i < TEST_THREAD_COUNT; ++i) {
+        expect_to_be_true(kthread_create(return_param, (void*)i, &threads[i]));
+    }
+
+    for (u32 i = 0; i < TEST_THREAD_COUNT; ++i) {
+        u32 result = 0;
+        expect_to_be_true(kthread_join(&threads[i], &result));
+        expect_should_be(i * 2, result);
+        expect_should_be(0, threads[i].internal_data);
+    }
+    return true;
+}
+
+u8 mutex_and_atomics_count_every_increment() {
+    counter_state state = {};
+    expect_to_be_true(kmutex_create(&state.mutex));
+    katomic_init(&state.atomic_count, 0);
+
+    kthread threads[TEST_THREAD_COUNT];
+    for (u32 i = 0; i < TEST_THREAD_COUNT; ++i) {
+        expect_to_be_true(kthread_create(increment_counters, &state, &threads[i]));
+    }
+    for (u32 i = 0; i < TEST_THREAD_COUNT; ++i) {
+        expect_to_be_true(kthread_join(&threads[i], 0));
+    }
+
+    expect_should_be(TEST_THREAD_COUNT * TEST_INCREMENTS, state.locked_count);
+    expect_should_be(TEST_THREAD_COUNT * TEST_INCREMENTS, katomic_load(&state.atomic_count, KATOMIC_RELAXED));
+
+    // Held by this thread, so a second attempt fails without blocking.
+    expect_to_be_true(kmutex_try_lock(&state.mutex));
+    expect_to_be_false(kmutex_try_lock(&state.mutex));
+    kmutex_unlock(&state.mutex);
+
+    kmutex_destroy(&state.mutex);
+    expect_should_be(0, state.mutex.internal_data);
+    return true;
+}
+
+u8 semaphore_counts_signals() {
+    signal_state state = {};
+    expect_to_be_true(ksemaphore_create(0, &state.semaphore));
+    expect_to_be_false(ksemaphore_wait_timeout(&state.semaphore, 10));
+
+    kthread thread;
+    expect_to_be_true(kthread_create(signal_semaphore, &state, &thread));
+    for (u32 i = 0; i < TEST_INCREMENTS; ++i) {
+        ksemaphore_wait(&state.semaphore);
+    }
+    expect_to_be_true(kthread_join(&thread, 0));
+
+    // Every signal was consumed.
+    expect_to_be_false(ksemaphore_wait_timeout(&state.semaphore, 0));
+    ksemaphore_signal(&state.semaphore, 2);
+    expect_to_be_true(ksemaphore_wait_timeout(&state.semaphore, 0));
+    expect_to_be_true(ksemaphore_wait_timeout(&state.semaphore, 0));
+
+    ksemaphore_destroy(&state.semaphore);
+    return true;
+}
+
+u8 condvar_wakes_waiter() {
+    signal_state state = {};
+    expect_to_be_true(kmutex_create(&state.mutex));
+    expect_to_be_true(kcondvar_create(&state.condvar));
+
+    kmutex_lock(&state.mutex);
+    expect_to_be_false(kcondvar_wait_timeout(&state.condvar, &state.mutex, 10));
+
+    // The thread blocks on the mutex until the wait below releases it, so it's still alive to be named.
+    kthread thread;
+    expect_to_be_true(kthread_create(signal_condvar, &state, &thread));
+    expect_to_be_true(kthread_set_name(&thread, "kohi test worker thread"));
+    while (!state.ready) {
+        kcondvar_wait(&state.condvar, &state.mutex);
+    }
+    kmutex_unlock(&state.mutex);
+    expect_to_be_true(kthread_join(&thread, 0));
+
+    kcondvar_destroy(&state.condvar);
+    kmutex_destroy(&state.mutex);
+    return true;
+}
+
+void threading_register_tests() {
+    test_manager_register_test(threads_return_results, "Threads run and hand back their results when joined");
+    test_manager_register_test(mutex_and_atomics_count_every_increment, "Mutexes and atomics don't lose increments across threads");
+    test_manager_register_test(semaphore_counts_signals, "Semaphore wakes once per signal and times out when empty");
+    test_manager_register_test(condvar_wakes_waiter, "Condition variable wakes a waiting thread");
+}
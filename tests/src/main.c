@@ -1,4 +1,12 @@
+#include "core/threading_tests.h"
+#include "memory/arena_allocator_tests.h"
+#include "memory/dynamic_allocator_tests.h"
+#include "memory/frame_allocator_tests.h"
+#include "memory/kmemory_tests.h"
 #include "memory/linear_allocator_tests.h"
+#include "memory/pool_allocator_tests.h"
+#include "systems/job_system_tests.h"
+#include "systems/task_graph_tests.h"
 #include "test_manager.h"
 #include <core/logger.h>
 
@@ -8,6 +16,14 @@ int main() {
 
     // TODO: add test registrations here.
     linear_allocator_register_tests();
+    kmemory_register_tests();
+    pool_allocator_register_tests();
+    dynamic_allocator_register_tests();
+    frame_allocator_register_tests();
+    arena_allocator_register_tests();
+    threading_register_tests();
+    job_system_register_tests();
+    task_graph_register_tests();
 
     KDEBUG("Starting tests...");
 
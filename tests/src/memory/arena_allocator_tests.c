@@ -0,0 +1,127 @@
+#include "arena_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <memory/arena_allocator.h>
+
+#define TEST_RESERVE_SIZE (256 * 1024 * 1024)
+
+u8 arena_allocator_should_create_and_destroy() {
+    arena_allocator arena;
+    expect_to_be_true(arena_allocator_create(TEST_RESERVE_SIZE, false, &arena));
+
+    expect_should_not_be(0, arena.memory);
+    expect_should_be(TEST_RESERVE_SIZE, arena.reserved_size);
+    // Nothing is committed until it is needed.
+    expect_should_be(0, arena.committed_size);
+
+    arena_allocator_destroy(&arena);
+    expect_should_be(0, arena.memory);
+
+    return true;
+}
+
+u8 arena_allocator_commits_lazily() {
+    arena_allocator arena;
+    arena_allocator_create(TEST_RESERVE_SIZE, false, &arena);
+
+    u8* first = arena_allocator_allocate(&arena, 100);
+    expect_should_not_be(0, first);
+    expect_should_be(arena.commit_granularity, arena.committed_size);
+    expect_should_be(0, first[0]);
+    expect_should_be(0, first[99]);
+
+    // Crossing the committed size commits more without moving anything.
+    first[0] = 42;
+    u64 large_size = arena.commit_granularity * 3;
+    u8* second = arena_allocator_allocate(&arena, large_size);
+    expect_should_be(first + 100, second);
+    expect_should_be(0, second[large_size - 1]);
+    expect_to_be_true((arena.committed_size >= 100 + large_size));
+    expect_should_be(42, first[0]);
+
+    arena_allocator_destroy(&arena);
+    return true;
+}
+
+u8 arena_allocator_aligned_and_markers() {
+    arena_allocator arena;
+    arena_allocator_create(TEST_RESERVE_SIZE, false, &arena);
+
+    arena_allocator_allocate(&arena, 3);
+    u8* aligned = arena_allocator_allocate_aligned(&arena, 16, 256);
+    expect_should_not_be(0, aligned);
+    expect_should_be(0, (u64)aligned % 256);
+
+    u64 marker = arena_allocator_get_marker(&arena);
+    u8* scoped = arena_allocator_allocate(&arena, 1024);
+    arena_allocator_rewind_to_marker(&arena, marker);
+    expect_should_be(marker, arena.allocated);
+    expect_should_be(scoped, arena_allocator_allocate(&arena, 8));
+
+    arena_allocator_destroy(&arena);
+    return true;
+}
+
+u8 arena_allocator_free_all_decommits() {
+    arena_allocator arena;
+    arena_allocator_create(TEST_RESERVE_SIZE, false, &arena);
+
+    u8* block = arena_allocator_allocate(&arena, 4096);
+    block[0] = 0xCD;
+    arena_allocator_free_all(&arena);
+    expect_should_be(0, arena.allocated);
+    expect_should_be(0, arena.committed_size);
+
+    // Recommitted memory comes back zeroed.
+    block = arena_allocator_allocate(&arena, 4096);
+    expect_should_be(0, block[0]);
+
+    arena_allocator_destroy(&arena);
+    return true;
+}
+
+u8 arena_allocator_fails_past_reservation() {
+    arena_allocator arena;
+    arena_allocator_create(1024 * 1024, false, &arena);
+
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(0, arena_allocator_allocate(&arena, arena.reserved_size + 1));
+    expect_should_be(0, arena.allocated);
+
+    expect_should_not_be(0, arena_allocator_allocate(&arena, arena.reserved_size));
+
+    arena_allocator_destroy(&arena);
+    return true;
+}
+
+u8 arena_allocator_large_pages() {
+    arena_allocator arena;
+    if (!arena_allocator_create(TEST_RESERVE_SIZE, true, &arena)) {
+        return BYPASS;
+    }
+    if (!arena.large_pages) {
+        // Not supported on this platform.
+        arena_allocator_destroy(&arena);
+        return BYPASS;
+    }
+
+    u8* block = arena_allocator_allocate(&arena, 100);
+    expect_should_not_be(0, block);
+    expect_should_be(0, (u64)arena.memory % arena.commit_granularity);
+    block[99] = 1;
+
+    arena_allocator_destroy(&arena);
+    return true;
+}
+
+void arena_allocator_register_tests() {
+    test_manager_register_test(arena_allocator_should_create_and_destroy, "Arena allocator should create and destroy");
+    test_manager_register_test(arena_allocator_commits_lazily, "Arena allocator commits pages as it grows");
+    test_manager_register_test(arena_allocator_aligned_and_markers, "Arena allocator aligned allocations and markers");
+    test_manager_register_test(arena_allocator_free_all_decommits, "Arena allocator free_all decommits pages");
+    test_manager_register_test(arena_allocator_fails_past_reservation, "Arena allocator fails past its reservation");
+    test_manager_register_test(arena_allocator_large_pages, "Arena allocator with large pages");
+}
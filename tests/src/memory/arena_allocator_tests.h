@@ -0,0 +1,3 @@
+#pragma once
+
+void arena_allocator_register_tests();
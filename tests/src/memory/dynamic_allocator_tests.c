@@ -0,0 +1,171 @@
+#include "dynamic_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+#include "../test_fixtures.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <memory/dynamic_allocator.h>
+
+#define TEST_ALLOCATOR_SIZE (64 * 1024)
+
+u8 dynamic_allocator_should_create_and_destroy() {
+    u64 memory_requirement = 0;
+    dynamic_allocator alloc;
+    void* memory = create_dynamic_allocator(TEST_ALLOCATOR_SIZE, &memory_requirement, &alloc);
+
+    expect_should_not_be(0, alloc.memory);
+    expect_should_be(TEST_ALLOCATOR_SIZE, dynamic_allocator_total_space(&alloc));
+    expect_should_be(TEST_ALLOCATOR_SIZE, dynamic_allocator_free_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+    expect_should_be(0, alloc.memory);
+
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 dynamic_allocator_single_allocation_and_free() {
+    u64 memory_requirement = 0;
+    dynamic_allocator alloc;
+    void* memory = create_dynamic_allocator(TEST_ALLOCATOR_SIZE, &memory_requirement, &alloc);
+
+    void* block = dynamic_allocator_allocate(&alloc, 100);
+    expect_should_not_be(0, block);
+    expect_should_be(0, (u64)block % 16);
+    expect_to_be_true(dynamic_allocator_owns(&alloc, block));
+    expect_to_be_true((dynamic_allocator_free_space(&alloc) < TEST_ALLOCATOR_SIZE));
+
+    expect_to_be_true(dynamic_allocator_free(&alloc, block));
+    // Coalescing must leave a single block spanning everything again.
+    expect_should_be(TEST_ALLOCATOR_SIZE, dynamic_allocator_free_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 dynamic_allocator_coalesces_in_any_order() {
+    u64 memory_requirement = 0;
+    dynamic_allocator alloc;
+    void* memory = create_dynamic_allocator(TEST_ALLOCATOR_SIZE, &memory_requirement, &alloc);
+
+    void* blocks[5];
+    u64 sizes[5] = {64, 1000, 16, 4000, 300};
+    for (u32 i = 0; i < 5; i++) {
+        blocks[i] = dynamic_allocator_allocate(&alloc, sizes[i]);
+        expect_should_not_be(0, blocks[i]);
+    }
+
+    // Free the middle first, then either side, then the ends.
+    u32 order[5] = {2, 1, 3, 0, 4};
+    for (u32 i = 0; i < 5; i++) {
+        expect_to_be_true(dynamic_allocator_free(&alloc, blocks[order[i]]));
+    }
+    expect_should_be(TEST_ALLOCATOR_SIZE, dynamic_allocator_free_space(&alloc));
+
+    // The whole space must be available as a single block.
+    void* all = dynamic_allocator_allocate(&alloc, TEST_ALLOCATOR_SIZE);
+    expect_should_not_be(0, all);
+    dynamic_allocator_free(&alloc, all);
+
+    dynamic_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 dynamic_allocator_fails_when_exhausted() {
+    u64 memory_requirement = 0;
+    dynamic_allocator alloc;
+    void* memory = create_dynamic_allocator(TEST_ALLOCATOR_SIZE, &memory_requirement, &alloc);
+
+    void* block = dynamic_allocator_allocate(&alloc, TEST_ALLOCATOR_SIZE);
+    expect_should_not_be(0, block);
+    expect_should_be(0, dynamic_allocator_free_space(&alloc));
+
+    KDEBUG("Note: The following errors are intentionally caused by this test.");
+    expect_should_be(0, dynamic_allocator_allocate(&alloc, 16));
+
+    // Double frees and foreign blocks are rejected.
+    expect_to_be_true(dynamic_allocator_free(&alloc, block));
+    expect_to_be_false(dynamic_allocator_free(&alloc, block));
+    u64 foreign = 0;
+    expect_to_be_false(dynamic_allocator_free(&alloc, &foreign));
+
+    dynamic_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 dynamic_allocator_aligned_allocations() {
+    u64 memory_requirement = 0;
+    dynamic_allocator alloc;
+    void* memory = create_dynamic_allocator(TEST_ALLOCATOR_SIZE, &memory_requirement, &alloc);
+
+    u16 alignments[] = {16, 32, 64, 256, 4096};
+    void* blocks[5];
+    for (u32 i = 0; i < 5; i++) {
+        blocks[i] = dynamic_allocator_allocate_aligned(&alloc, 24, alignments[i]);
+        expect_should_not_be(0, blocks[i]);
+        expect_should_be(0, (u64)blocks[i] % alignments[i]);
+    }
+    for (u32 i = 0; i < 5; i++) {
+        expect_to_be_true(dynamic_allocator_free(&alloc, blocks[i]));
+    }
+    expect_should_be(TEST_ALLOCATOR_SIZE, dynamic_allocator_free_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 dynamic_allocator_random_churn() {
+    u64 memory_requirement = 0;
+    dynamic_allocator alloc;
+    void* memory = create_dynamic_allocator(TEST_ALLOCATOR_SIZE * 16, &memory_requirement, &alloc);
+
+#define CHURN_SLOTS 64
+    u8* blocks[CHURN_SLOTS] = {};
+    u64 sizes[CHURN_SLOTS] = {};
+    // Simple LCG so the sequence is repeatable.
+    u32 seed = 12345;
+    for (u32 i = 0; i < 5000; i++) {
+        seed = seed * 1103515245 + 12345;
+        u32 slot = (seed >> 16) % CHURN_SLOTS;
+        if (blocks[slot]) {
+            // Verify nothing else has written over this block.
+            for (u64 j = 0; j < sizes[slot]; j++) {
+                expect_should_be(slot, blocks[slot][j]);
+            }
+            expect_to_be_true(dynamic_allocator_free(&alloc, blocks[slot]));
+            blocks[slot] = 0;
+        } else {
+            seed = seed * 1103515245 + 12345;
+            sizes[slot] = 1 + (seed >> 16) % 2048;
+            blocks[slot] = (seed & 1) ? dynamic_allocator_allocate(&alloc, sizes[slot]) : dynamic_allocator_allocate_aligned(&alloc, sizes[slot], 128);
+            expect_should_not_be(0, blocks[slot]);
+            kset_memory(blocks[slot], slot, sizes[slot]);
+        }
+    }
+
+    for (u32 i = 0; i < CHURN_SLOTS; i++) {
+        if (blocks[i]) {
+            dynamic_allocator_free(&alloc, blocks[i]);
+        }
+    }
+    expect_should_be(TEST_ALLOCATOR_SIZE * 16, dynamic_allocator_free_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+    kfree(memory, memory_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+void dynamic_allocator_register_tests() {
+    test_manager_register_test(dynamic_allocator_should_create_and_destroy, "Dynamic allocator should create and destroy");
+    test_manager_register_test(dynamic_allocator_single_allocation_and_free, "Dynamic allocator single allocation and free");
+    test_manager_register_test(dynamic_allocator_coalesces_in_any_order, "Dynamic allocator coalesces freed neighbours");
+    test_manager_register_test(dynamic_allocator_fails_when_exhausted, "Dynamic allocator fails when exhausted");
+    test_manager_register_test(dynamic_allocator_aligned_allocations, "Dynamic allocator aligned allocations");
+    test_manager_register_test(dynamic_allocator_random_churn, "Dynamic allocator survives random churn");
+}
@@ -0,0 +1,87 @@
+#include "frame_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+#include "../test_fixtures.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <memory/frame_allocator.h>
+
+#define TEST_FRAME_SIZE 1024
+
+u8 frame_allocator_allocates_within_frame() {
+    u64 memory_requirement = 0;
+    void* state = initialize_frame_allocator(TEST_FRAME_SIZE, &memory_requirement);
+
+    u8* first = frame_alloc(64);
+    u8* second = frame_alloc(64);
+    expect_should_not_be(0, first);
+    expect_should_not_be(0, second);
+    expect_should_be(first + 64, second);
+    expect_should_be(128, frame_allocator_allocated());
+
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(0, frame_alloc(TEST_FRAME_SIZE));
+
+    shutdown_frame_allocator(state, memory_requirement);
+    return true;
+}
+
+u8 frame_allocator_data_survives_next_frame() {
+    u64 memory_requirement = 0;
+    void* state = initialize_frame_allocator(TEST_FRAME_SIZE, &memory_requirement);
+
+    // Frame N
+    u8* frame_n = frame_alloc(TEST_FRAME_SIZE);
+    expect_should_not_be(0, frame_n);
+    kset_memory(frame_n, 0xAB, TEST_FRAME_SIZE);
+    frame_allocator_end_frame();
+
+    // Frame N+1 fills its own memory without touching frame N's.
+    expect_should_be(0, frame_allocator_allocated());
+    u8* frame_n1 = frame_alloc(TEST_FRAME_SIZE);
+    expect_should_not_be(0, frame_n1);
+    expect_should_not_be(frame_n, frame_n1);
+    kset_memory(frame_n1, 0xCD, TEST_FRAME_SIZE);
+    for (u32 i = 0; i < TEST_FRAME_SIZE; ++i) {
+        expect_should_be(0xAB, frame_n[i]);
+    }
+    frame_allocator_end_frame();
+
+    // Frame N+2 reuses frame N's memory, which is not cleared.
+    u8* frame_n2 = frame_alloc(16);
+    expect_should_be(frame_n, frame_n2);
+    expect_should_be(0xAB, frame_n2[0]);
+
+    shutdown_frame_allocator(state, memory_requirement);
+    return true;
+}
+
+u8 frame_allocator_allocations_are_aligned() {
+    u64 memory_requirement = 0;
+    frame_allocator_initialize(&memory_requirement, 0, TEST_FRAME_SIZE);
+    // Offset the state so the frames can't line up by accident.
+    u8* block = kallocate(memory_requirement + 8, MEMORY_TAG_APPLICATION);
+    frame_allocator_initialize(&memory_requirement, block + 8, TEST_FRAME_SIZE);
+
+    for (u32 frame = 0; frame < 2; ++frame) {
+        u64 sizes[] = {1, 3, 17, 8, 33};
+        for (u32 i = 0; i < 5; ++i) {
+            void* memory = frame_alloc(sizes[i]);
+            expect_should_not_be(0, memory);
+            expect_should_be(0, (u64)memory % 16);
+        }
+        frame_allocator_end_frame();
+    }
+
+    frame_allocator_shutdown(block + 8);
+    kfree(block, memory_requirement + 8, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+void frame_allocator_register_tests() {
+    test_manager_register_test(frame_allocator_allocates_within_frame, "Frame allocator allocates within a frame");
+    test_manager_register_test(frame_allocator_data_survives_next_frame, "Frame allocator keeps data until the next frame ends");
+    test_manager_register_test(frame_allocator_allocations_are_aligned, "Frame allocator returns 16 byte aligned memory");
+}
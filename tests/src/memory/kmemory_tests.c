@@ -0,0 +1,349 @@
+#include "kmemory_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/kmemory.h>
+#include <core/kthread.h>
+
+#define TEST_BLOCK_SIZE 256
+#define TEST_THREAD_COUNT 4
+#define TEST_THREAD_ITERATIONS 2000
+#define TEST_THREAD_SLOTS 8
+
+typedef struct allocating_thread {
+    u8 pattern;
+    u32 corrupted_blocks;
+} allocating_thread;
+
+// Keeps a handful of blocks of varying sizes live, filled with the thread's own pattern, and
+// replaces them one at a time. Another thread handed the same block would overwrite the pattern.
+static u32 allocate_and_free(void* params) {
+    allocating_thread* thread = params;
+    u8* blocks[TEST_THREAD_SLOTS] = {};
+    u64 sizes[TEST_THREAD_SLOTS] = {};
+    for (u32 i = 0; i < TEST_THREAD_ITERATIONS + TEST_THREAD_SLOTS; ++i) {
+        u32 slot = i % TEST_THREAD_SLOTS;
+        if (blocks[slot]) {
+            for (u64 b = 0; b < sizes[slot]; ++b) {
+                if (blocks[slot][b] != thread->pattern) {
+                    thread->corrupted_blocks++;
+                    break;
+                }
+            }
+            kfree(blocks[slot], sizes[slot], MEMORY_TAG_ARRAY);
+            blocks[slot] = 0;
+        }
+        if (i < TEST_THREAD_ITERATIONS) {
+            sizes[slot] = 16 + (i * 37) % 1024;
+            blocks[slot] = kallocate(sizes[slot], MEMORY_TAG_ARRAY);
+            kset_memory(blocks[slot], thread->pattern, sizes[slot]);
+        }
+    }
+    return 0;
+}
+
+u8 kmemory_aligned_allocation_respects_alignment() {
+    u16 alignments[] = {16, 64, 256, 4096};
+    u32 alignment_count = sizeof(alignments) / sizeof(u16);
+
+    for (u32 i = 0; i < alignment_count; i++) {
+        void* block = kallocate_aligned(TEST_BLOCK_SIZE, alignments[i], MEMORY_TAG_ARRAY);
+        expect_should_not_be(0, block);
+        expect_should_be(0, (u64)block % alignments[i]);
+        kfree_aligned(block, TEST_BLOCK_SIZE, alignments[i], MEMORY_TAG_ARRAY);
+    }
+
+    return true;
+}
+
+u8 kmemory_aligned_allocation_is_zeroed() {
+    u8* block = kallocate_aligned(TEST_BLOCK_SIZE, 64, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, block);
+    for (u32 i = 0; i < TEST_BLOCK_SIZE; i++) {
+        expect_should_be(0, block[i]);
+    }
+    kfree_aligned(block, TEST_BLOCK_SIZE, 64, MEMORY_TAG_ARRAY);
+
+    return true;
+}
+
+u8 kmemory_aligned_allocation_rejects_non_power_of_two() {
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    void* block = kallocate_aligned(TEST_BLOCK_SIZE, 48, MEMORY_TAG_ARRAY);
+    expect_should_be(0, block);
+
+    return true;
+}
+
+u8 kmemory_uninit_allocation_is_not_zeroed() {
+    // Dirty a block, release it and ask for the same size again. Most allocators hand the same
+    // block straight back, which lets us observe whether anything cleared it in between.
+    u8* dirty = kallocate_uninit(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, dirty);
+    kset_memory(dirty, 0xCD, TEST_BLOCK_SIZE);
+    kfree(dirty, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+
+    u8* block = kallocate_uninit(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, block);
+    if (block != dirty) {
+        kfree(block, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+        return BYPASS;
+    }
+
+    // The allocator may reuse the first few bytes for its own bookkeeping, but the rest of the
+    // pattern must survive.
+    u32 dirty_bytes = 0;
+    for (u32 i = 0; i < TEST_BLOCK_SIZE; i++) {
+        if (block[i] == 0xCD) {
+            dirty_bytes++;
+        }
+    }
+    kfree(block, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_to_be_true((dirty_bytes > TEST_BLOCK_SIZE / 2));
+
+    return true;
+}
+
+u8 kmemory_allocation_is_zeroed() {
+    u8* dirty = kallocate_uninit(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, dirty);
+    kset_memory(dirty, 0xCD, TEST_BLOCK_SIZE);
+    kfree(dirty, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+
+    u8* block = kallocate(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, block);
+    for (u32 i = 0; i < TEST_BLOCK_SIZE; i++) {
+        expect_should_be(0, block[i]);
+    }
+    kfree(block, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+
+    return true;
+}
+
+u8 kmemory_frame_stats_track_churn() {
+    u64 memory_requirement = 0;
+    memory_system_configuration config = {};
+    initialize_memory(&memory_requirement, 0, config);
+    void* state = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    initialize_memory(&memory_requirement, state, config);
+
+    // Start from a clean frame.
+    end_memory_frame();
+    u64 alloc_count = get_memory_alloc_count();
+
+    void* first = kallocate(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    void* second = kallocate(TEST_BLOCK_SIZE * 2, MEMORY_TAG_ARRAY);
+    kfree(first, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_should_be(alloc_count + 2, get_memory_alloc_count());
+
+    // Nothing is visible until the frame is ended.
+    memory_frame_stats stats = get_memory_frame_stats();
+    expect_should_be(0, stats.alloc_count);
+
+    end_memory_frame();
+    stats = get_memory_frame_stats();
+    expect_should_be(2, stats.alloc_count);
+    expect_should_be(TEST_BLOCK_SIZE * 3, stats.allocated);
+    expect_should_be(1, stats.free_count);
+    expect_should_be(TEST_BLOCK_SIZE, stats.freed);
+
+    kfree(second, TEST_BLOCK_SIZE * 2, MEMORY_TAG_ARRAY);
+    end_memory_frame();
+    stats = get_memory_frame_stats();
+    expect_should_be(0, stats.alloc_count);
+    expect_should_be(1, stats.free_count);
+
+    shutdown_memory(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+
+    return true;
+}
+
+u8 kmemory_budget_serves_allocations() {
+    u64 memory_requirement = 0;
+    memory_system_configuration config = {};
+    config.total_alloc_size = 1024 * 1024;
+
+    // Made before the budget exists, so it must be released to the platform afterwards.
+    u8* early = kallocate(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+
+    initialize_memory(&memory_requirement, 0, config);
+    void* state = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(initialize_memory(&memory_requirement, state, config));
+
+    u8* first = kallocate(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    u8* second = kallocate_aligned(TEST_BLOCK_SIZE, 256, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, first);
+    expect_should_not_be(0, second);
+    expect_should_be(0, (u64)second % 256);
+
+    kfree(early, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+
+    // Freed blocks are handed straight back out of the budget.
+    kfree(first, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    u8* third = kallocate(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_should_be(first, third);
+
+    // Exceeding the budget falls back to the platform rather than failing.
+    u64 large_size = 2 * 1024 * 1024;
+    KDEBUG("Note: The following errors are intentionally caused by this test.");
+    u8* large = kallocate(large_size, MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, large);
+    kfree(large, large_size, MEMORY_TAG_ARRAY);
+
+    kfree(third, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    kfree_aligned(second, TEST_BLOCK_SIZE, 256, MEMORY_TAG_ARRAY);
+
+    shutdown_memory(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+
+    return true;
+}
+
+u8 kmemory_budget_is_thread_safe() {
+    u64 memory_requirement = 0;
+    memory_system_configuration config = {};
+    config.total_alloc_size = 4 * 1024 * 1024;
+    initialize_memory(&memory_requirement, 0, config);
+    void* state = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(initialize_memory(&memory_requirement, state, config));
+    u64 alloc_count = get_memory_alloc_count();
+
+    kthread threads[TEST_THREAD_COUNT];
+    allocating_thread params[TEST_THREAD_COUNT] = {};
+    for (u32 i = 0; i < TEST_THREAD_COUNT; ++i) {
+        params[i].pattern = (u8)(0xA0 + i);
+        expect_to_be_true(kthread_create(allocate_and_free, &params[i], &threads[i]));
+    }
+    for (u32 i = 0; i < TEST_THREAD_COUNT; ++i) {
+        expect_to_be_true(kthread_join(&threads[i], 0));
+    }
+
+    for (u32 i = 0; i < TEST_THREAD_COUNT; ++i) {
+        expect_should_be(0, params[i].corrupted_blocks);
+    }
+    expect_should_be(alloc_count + TEST_THREAD_COUNT * TEST_THREAD_ITERATIONS, get_memory_alloc_count());
+
+    shutdown_memory(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+
+    return true;
+}
+
+u8 kmemory_tracking_catches_double_free() {
+#if KMEMORY_TRACKING
+    u64 errors = memory_tracking_error_count();
+    u64 live = memory_tracking_live_count();
+
+    void* block = kallocate(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_should_be(live + 1, memory_tracking_live_count());
+    kfree(block, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_should_be(live, memory_tracking_live_count());
+
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    kfree(block, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_should_be(errors + 1, memory_tracking_error_count());
+    expect_should_be(live, memory_tracking_live_count());
+
+    return true;
+#else
+    return BYPASS;
+#endif
+}
+
+u8 kmemory_tracking_catches_size_mismatch() {
+#if KMEMORY_TRACKING
+    u64 errors = memory_tracking_error_count();
+    u64 live = memory_tracking_live_count();
+
+    void* block = kallocate(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    kfree(block, TEST_BLOCK_SIZE / 2, MEMORY_TAG_ARRAY);
+    expect_should_be(errors + 1, memory_tracking_error_count());
+    // The block is still released using the size it was allocated with.
+    expect_should_be(live, memory_tracking_live_count());
+
+    return true;
+#else
+    return BYPASS;
+#endif
+}
+
+u8 kmemory_tracking_is_thread_safe() {
+#if KMEMORY_TRACKING
+    u64 errors = memory_tracking_error_count();
+    u64 live = memory_tracking_live_count();
+
+    kthread threads[TEST_THREAD_COUNT];
+    allocating_thread params[TEST_THREAD_COUNT] = {};
+    for (u32 i = 0; i < TEST_THREAD_COUNT; ++i) {
+        params[i].pattern = (u8)(0xB0 + i);
+        expect_to_be_true(kthread_create(allocate_and_free, &params[i], &threads[i]));
+    }
+    // Also read while the threads are running. The counts are only checked once they've joined.
+    memory_tracking_live_count();
+    for (u32 i = 0; i < TEST_THREAD_COUNT; ++i) {
+        expect_to_be_true(kthread_join(&threads[i], 0));
+    }
+
+    for (u32 i = 0; i < TEST_THREAD_COUNT; ++i) {
+        expect_should_be(0, params[i].corrupted_blocks);
+    }
+    expect_should_be(errors, memory_tracking_error_count());
+    expect_should_be(live, memory_tracking_live_count());
+
+    return true;
+#else
+    return BYPASS;
+#endif
+}
+
+u8 kmemory_tracking_reports_leaks() {
+#if KMEMORY_TRACKING
+    // Allocations from before the memory system starts are not reported as its leaks.
+    void* early = kallocate(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+
+    u64 memory_requirement = 0;
+    memory_system_configuration config = {};
+    initialize_memory(&memory_requirement, 0, config);
+    void* state = kallocate(memory_requirement, MEMORY_TAG_APPLICATION);
+    initialize_memory(&memory_requirement, state, config);
+
+    expect_should_be(0, memory_tracking_report_leaks());
+
+    void* first = kallocate(TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    void* second = kallocate(TEST_BLOCK_SIZE * 2, MEMORY_TAG_STRING);
+    KDEBUG("Note: The following warnings are intentionally caused by this test.");
+    expect_should_be(2, memory_tracking_report_leaks());
+    memory_tracking_dump_top_sites(2);
+
+    kfree(first, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    kfree(second, TEST_BLOCK_SIZE * 2, MEMORY_TAG_STRING);
+    expect_should_be(0, memory_tracking_report_leaks());
+
+    shutdown_memory(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+    kfree(early, TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+
+    return true;
+#else
+    return BYPASS;
+#endif
+}
+
+void kmemory_register_tests() {
+    test_manager_register_test(kmemory_aligned_allocation_respects_alignment, "kallocate_aligned returns aligned blocks");
+    test_manager_register_test(kmemory_aligned_allocation_is_zeroed, "kallocate_aligned returns zeroed blocks");
+    test_manager_register_test(kmemory_aligned_allocation_rejects_non_power_of_two, "kallocate_aligned rejects non power of 2 alignment");
+    test_manager_register_test(kmemory_uninit_allocation_is_not_zeroed, "kallocate_uninit does not zero memory");
+    test_manager_register_test(kmemory_allocation_is_zeroed, "kallocate zeroes reused memory");
+    test_manager_register_test(kmemory_frame_stats_track_churn, "Memory frame stats track per-frame churn");
+    test_manager_register_test(kmemory_budget_serves_allocations, "Memory budget serves tagged allocations");
+    test_manager_register_test(kmemory_budget_is_thread_safe, "Memory budget serves allocations from several threads at once");
+    test_manager_register_test(kmemory_tracking_catches_double_free, "Memory tracking catches double frees");
+    test_manager_register_test(kmemory_tracking_catches_size_mismatch, "Memory tracking catches size mismatches");
+    test_manager_register_test(kmemory_tracking_is_thread_safe, "Memory tracking keeps its records with several threads allocating");
+    test_manager_register_test(kmemory_tracking_reports_leaks, "Memory tracking reports leaks");
+}
@@ -4,6 +4,7 @@
 
 #include <defines.h>
 
+#include <core/kmemory.h>
 #include <memory/linear_allocator.h>
 
 u8 linear_allocator_should_create_and_destroy() {
@@ -108,10 +109,120 @@ u8 linear_allocator_multi_allocation_all_space_then_free() {
     return true;
 }
 
+u8 linear_allocator_aligned_allocation_pads() {
+    linear_allocator alloc;
+    linear_allocator_create(1024, 0, &alloc);
+
+    // Knock the offset off of any useful alignment.
+    u8* first = linear_allocator_allocate(&alloc, 3);
+    expect_should_not_be(0, first);
+
+    u8* aligned = linear_allocator_allocate_aligned(&alloc, 16, 64);
+    expect_should_not_be(0, aligned);
+    expect_should_be(0, (u64)aligned % 64);
+    // The padding must be counted as allocated.
+    expect_should_be((u64)(aligned - (u8*)alloc.memory) + 16, alloc.allocated);
+
+    // An allocation that is already aligned gets no padding.
+    u64 before = alloc.allocated;
+    u8* next = linear_allocator_allocate_aligned(&alloc, 8, 16);
+    expect_should_be(aligned + 16, next);
+    expect_should_be(before + 8, alloc.allocated);
+
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(0, linear_allocator_allocate_aligned(&alloc, 16, 48));
+
+    linear_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 linear_allocator_aligned_allocation_padding_overflows() {
+    linear_allocator alloc;
+    linear_allocator_create(64, 0, &alloc);
+
+    linear_allocator_allocate(&alloc, 1);
+
+    // 63 bytes remain, but padding to 16 takes at least 15 of them.
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    void* block = linear_allocator_allocate_aligned(&alloc, 60, 16);
+    expect_should_be(0, block);
+    expect_should_be(1, alloc.allocated);
+
+    linear_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 linear_allocator_rewind_to_marker_frees_scope() {
+    linear_allocator alloc;
+    linear_allocator_create(1024, 0, &alloc);
+
+    linear_allocator_allocate(&alloc, 100);
+    u64 outer = linear_allocator_get_marker(&alloc);
+    expect_should_be(100, outer);
+
+    u8* outer_block = linear_allocator_allocate(&alloc, 200);
+    u64 inner = linear_allocator_get_marker(&alloc);
+    linear_allocator_allocate(&alloc, 300);
+    expect_should_be(600, alloc.allocated);
+
+    // Nested scopes unwind in reverse.
+    linear_allocator_rewind_to_marker(&alloc, inner);
+    expect_should_be(300, alloc.allocated);
+    linear_allocator_rewind_to_marker(&alloc, outer);
+    expect_should_be(100, alloc.allocated);
+
+    // The space is handed out again from the marker.
+    u8* reused = linear_allocator_allocate(&alloc, 200);
+    expect_should_be(outer_block, reused);
+
+    // Rewinding forward is rejected.
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    linear_allocator_rewind_to_marker(&alloc, 1000);
+    expect_should_be(300, alloc.allocated);
+
+    linear_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 linear_allocator_reset_and_free_all() {
+    linear_allocator alloc;
+    linear_allocator_create(256, 0, &alloc);
+
+    u8* block = linear_allocator_allocate(&alloc, 64);
+    kset_memory(block, 0xCD, 64);
+
+    // Reset leaves the old contents in place.
+    linear_allocator_reset(&alloc);
+    expect_should_be(0, alloc.allocated);
+    expect_should_be(64, alloc.high_water);
+    expect_should_be(0xCD, block[0]);
+    expect_should_be(0xCD, block[63]);
+
+    // free_all still clears everything handed out before the reset.
+    block = linear_allocator_allocate(&alloc, 16);
+    linear_allocator_free_all(&alloc);
+    expect_should_be(0, alloc.allocated);
+    expect_should_be(0, alloc.high_water);
+    for (u32 i = 0; i < 64; ++i) {
+        expect_should_be(0, block[i]);
+    }
+
+    linear_allocator_destroy(&alloc);
+
+    return true;
+}
+
 void linear_allocator_register_tests() {
     test_manager_register_test(linear_allocator_should_create_and_destroy, "Linear allocator should create and destroy");
     test_manager_register_test(linear_allocator_single_allocation_all_space, "Linear allocator single alloc for all space");
     test_manager_register_test(linear_allocator_multi_allocation_all_space, "Linear allocator multi alloc for all space");
     test_manager_register_test(linear_allocator_multi_allocation_over_allocate, "Linear allocator try over allocate");
     test_manager_register_test(linear_allocator_multi_allocation_all_space_then_free, "Linear allocator allocated should be 0 after free_all");
+    test_manager_register_test(linear_allocator_aligned_allocation_pads, "Linear allocator aligned allocation pads offset");
+    test_manager_register_test(linear_allocator_aligned_allocation_padding_overflows, "Linear allocator aligned allocation counts padding against space");
+    test_manager_register_test(linear_allocator_rewind_to_marker_frees_scope, "Linear allocator rewinds to markers");
+    test_manager_register_test(linear_allocator_reset_and_free_all, "Linear allocator free_all clears memory left by reset");
 }
@@ -0,0 +1,202 @@
+#include "pool_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <memory/pool_allocator.h>
+
+typedef struct test_element {
+    u64 a;
+    u64 b;
+    u32 c;
+} test_element;
+
+u8 pool_allocator_should_create_and_destroy() {
+    pool_allocator pool;
+    expect_to_be_true(pool_allocator_create(sizeof(test_element), 16, 0, false, MEMORY_TAG_ARRAY, &pool));
+
+    expect_should_not_be(0, pool.memory);
+    expect_should_be(24, pool.element_size);
+    expect_should_be(16, pool.capacity);
+    expect_should_be(0, pool.allocated_count);
+
+    pool_allocator_destroy(&pool);
+
+    expect_should_be(0, pool.memory);
+    expect_should_be(0, pool.capacity);
+
+    return true;
+}
+
+u8 pool_allocator_small_elements_fit_free_list() {
+    pool_allocator pool;
+    expect_to_be_true(pool_allocator_create(1, 4, 0, false, MEMORY_TAG_ARRAY, &pool));
+
+    // Every slot must be able to hold the free list pointer.
+    expect_should_be(sizeof(void*), pool.element_size);
+
+    pool_allocator_destroy(&pool);
+    return true;
+}
+
+u8 pool_allocator_allocate_all_then_fail() {
+    u64 max_allocs = 64;
+    pool_allocator pool;
+    pool_allocator_create(sizeof(test_element), max_allocs, 0, false, MEMORY_TAG_ARRAY, &pool);
+
+    for (u64 i = 0; i < max_allocs; i++) {
+        test_element* element = pool_allocator_allocate(&pool);
+        expect_should_not_be(0, element);
+        expect_should_be(0, (u64)element % 8);
+        expect_should_be(i + 1, pool.allocated_count);
+    }
+
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    void* element = pool_allocator_allocate(&pool);
+    expect_should_be(0, element);
+    expect_should_be(max_allocs, pool.allocated_count);
+
+    pool_allocator_destroy(&pool);
+    return true;
+}
+
+u8 pool_allocator_free_reuses_element() {
+    pool_allocator pool;
+    pool_allocator_create(sizeof(test_element), 8, 0, false, MEMORY_TAG_ARRAY, &pool);
+
+    test_element* first = pool_allocator_allocate(&pool);
+    test_element* second = pool_allocator_allocate(&pool);
+    expect_should_not_be(first, second);
+
+    pool_allocator_free(&pool, first);
+    expect_should_be(1, pool.allocated_count);
+
+    // The most recently freed element comes back first.
+    test_element* third = pool_allocator_allocate(&pool);
+    expect_should_be(first, third);
+
+    pool_allocator_destroy(&pool);
+    return true;
+}
+
+u8 pool_allocator_grows_when_full() {
+    u64 block_count = 4;
+    pool_allocator pool;
+    pool_allocator_create(sizeof(test_element), block_count, 0, true, MEMORY_TAG_ARRAY, &pool);
+
+    test_element* elements[16];
+    for (u64 i = 0; i < 16; i++) {
+        elements[i] = pool_allocator_allocate(&pool);
+        expect_should_not_be(0, elements[i]);
+        // Write through the element to make sure no two slots overlap.
+        elements[i]->a = i;
+        elements[i]->b = i;
+        elements[i]->c = (u32)i;
+    }
+    expect_should_be(16, pool.capacity);
+    expect_should_be(16, pool.allocated_count);
+    expect_should_not_be(0, pool.extra_blocks);
+
+    for (u64 i = 0; i < 16; i++) {
+        expect_should_be(i, elements[i]->a);
+        expect_should_be(i, elements[i]->b);
+    }
+
+    pool_allocator_destroy(&pool);
+    return true;
+}
+
+u8 pool_allocator_free_all_keeps_capacity() {
+    pool_allocator pool;
+    pool_allocator_create(sizeof(test_element), 4, 0, true, MEMORY_TAG_ARRAY, &pool);
+
+    for (u64 i = 0; i < 10; i++) {
+        pool_allocator_allocate(&pool);
+    }
+    expect_should_be(12, pool.capacity);
+
+    pool_allocator_free_all(&pool);
+    expect_should_be(0, pool.allocated_count);
+
+    // All 12 slots should be available again without growing.
+    for (u64 i = 0; i < 12; i++) {
+        expect_should_not_be(0, pool_allocator_allocate(&pool));
+    }
+    expect_should_be(12, pool.capacity);
+
+    pool_allocator_destroy(&pool);
+    return true;
+}
+
+u8 pool_allocator_uses_provided_memory() {
+    u64 requirement = pool_allocator_memory_requirement(sizeof(test_element), 8);
+    expect_should_be(24 * 8, requirement);
+    void* memory = kallocate(requirement, MEMORY_TAG_ARRAY);
+
+    pool_allocator pool;
+    pool_allocator_create(sizeof(test_element), 8, memory, false, MEMORY_TAG_ARRAY, &pool);
+    expect_should_be(memory, pool.memory);
+    expect_to_be_false(pool.owns_memory);
+
+    u8* element = pool_allocator_allocate(&pool);
+    expect_to_be_true((element >= (u8*)memory && element < (u8*)memory + requirement));
+
+    // Destroying the pool must leave the provided memory alone.
+    pool_allocator_destroy(&pool);
+    kfree(memory, requirement, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+#define BENCHMARK_ELEMENT_COUNT 10000
+#define BENCHMARK_ITERATIONS 100
+
+u8 pool_allocator_benchmark_against_kallocate() {
+    static void* elements[BENCHMARK_ELEMENT_COUNT];
+
+    pool_allocator pool;
+    pool_allocator_create(sizeof(test_element), BENCHMARK_ELEMENT_COUNT, 0, false, MEMORY_TAG_ARRAY, &pool);
+
+    clock pool_time;
+    clock_start(&pool_time);
+    for (u32 iteration = 0; iteration < BENCHMARK_ITERATIONS; iteration++) {
+        for (u32 i = 0; i < BENCHMARK_ELEMENT_COUNT; i++) {
+            elements[i] = pool_allocator_allocate(&pool);
+        }
+        for (u32 i = 0; i < BENCHMARK_ELEMENT_COUNT; i++) {
+            pool_allocator_free(&pool, elements[i]);
+        }
+    }
+    clock_update(&pool_time);
+    pool_allocator_destroy(&pool);
+
+    clock kallocate_time;
+    clock_start(&kallocate_time);
+    for (u32 iteration = 0; iteration < BENCHMARK_ITERATIONS; iteration++) {
+        for (u32 i = 0; i < BENCHMARK_ELEMENT_COUNT; i++) {
+            elements[i] = kallocate(sizeof(test_element), MEMORY_TAG_ARRAY);
+        }
+        for (u32 i = 0; i < BENCHMARK_ELEMENT_COUNT; i++) {
+            kfree(elements[i], sizeof(test_element), MEMORY_TAG_ARRAY);
+        }
+    }
+    clock_update(&kallocate_time);
+
+    KINFO("pool_allocator: %.6f sec, kallocate: %.6f sec for %d allocate/free pairs.",
+          pool_time.elapsed, kallocate_time.elapsed, BENCHMARK_ELEMENT_COUNT * BENCHMARK_ITERATIONS);
+
+    return true;
+}
+
+void pool_allocator_register_tests() {
+    test_manager_register_test(pool_allocator_should_create_and_destroy, "Pool allocator should create and destroy");
+    test_manager_register_test(pool_allocator_small_elements_fit_free_list, "Pool allocator rounds small elements up to pointer size");
+    test_manager_register_test(pool_allocator_allocate_all_then_fail, "Pool allocator fails when full and not growable");
+    test_manager_register_test(pool_allocator_free_reuses_element, "Pool allocator reuses freed elements");
+    test_manager_register_test(pool_allocator_grows_when_full, "Pool allocator grows when full");
+    test_manager_register_test(pool_allocator_free_all_keeps_capacity, "Pool allocator free_all keeps grown capacity");
+    test_manager_register_test(pool_allocator_uses_provided_memory, "Pool allocator uses provided memory");
+    test_manager_register_test(pool_allocator_benchmark_against_kallocate, "Pool allocator benchmark against kallocate");
+}
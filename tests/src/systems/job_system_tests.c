@@ -0,0 +1,256 @@
+#include "job_system_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+#include "../test_fixtures.h"
+
+#include <defines.h>
+
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <platform/platform.h>
+#include <systems/job_system.h>
+
+#define TEST_WORKER_COUNT 3
+#define TEST_JOB_COUNT 1000
+#define TEST_CHILD_COUNT 16
+#define TEST_ALLOCATING_JOB_COUNT 256
+#define TEST_ALLOCATIONS_PER_JOB 16
+
+#define BENCHMARK_JOB_COUNT 200000
+#define BENCHMARK_BATCH_SIZE 512
+#define BENCHMARK_LATENCY_SAMPLES 200
+
+typedef struct parent_params {
+    katomic_u32* total;
+} parent_params;
+
+typedef struct allocating_params {
+    u8 pattern;
+    katomic_u32* corrupted_blocks;
+} allocating_params;
+
+typedef struct latency_params {
+    f64 start_time;
+} latency_params;
+
+static void increment_job(void* params) {
+    katomic_fetch_add((katomic_u32*)params, 1, KATOMIC_RELAXED);
+}
+
+static void empty_job(void* params) {
+}
+
+static void record_start_job(void* params) {
+    ((latency_params*)params)->start_time = platform_get_absolute_time();
+}
+
+// Holds several blocks at once, as the driver does while recording, and checks none were handed
+// to another job in the meantime.
+static void allocating_job(void* params) {
+    allocating_params* job = params;
+    u8* blocks[TEST_ALLOCATIONS_PER_JOB];
+    for (u32 i = 0; i < TEST_ALLOCATIONS_PER_JOB; ++i) {
+        blocks[i] = kallocate_aligned(64 + i * 32, 16, MEMORY_TAG_JOB);
+        kset_memory(blocks[i], job->pattern, 64 + i * 32);
+    }
+    for (u32 i = 0; i < TEST_ALLOCATIONS_PER_JOB; ++i) {
+        for (u32 b = 0; b < 64 + i * 32; ++b) {
+            if (blocks[i][b] != job->pattern) {
+                katomic_fetch_add(job->corrupted_blocks, 1, KATOMIC_RELAXED);
+                break;
+            }
+        }
+        kfree_aligned(blocks[i], 64 + i * 32, 16, MEMORY_TAG_JOB);
+    }
+}
+
+// Fans out into children from inside a job and waits on them there.
+static void parent_job(void* params) {
+    parent_params* parent = params;
+    job_counter children = {};
+    job_info jobs[TEST_CHILD_COUNT];
+    for (u32 i = 0; i < TEST_CHILD_COUNT; ++i) {
+        jobs[i] = job_create(increment_job, parent->total, JOB_PRIORITY_NORMAL, &children);
+    }
+    job_system_submit(jobs, TEST_CHILD_COUNT);
+    job_system_wait(&children);
+}
+
+u8 job_system_runs_every_job() {
+    u64 memory_requirement = 0;
+    void* state = initialize_job_system(TEST_WORKER_COUNT, &memory_requirement);
+    expect_should_not_be(0, state);
+    expect_should_be(TEST_WORKER_COUNT + 1, job_system_thread_count());
+
+    katomic_u32 total;
+    katomic_init(&total, 0);
+    job_counter counter = {};
+    job_info jobs[TEST_JOB_COUNT];
+    for (u32 i = 0; i < TEST_JOB_COUNT; ++i) {
+        jobs[i] = job_create(increment_job, &total, (job_priority)(i % JOB_PRIORITY_COUNT), &counter);
+    }
+    job_system_submit(jobs, TEST_JOB_COUNT);
+    job_system_wait(&counter);
+
+    expect_should_be(TEST_JOB_COUNT, katomic_load(&total, KATOMIC_RELAXED));
+    expect_should_be(0, katomic_load(&counter.remaining, KATOMIC_RELAXED));
+
+    shutdown_job_system(state, memory_requirement);
+    return true;
+}
+
+u8 job_system_runs_nested_jobs() {
+    u64 memory_requirement = 0;
+    void* state = initialize_job_system(TEST_WORKER_COUNT, &memory_requirement);
+    expect_should_not_be(0, state);
+
+    katomic_u32 total;
+    katomic_init(&total, 0);
+    parent_params params = {&total};
+    job_counter counter = {};
+    job_info jobs[TEST_WORKER_COUNT * 2];
+    for (u32 i = 0; i < TEST_WORKER_COUNT * 2; ++i) {
+        jobs[i] = job_create(parent_job, &params, JOB_PRIORITY_HIGH, &counter);
+    }
+    job_system_submit(jobs, TEST_WORKER_COUNT * 2);
+    job_system_wait(&counter);
+
+    expect_should_be(TEST_WORKER_COUNT * 2 * TEST_CHILD_COUNT, katomic_load(&total, KATOMIC_RELAXED));
+
+    shutdown_job_system(state, memory_requirement);
+    return true;
+}
+
+// Jobs allocate through kmemory with a budget set, as on the engine's default configuration.
+u8 job_system_jobs_can_allocate() {
+    u64 memory_system_requirement = 0;
+    memory_system_configuration memory_config = {};
+    memory_config.total_alloc_size = 4 * 1024 * 1024;
+    initialize_memory(&memory_system_requirement, 0, memory_config);
+    void* memory_state = kallocate(memory_system_requirement, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(initialize_memory(&memory_system_requirement, memory_state, memory_config));
+#if KMEMORY_TRACKING
+    u64 errors = memory_tracking_error_count();
+#endif
+
+    u64 memory_requirement = 0;
+    void* state = initialize_job_system(TEST_WORKER_COUNT, &memory_requirement);
+    expect_should_not_be(0, state);
+
+    katomic_u32 corrupted_blocks;
+    katomic_init(&corrupted_blocks, 0);
+    allocating_params params[TEST_ALLOCATING_JOB_COUNT];
+    job_info jobs[TEST_ALLOCATING_JOB_COUNT];
+    job_counter counter = {};
+    for (u32 i = 0; i < TEST_ALLOCATING_JOB_COUNT; ++i) {
+        params[i].pattern = (u8)i;
+        params[i].corrupted_blocks = &corrupted_blocks;
+        jobs[i] = job_create(allocating_job, &params[i], JOB_PRIORITY_HIGH, &counter);
+    }
+    job_system_submit(jobs, TEST_ALLOCATING_JOB_COUNT);
+    job_system_wait(&counter);
+
+    expect_should_be(0, katomic_load(&corrupted_blocks, KATOMIC_RELAXED));
+#if KMEMORY_TRACKING
+    expect_should_be(errors, memory_tracking_error_count());
+#endif
+
+    shutdown_job_system(state, memory_requirement);
+    shutdown_memory(memory_state);
+    kfree(memory_state, memory_system_requirement, MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+u8 job_system_runs_inline_when_stopped() {
+    expect_should_be(1, job_system_thread_count());
+
+    katomic_u32 total;
+    katomic_init(&total, 0);
+    job_counter counter = {};
+    job_info job = job_create(increment_job, &total, JOB_PRIORITY_NORMAL, &counter);
+    job_system_submit(&job, 1);
+
+    // Already done by the time submit returns.
+    expect_should_be(1, katomic_load(&total, KATOMIC_RELAXED));
+    expect_should_be(0, katomic_load(&counter.remaining, KATOMIC_RELAXED));
+    job_system_wait(&counter);
+    return true;
+}
+
+// Reports rather than asserts, since timings depend on the machine.
+u8 job_system_benchmark_throughput() {
+    u64 memory_requirement = 0;
+    void* state = initialize_job_system(TEST_WORKER_COUNT, &memory_requirement);
+    expect_should_not_be(0, state);
+
+    job_info jobs[BENCHMARK_BATCH_SIZE];
+    job_counter counter = {};
+    for (u32 i = 0; i < BENCHMARK_BATCH_SIZE; ++i) {
+        jobs[i] = job_create(empty_job, 0, JOB_PRIORITY_NORMAL, &counter);
+    }
+
+    f64 start = platform_get_absolute_time();
+    for (u32 submitted = 0; submitted < BENCHMARK_JOB_COUNT; submitted += BENCHMARK_BATCH_SIZE) {
+        job_system_submit(jobs, BENCHMARK_BATCH_SIZE);
+    }
+    job_system_wait(&counter);
+    f64 elapsed = platform_get_absolute_time() - start;
+
+    KINFO("Job throughput: %u empty jobs on %u threads in %.2f ms, %.1f ns per job, %.2f million jobs/s",
+          BENCHMARK_JOB_COUNT, job_system_thread_count(), elapsed * 1000.0, elapsed * 1000000000.0 / BENCHMARK_JOB_COUNT,
+          BENCHMARK_JOB_COUNT / elapsed / 1000000.0);
+
+    shutdown_job_system(state, memory_requirement);
+    return true;
+}
+
+// Time from submit until a worker starts the job. The submitting thread spins on the counter
+// instead of waiting, so it never runs the job itself.
+static void measure_latency(const char* label, u64 sleep_ms) {
+    f64 total = 0.0;
+    f64 worst = 0.0;
+    for (u32 i = 0; i < BENCHMARK_LATENCY_SAMPLES; ++i) {
+        if (sleep_ms) {
+            // Long enough for every worker to have gone to sleep.
+            platform_sleep(sleep_ms);
+        }
+        latency_params params = {};
+        job_counter counter = {};
+        job_info job = job_create(record_start_job, &params, JOB_PRIORITY_HIGH, &counter);
+
+        f64 submit_time = platform_get_absolute_time();
+        job_system_submit(&job, 1);
+        while (katomic_load(&counter.remaining, KATOMIC_ACQUIRE) > 0) {
+            katomic_pause();
+        }
+
+        f64 latency = params.start_time - submit_time;
+        total += latency;
+        if (latency > worst) {
+            worst = latency;
+        }
+    }
+    KINFO("Job latency (%s): average %.2f us, worst %.2f us over %u jobs",
+          label, total * 1000000.0 / BENCHMARK_LATENCY_SAMPLES, worst * 1000000.0, BENCHMARK_LATENCY_SAMPLES);
+}
+
+u8 job_system_benchmark_latency() {
+    u64 memory_requirement = 0;
+    void* state = initialize_job_system(TEST_WORKER_COUNT, &memory_requirement);
+    expect_should_not_be(0, state);
+
+    measure_latency("back to back", 0);
+    measure_latency("after 1 ms idle", 1);
+
+    shutdown_job_system(state, memory_requirement);
+    return true;
+}
+
+void job_system_register_tests() {
+    test_manager_register_test(job_system_runs_every_job, "Job system runs every submitted job before the counter reaches zero");
+    test_manager_register_test(job_system_runs_nested_jobs, "Job system runs jobs submitted and waited on from inside jobs");
+    test_manager_register_test(job_system_jobs_can_allocate, "Job system jobs can allocate from a shared memory budget");
+    test_manager_register_test(job_system_runs_inline_when_stopped, "Job system runs jobs inline when it isn't running");
+    test_manager_register_test(job_system_benchmark_throughput, "Job system throughput benchmark");
+    test_manager_register_test(job_system_benchmark_latency, "Job system latency benchmark");
+}
@@ -0,0 +1,255 @@
+#include "task_graph_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+#include "../test_fixtures.h"
+
+#include <defines.h>
+
+#include <core/katomic.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/logger.h>
+#include <platform/platform.h>
+#include <systems/job_system.h>
+#include <systems/task_graph.h>
+
+#define TEST_WORKER_COUNT 3
+#define TEST_EXECUTE_COUNT 100
+#define TEST_PARALLEL_TASK_COUNT 4
+
+typedef struct test_task {
+    // Shared by every task in a test. Stamps where each run started and ended relative to the others.
+    katomic_u32* clock;
+    u32 start;
+    u32 end;
+    u32 sleep_ms;
+    b8 fail;
+    u32 runs;
+} test_task;
+
+static b8 record_task(void* user_data) {
+    test_task* task = user_data;
+    task->start = katomic_fetch_add(task->clock, 1, KATOMIC_RELAXED);
+    if (task->sleep_ms > 0) {
+        platform_sleep(task->sleep_ms);
+    }
+    task->end = katomic_fetch_add(task->clock, 1, KATOMIC_RELAXED);
+    task->runs++;
+    return !task->fail;
+}
+
+static b8 add_task(task_graph* graph, const char* name, test_task* task, u32 read_count, const u32* reads, u32 write_count, const u32* writes) {
+    task_desc desc = {};
+    desc.name = name;
+    desc.run = record_task;
+    desc.user_data = task;
+    desc.read_count = read_count;
+    desc.reads = reads;
+    desc.write_count = write_count;
+    desc.writes = writes;
+    return task_graph_add_task(graph, &desc, 0);
+}
+
+// update writes state; render and audio read it, render also writing draw data; draw reads that;
+// next_update writes state again, so must wait for both readers.
+static u8 run_ordering_test() {
+    katomic_u32 clock;
+    katomic_init(&clock, 0);
+    test_task tasks[5] = {};
+    for (u32 i = 0; i < 5; ++i) {
+        tasks[i].clock = &clock;
+    }
+
+    task_graph graph;
+    expect_to_be_true(task_graph_create(&graph));
+    u32 state = task_graph_resource(&graph, "state");
+    u32 draw_data = task_graph_resource(&graph, "draw_data");
+    expect_should_be(state, task_graph_resource(&graph, "state"));
+
+    expect_to_be_true(add_task(&graph, "update", &tasks[0], 0, 0, 1, &state));
+    expect_to_be_true(add_task(&graph, "render", &tasks[1], 1, &state, 1, &draw_data));
+    expect_to_be_true(add_task(&graph, "audio", &tasks[2], 1, &state, 0, 0));
+    expect_to_be_true(add_task(&graph, "draw", &tasks[3], 1, &draw_data, 0, 0));
+    expect_to_be_true(add_task(&graph, "next_update", &tasks[4], 0, 0, 1, &state));
+
+    for (u32 i = 0; i < TEST_EXECUTE_COUNT; ++i) {
+        expect_to_be_true(task_graph_execute(&graph));
+        expect_to_be_true((tasks[0].end < tasks[1].start));
+        expect_to_be_true((tasks[0].end < tasks[2].start));
+        expect_to_be_true((tasks[1].end < tasks[3].start));
+        expect_to_be_true((tasks[1].end < tasks[4].start));
+        expect_to_be_true((tasks[2].end < tasks[4].start));
+    }
+    for (u32 i = 0; i < 5; ++i) {
+        expect_should_be(TEST_EXECUTE_COUNT, tasks[i].runs);
+    }
+
+    task_graph_destroy(&graph);
+    expect_should_be(0, graph.internal_data);
+    return true;
+}
+
+u8 task_graph_orders_dependent_tasks() {
+    u64 memory_requirement = 0;
+    void* state = initialize_job_system(TEST_WORKER_COUNT, &memory_requirement);
+    expect_should_not_be(0, state);
+
+    u8 result = run_ordering_test();
+
+    shutdown_job_system(state, memory_requirement);
+    return result;
+}
+
+u8 task_graph_orders_dependent_tasks_inline() {
+    expect_should_be(1, job_system_thread_count());
+    return run_ordering_test();
+}
+
+u8 task_graph_runs_independent_tasks_in_parallel() {
+    u64 memory_requirement = 0;
+    void* state = initialize_job_system(TEST_WORKER_COUNT, &memory_requirement);
+    expect_should_not_be(0, state);
+
+    katomic_u32 clock;
+    katomic_init(&clock, 0);
+    test_task tasks[TEST_PARALLEL_TASK_COUNT] = {};
+    task_graph graph;
+    expect_to_be_true(task_graph_create(&graph));
+    for (u32 i = 0; i < TEST_PARALLEL_TASK_COUNT; ++i) {
+        tasks[i].clock = &clock;
+        tasks[i].sleep_ms = 20;
+        char name[16];
+        string_format(name, "task_%u", i);
+        u32 resource = task_graph_resource(&graph, name);
+        expect_to_be_true(add_task(&graph, name, &tasks[i], 0, 0, 1, &resource));
+    }
+
+    expect_to_be_true(task_graph_execute(&graph));
+
+    // Some pair of tasks must have been running at the same time.
+    b8 overlapped = false;
+    for (u32 i = 0; i < TEST_PARALLEL_TASK_COUNT; ++i) {
+        for (u32 j = i + 1; j < TEST_PARALLEL_TASK_COUNT; ++j) {
+            if (tasks[i].start < tasks[j].end && tasks[j].start < tasks[i].end) {
+                overlapped = true;
+            }
+        }
+    }
+    expect_to_be_true(overlapped);
+
+    u32 path_count = 0;
+    task_graph_critical_path(&graph, &path_count, 0);
+    expect_should_be(1, path_count);
+
+    task_graph_destroy(&graph);
+    shutdown_job_system(state, memory_requirement);
+    return true;
+}
+
+u8 task_graph_skips_dependents_of_failed_tasks() {
+    u64 memory_requirement = 0;
+    void* state = initialize_job_system(TEST_WORKER_COUNT, &memory_requirement);
+    expect_should_not_be(0, state);
+
+    katomic_u32 clock;
+    katomic_init(&clock, 0);
+    test_task tasks[4] = {};
+    for (u32 i = 0; i < 4; ++i) {
+        tasks[i].clock = &clock;
+    }
+    tasks[0].fail = true;
+
+    task_graph graph;
+    expect_to_be_true(task_graph_create(&graph));
+    u32 a = task_graph_resource(&graph, "a");
+    u32 b = task_graph_resource(&graph, "b");
+    u32 c = task_graph_resource(&graph, "c");
+    expect_to_be_true(add_task(&graph, "fails", &tasks[0], 0, 0, 1, &a));
+    expect_to_be_true(add_task(&graph, "reads_a", &tasks[1], 1, &a, 1, &c));
+    expect_to_be_true(add_task(&graph, "reads_c", &tasks[2], 1, &c, 0, 0));
+    expect_to_be_true(add_task(&graph, "independent", &tasks[3], 0, 0, 1, &b));
+
+    u32 unknown = 42;
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(false, add_task(&graph, "unknown", &tasks[3], 1, &unknown, 0, 0));
+
+    KDEBUG("Note: The following error is intentionally caused by this test.");
+    expect_should_be(false, task_graph_execute(&graph));
+    expect_should_be(1, tasks[0].runs);
+    expect_should_be(0, tasks[1].runs);
+    expect_should_be(0, tasks[2].runs);
+    expect_should_be(1, tasks[3].runs);
+
+    // Skips only last for the execution which failed.
+    tasks[0].fail = false;
+    expect_to_be_true(task_graph_execute(&graph));
+    expect_should_be(1, tasks[1].runs);
+    expect_should_be(1, tasks[2].runs);
+
+    task_graph_destroy(&graph);
+    shutdown_job_system(state, memory_requirement);
+    return true;
+}
+
+u8 task_graph_reports_critical_path() {
+    u64 memory_requirement = 0;
+    void* state = initialize_job_system(TEST_WORKER_COUNT, &memory_requirement);
+    expect_should_not_be(0, state);
+
+    katomic_u32 clock;
+    katomic_init(&clock, 0);
+    test_task tasks[3] = {};
+    for (u32 i = 0; i < 3; ++i) {
+        tasks[i].clock = &clock;
+    }
+    tasks[0].sleep_ms = 20;
+    tasks[1].sleep_ms = 20;
+    tasks[2].sleep_ms = 1;
+
+    task_graph graph;
+    expect_to_be_true(task_graph_create(&graph));
+    u32 a = task_graph_resource(&graph, "a");
+    u32 b = task_graph_resource(&graph, "b");
+    u32 first_id = 0;
+    u32 second_id = 0;
+    task_desc desc = {};
+    desc.run = record_task;
+    desc.name = "first";
+    desc.user_data = &tasks[0];
+    desc.write_count = 1;
+    desc.writes = &a;
+    expect_to_be_true(task_graph_add_task(&graph, &desc, &first_id));
+    expect_to_be_true(add_task(&graph, "short", &tasks[2], 0, 0, 1, &b));
+    desc.name = "second";
+    desc.user_data = &tasks[1];
+    desc.write_count = 0;
+    desc.read_count = 1;
+    desc.reads = &a;
+    expect_to_be_true(task_graph_add_task(&graph, &desc, &second_id));
+
+    expect_to_be_true(task_graph_execute(&graph));
+
+    u32 path_count = 0;
+    task_graph_critical_path(&graph, &path_count, 0);
+    expect_should_be(2, path_count);
+    u32 path[2];
+    f64 path_time = task_graph_critical_path(&graph, &path_count, path);
+    expect_should_be(first_id, path[0]);
+    expect_should_be(second_id, path[1]);
+    expect_to_be_true(string_equal("second", task_graph_task_name(&graph, path[1])));
+    expect_to_be_true((path_time >= 0.035));
+    f64 task_times = task_graph_task_time(&graph, first_id) + task_graph_task_time(&graph, second_id);
+    expect_float_to_be(path_time, task_times);
+
+    task_graph_destroy(&graph);
+    shutdown_job_system(state, memory_requirement);
+    return true;
+}
+
+void task_graph_register_tests() {
+    test_manager_register_test(task_graph_orders_dependent_tasks, "Task graph runs readers after writers and writers after readers");
+    test_manager_register_test(task_graph_orders_dependent_tasks_inline, "Task graph keeps its order without a job system");
+    test_manager_register_test(task_graph_runs_independent_tasks_in_parallel, "Task graph runs independent tasks in parallel");
+    test_manager_register_test(task_graph_skips_dependents_of_failed_tasks, "Task graph skips the dependents of a failed task");
+    test_manager_register_test(task_graph_reports_critical_path, "Task graph reports the longest chain of dependent tasks");
+}
@@ -0,0 +1,41 @@
+#include "test_fixtures.h"
+
+#include <core/kmemory.h>
+#include <memory/frame_allocator.h>
+#include <systems/job_system.h>
+
+void* initialize_job_system(u32 worker_count, u64* out_memory_requirement) {
+    job_system_config config = {};
+    config.worker_count = worker_count;
+    job_system_initialize(out_memory_requirement, 0, config);
+    void* state = kallocate(*out_memory_requirement, MEMORY_TAG_JOB);
+    if (!job_system_initialize(out_memory_requirement, state, config)) {
+        kfree(state, *out_memory_requirement, MEMORY_TAG_JOB);
+        return 0;
+    }
+    return state;
+}
+
+void shutdown_job_system(void* state, u64 memory_requirement) {
+    job_system_shutdown(state);
+    kfree(state, memory_requirement, MEMORY_TAG_JOB);
+}
+
+void* initialize_frame_allocator(u64 frame_size, u64* out_memory_requirement) {
+    frame_allocator_initialize(out_memory_requirement, 0, frame_size);
+    void* state = kallocate(*out_memory_requirement, MEMORY_TAG_APPLICATION);
+    frame_allocator_initialize(out_memory_requirement, state, frame_size);
+    return state;
+}
+
+void shutdown_frame_allocator(void* state, u64 memory_requirement) {
+    frame_allocator_shutdown(state);
+    kfree(state, memory_requirement, MEMORY_TAG_APPLICATION);
+}
+
+void* create_dynamic_allocator(u64 total_size, u64* out_memory_requirement, dynamic_allocator* out_allocator) {
+    dynamic_allocator_create(total_size, out_memory_requirement, 0, 0);
+    void* memory = kallocate(*out_memory_requirement, MEMORY_TAG_APPLICATION);
+    dynamic_allocator_create(total_size, out_memory_requirement, memory, out_allocator);
+    return memory;
+}
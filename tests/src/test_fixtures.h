@@ -0,0 +1,16 @@
+#pragma once
+
+#include <defines.h>
+
+#include <memory/dynamic_allocator.h>
+
+// Setup and teardown shared by tests of systems which take their state as a caller-owned block.
+
+void* initialize_job_system(u32 worker_count, u64* out_memory_requirement);
+void shutdown_job_system(void* state, u64 memory_requirement);
+
+void* initialize_frame_allocator(u64 frame_size, u64* out_memory_requirement);
+void shutdown_frame_allocator(void* state, u64 memory_requirement);
+
+// Returns the block backing the allocator, which must be freed with kfree after destroying it.
+void* create_dynamic_allocator(u64 total_size, u64* out_memory_requirement, dynamic_allocator* out_allocator);